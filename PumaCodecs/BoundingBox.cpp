@@ -0,0 +1,196 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BoundingBox.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define BOUNDING_BOX_SSE2
+#endif
+
+namespace {
+
+using Point2 = std::array<double, 2>;
+
+double cross(const Point2& o, const Point2& a, const Point2& b) {
+	return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+}
+
+/**
+ * Andrew's monotone chain, the hull is counter-clockwise without collinear points. Sorts the points.
+ */
+void computeConvexHull(std::vector<Point2>& points, std::vector<Point2>& hull) {
+	hull.clear();
+	std::sort(points.begin(), points.end());
+	points.erase(std::unique(points.begin(), points.end()), points.end());
+	if (points.size() < 3) {
+		hull = points;
+		return;
+	}
+
+	hull.resize(2 * points.size());
+	size_t k = 0;
+	for (size_t i = 0; i < points.size(); i++) { // lower hull
+		while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0)
+			k--;
+		hull[k++] = points[i];
+	}
+	for (size_t i = points.size() - 1, lower = k + 1; i > 0; i--) { // upper hull
+		while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0)
+			k--;
+		hull[k++] = points[i - 1];
+	}
+	hull.resize(k - 1); // the last point is the first one
+}
+
+} // namespace
+
+namespace BoundingBox {
+
+void extend(Bounds& bounds, const double* vertexCoords, size_t vertexCount) {
+	size_t vi = 0;
+
+#ifdef BOUNDING_BOX_SSE2
+	if (vertexCount >= 2) {
+		// two vertices are three registers: (x0, y0), (z0, x1), (y1, z1)
+		__m128d minA = _mm_loadu_pd(vertexCoords);
+		__m128d minB = _mm_loadu_pd(vertexCoords + 2);
+		__m128d minC = _mm_loadu_pd(vertexCoords + 4);
+		__m128d maxA = minA;
+		__m128d maxB = minB;
+		__m128d maxC = minC;
+		for (vi = 2; vi + 2 <= vertexCount; vi += 2) {
+			const double* v = vertexCoords + 3 * vi;
+			const __m128d a = _mm_loadu_pd(v);
+			const __m128d b = _mm_loadu_pd(v + 2);
+			const __m128d c = _mm_loadu_pd(v + 4);
+			minA = _mm_min_pd(minA, a);
+			minB = _mm_min_pd(minB, b);
+			minC = _mm_min_pd(minC, c);
+			maxA = _mm_max_pd(maxA, a);
+			maxB = _mm_max_pd(maxB, b);
+			maxC = _mm_max_pd(maxC, c);
+		}
+
+		// stored back to back the registers hold the xyz of two vertices again
+		std::array<double, 6> mins;
+		std::array<double, 6> maxs;
+		_mm_storeu_pd(mins.data(), minA);
+		_mm_storeu_pd(mins.data() + 2, minB);
+		_mm_storeu_pd(mins.data() + 4, minC);
+		_mm_storeu_pd(maxs.data(), maxA);
+		_mm_storeu_pd(maxs.data() + 2, maxB);
+		_mm_storeu_pd(maxs.data() + 4, maxC);
+		for (size_t k = 0; k < 3; k++) {
+			bounds.min[k] = std::min({bounds.min[k], mins[k], mins[3 + k]});
+			bounds.max[k] = std::max({bounds.max[k], maxs[k], maxs[3 + k]});
+		}
+	}
+#endif
+
+	for (; vi < vertexCount; vi++) {
+		for (size_t k = 0; k < 3; k++) {
+			bounds.min[k] = std::min(bounds.min[k], vertexCoords[3 * vi + k]);
+			bounds.max[k] = std::max(bounds.max[k], vertexCoords[3 * vi + k]);
+		}
+	}
+}
+
+Corners getCorners(const Bounds& bounds) {
+	Corners corners;
+	for (size_t i = 0; i < 8; i++) {
+		corners[3 * i + 0] = (i & 1) ? bounds.max[0] : bounds.min[0];
+		corners[3 * i + 1] = (i & 2) ? bounds.max[1] : bounds.min[1];
+		corners[3 * i + 2] = (i & 4) ? bounds.max[2] : bounds.min[2];
+	}
+	return corners;
+}
+
+void OrientedBoxBuilder::clear() {
+	mBounds = Bounds();
+	mFootprint.clear();
+}
+
+void OrientedBoxBuilder::add(const double* vertexCoords, size_t vertexCount) {
+	extend(mBounds, vertexCoords, vertexCount);
+	for (size_t vi = 0; vi < vertexCount; vi++)
+		mFootprint.push_back({vertexCoords[3 * vi], vertexCoords[3 * vi + 2]});
+}
+
+bool OrientedBoxBuilder::build(Corners& corners) {
+	if (mBounds.isEmpty())
+		return false;
+
+	computeConvexHull(mFootprint, mHull);
+	if (mHull.size() < 2) {
+		corners = getCorners(mBounds);
+		return true;
+	}
+
+	// one side of the minimum area rectangle lies on a hull edge, the edges are tried one by one
+	const Point2& origin = mHull.front(); // keeps the projections small
+	double bestArea = std::numeric_limits<double>::max();
+	Point2 bestU = {1.0, 0.0};
+	std::array<double, 4> bestRange{}; // along u and w: min, max, min, max
+	for (size_t i = 0; i < mHull.size(); i++) {
+		const Point2& p = mHull[i];
+		const Point2& q = mHull[(i + 1) % mHull.size()];
+		const double length = std::hypot(q[0] - p[0], q[1] - p[1]);
+		if (length <= 0.0)
+			continue;
+		const Point2 u = {(q[0] - p[0]) / length, (q[1] - p[1]) / length};
+		const Point2 w = {-u[1], u[0]};
+
+		std::array<double, 4> range = {std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+		                               std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+		for (const Point2& h : mHull) {
+			const double dx = h[0] - origin[0];
+			const double dz = h[1] - origin[1];
+			const double a = dx * u[0] + dz * u[1];
+			const double b = dx * w[0] + dz * w[1];
+			range[0] = std::min(range[0], a);
+			range[1] = std::max(range[1], a);
+			range[2] = std::min(range[2], b);
+			range[3] = std::max(range[3], b);
+		}
+
+		const double area = (range[1] - range[0]) * (range[3] - range[2]);
+		if (area < bestArea) {
+			bestArea = area;
+			bestU = u;
+			bestRange = range;
+		}
+	}
+
+	// box axes: u, y and w = u x y, in the corner order of getCorners
+	const Point2 w = {-bestU[1], bestU[0]};
+	for (size_t i = 0; i < 8; i++) {
+		const double a = (i & 1) ? bestRange[1] : bestRange[0];
+		const double b = (i & 4) ? bestRange[3] : bestRange[2];
+		corners[3 * i + 0] = origin[0] + a * bestU[0] + b * w[0];
+		corners[3 * i + 1] = (i & 2) ? mBounds.max[1] : mBounds.min[1];
+		corners[3 * i + 2] = origin[1] + a * bestU[1] + b * w[1];
+	}
+	return true;
+}
+
+} // namespace BoundingBox
@@ -0,0 +1,84 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace BoundingBox {
+
+/**
+ * Axis-aligned bounds, empty until the first vertex has been added.
+ */
+struct Bounds {
+	std::array<double, 3> min = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+	                             std::numeric_limits<double>::max()};
+	std::array<double, 3> max = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(),
+	                             std::numeric_limits<double>::lowest()};
+
+	bool isEmpty() const {
+		return min[0] > max[0];
+	}
+};
+
+/**
+ * Extends the bounds by xyz vertex coordinates. The min/max kernel processes two vertices per iteration with SSE2.
+ */
+void extend(Bounds& bounds, const double* vertexCoords, size_t vertexCount);
+
+/**
+ * The 8 corners of a box as xyz coordinates. Corner i lies on the max side of the first, second and third box axis if
+ * bit 0, 1 and 2 of i is set.
+ */
+using Corners = std::array<double, 24>;
+
+/**
+ * The 6 faces of a box as quads of corner indices, counter-clockwise seen from the outside.
+ */
+constexpr std::array<uint32_t, 24> FACE_CORNERS = {0, 4, 6, 2, 1, 3, 7, 5, 0, 1, 5, 4,
+                                                   2, 6, 7, 3, 0, 2, 3, 1, 4, 5, 7, 6};
+
+Corners getCorners(const Bounds& bounds);
+
+/**
+ * Box with the smallest footprint which is only rotated about the vertical (y) axis, i.e. the minimum area rectangle
+ * of the footprint extruded over the height of the vertices. Suits buildings, whose walls are rarely axis-aligned. The
+ * buffers are reused across boxes.
+ */
+class OrientedBoxBuilder {
+public:
+	void clear();
+	void add(const double* vertexCoords, size_t vertexCount);
+
+	/**
+	 * @return false if no vertices have been added.
+	 */
+	bool build(Corners& corners);
+
+private:
+	Bounds mBounds;
+	std::vector<std::array<double, 2>> mFootprint; // (x, z) of the vertices
+	std::vector<std::array<double, 2>> mHull;
+};
+
+} // namespace BoundingBox
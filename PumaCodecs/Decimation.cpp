@@ -0,0 +1,264 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Decimation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using Quadric = std::array<double, 10>;
+
+uint64_t packEdge(uint32_t a, uint32_t b) {
+	return (a < b) ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+std::array<double, 3> getNormal(const double* a, const double* b, const double* c) {
+	const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+	return {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+}
+
+double dot(const std::array<double, 3>& a, const std::array<double, 3>& b) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/**
+ * Adds the squared distance to the plane n * p + d = 0, with n of unit length.
+ */
+void addPlane(Quadric& q, const std::array<double, 3>& n, double d) {
+	q[0] += n[0] * n[0];
+	q[1] += n[0] * n[1];
+	q[2] += n[0] * n[2];
+	q[3] += n[0] * d;
+	q[4] += n[1] * n[1];
+	q[5] += n[1] * n[2];
+	q[6] += n[1] * d;
+	q[7] += n[2] * n[2];
+	q[8] += n[2] * d;
+	q[9] += d * d;
+}
+
+double evaluate(const Quadric& q, const double* p) {
+	const double x = p[0];
+	const double y = p[1];
+	const double z = p[2];
+	const double error = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x + q[4] * y * y +
+	                     2.0 * q[5] * y * z + 2.0 * q[6] * y + q[7] * z * z + 2.0 * q[8] * z + q[9];
+	return std::max(error, 0.0); // rounding
+}
+
+} // namespace
+
+namespace Decimation {
+
+void MeshDecimator::decimate(const double* vertexCoords, size_t vertexCount, std::vector<uint32_t>& triangles,
+                             size_t targetTriangleCount, double maxError) {
+	const auto start = std::chrono::steady_clock::now();
+	mInputTriangleCount += triangles.size() / 3;
+
+	// the quadric of a vertex measures the distance to the planes of its triangles
+	mQuadrics.assign(vertexCount, Quadric{});
+	for (size_t ti = 0; ti + 2 < triangles.size(); ti += 3) {
+		const double* a = vertexCoords + 3 * static_cast<size_t>(triangles[ti]);
+		const double* b = vertexCoords + 3 * static_cast<size_t>(triangles[ti + 1]);
+		const double* c = vertexCoords + 3 * static_cast<size_t>(triangles[ti + 2]);
+		std::array<double, 3> n = getNormal(a, b, c);
+		const double length = std::sqrt(dot(n, n));
+		if (length <= 0.0)
+			continue;
+		n = {n[0] / length, n[1] / length, n[2] / length};
+		const double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+		for (size_t k = 0; k < 3; k++)
+			addPlane(mQuadrics[triangles[ti + k]], n, d);
+	}
+
+	// edges without exactly two triangles are borders: material boundaries, seams or holes
+	mEdges.clear();
+	for (size_t ti = 0; ti + 2 < triangles.size(); ti += 3) {
+		for (size_t k = 0; k < 3; k++)
+			mEdges.push_back(packEdge(triangles[ti + k], triangles[ti + (k + 1) % 3]));
+	}
+	std::sort(mEdges.begin(), mEdges.end());
+	mLocked.assign(vertexCount, 0);
+	for (size_t i = 0; i < mEdges.size();) {
+		size_t end = i + 1;
+		while (end < mEdges.size() && mEdges[end] == mEdges[i])
+			end++;
+		if (end - i != 2) {
+			mLocked[mEdges[i] >> 32] = 1;
+			mLocked[mEdges[i] & 0xffffffffu] = 1;
+		}
+		i = end;
+	}
+
+	const double maxCost = (maxError > 0.0) ? maxError * maxError : std::numeric_limits<double>::max();
+	mRemap.resize(vertexCount);
+	mMarks.assign(vertexCount, 0);
+	mMark = 0;
+
+	// each pass collapses the cheapest edges whose neighborhoods do not overlap, then the triangles are rewritten
+	while (triangles.size() / 3 > targetTriangleCount) {
+		buildAdjacency(vertexCount, triangles);
+
+		mEdges.clear();
+		for (size_t ti = 0; ti + 2 < triangles.size(); ti += 3) {
+			for (size_t k = 0; k < 3; k++)
+				mEdges.push_back(packEdge(triangles[ti + k], triangles[ti + (k + 1) % 3]));
+		}
+		std::sort(mEdges.begin(), mEdges.end());
+		mEdges.erase(std::unique(mEdges.begin(), mEdges.end()), mEdges.end());
+
+		mCollapses.clear();
+		for (uint64_t edge : mEdges) {
+			const uint32_t a = static_cast<uint32_t>(edge >> 32);
+			const uint32_t b = static_cast<uint32_t>(edge & 0xffffffffu);
+			if (mLocked[a] && mLocked[b])
+				continue;
+
+			Quadric q = mQuadrics[a];
+			for (size_t k = 0; k < q.size(); k++)
+				q[k] += mQuadrics[b][k];
+			const double costAB = mLocked[a] ? std::numeric_limits<double>::max() : evaluate(q, vertexCoords + 3 * b);
+			const double costBA = mLocked[b] ? std::numeric_limits<double>::max() : evaluate(q, vertexCoords + 3 * a);
+			if (costAB <= costBA)
+				mCollapses.push_back({costAB, a, b});
+			else
+				mCollapses.push_back({costBA, b, a});
+		}
+		std::sort(mCollapses.begin(), mCollapses.end(),
+		          [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+		for (uint32_t vi = 0; vi < vertexCount; vi++)
+			mRemap[vi] = vi;
+		mTouched.assign(vertexCount, 0);
+
+		const size_t excessTriangles = triangles.size() / 3 - targetTriangleCount;
+		size_t removedTriangles = 0;
+		size_t collapseCount = 0;
+		for (const Collapse& collapse : mCollapses) {
+			if (collapse.cost > maxCost || removedTriangles >= excessTriangles)
+				break;
+			if (mTouched[collapse.from] || mTouched[collapse.to])
+				continue;
+			if (!isValidCollapse(vertexCoords, triangles, collapse.from, collapse.to))
+				continue;
+
+			mRemap[collapse.from] = collapse.to;
+			for (size_t k = 0; k < Quadric().size(); k++)
+				mQuadrics[collapse.to][k] += mQuadrics[collapse.from][k];
+
+			// the triangles around the moved vertex change, their vertices wait for the next pass
+			for (uint32_t ai = mAdjacencyOffsets[collapse.from]; ai < mAdjacencyOffsets[collapse.from + 1]; ai++) {
+				const uint32_t* triangle = &triangles[3 * static_cast<size_t>(mAdjacency[ai])];
+				const bool degenerate = triangle[0] == collapse.to || triangle[1] == collapse.to ||
+				                        triangle[2] == collapse.to;
+				if (degenerate)
+					removedTriangles++;
+				for (size_t k = 0; k < 3; k++)
+					mTouched[triangle[k]] = 1;
+			}
+			collapseCount++;
+		}
+		if (collapseCount == 0)
+			break;
+
+		size_t kept = 0;
+		for (size_t ti = 0; ti + 2 < triangles.size(); ti += 3) {
+			const uint32_t a = mRemap[triangles[ti]];
+			const uint32_t b = mRemap[triangles[ti + 1]];
+			const uint32_t c = mRemap[triangles[ti + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+			triangles[kept++] = a;
+			triangles[kept++] = b;
+			triangles[kept++] = c;
+		}
+		triangles.resize(kept);
+	}
+
+	mOutputTriangleCount += triangles.size() / 3;
+	mSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Rejects collapses which flip or squeeze a remaining triangle, or which would glue the mesh together where the two
+ * vertices have more common neighbors than the triangles of their edge (the link condition).
+ */
+bool MeshDecimator::isValidCollapse(const double* vertexCoords, const std::vector<uint32_t>& triangles, uint32_t from,
+                                    uint32_t to) {
+	const double* target = vertexCoords + 3 * static_cast<size_t>(to);
+
+	mMark++;
+	size_t edgeTriangleCount = 0;
+	for (uint32_t ai = mAdjacencyOffsets[from]; ai < mAdjacencyOffsets[from + 1]; ai++) {
+		const uint32_t* triangle = &triangles[3 * static_cast<size_t>(mAdjacency[ai])];
+		if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+			edgeTriangleCount++;
+			continue;
+		}
+
+		std::array<const double*, 3> corners;
+		std::array<const double*, 3> moved;
+		for (size_t k = 0; k < 3; k++) {
+			corners[k] = vertexCoords + 3 * static_cast<size_t>(triangle[k]);
+			moved[k] = (triangle[k] == from) ? target : corners[k];
+			if (triangle[k] != from)
+				mMarks[triangle[k]] = mMark;
+		}
+		const std::array<double, 3> before = getNormal(corners[0], corners[1], corners[2]);
+		const std::array<double, 3> after = getNormal(moved[0], moved[1], moved[2]);
+		const double beforeSquared = dot(before, before);
+		if (beforeSquared > 0.0 && dot(before, after) <= 0.25 * std::sqrt(beforeSquared * dot(after, after)))
+			return false;
+	}
+
+	size_t commonNeighbors = 0;
+	for (uint32_t ai = mAdjacencyOffsets[to]; ai < mAdjacencyOffsets[to + 1]; ai++) {
+		const uint32_t* triangle = &triangles[3 * static_cast<size_t>(mAdjacency[ai])];
+		if (triangle[0] == from || triangle[1] == from || triangle[2] == from)
+			continue;
+		for (size_t k = 0; k < 3; k++) {
+			if (triangle[k] != to && mMarks[triangle[k]] == mMark) {
+				mMarks[triangle[k]] = 0; // count each neighbor once
+				commonNeighbors++;
+			}
+		}
+	}
+	return commonNeighbors <= edgeTriangleCount;
+}
+
+void MeshDecimator::buildAdjacency(size_t vertexCount, const std::vector<uint32_t>& triangles) {
+	mAdjacencyOffsets.assign(vertexCount + 1, 0);
+	for (uint32_t vi : triangles)
+		mAdjacencyOffsets[vi + 1]++;
+	for (size_t vi = 0; vi < vertexCount; vi++)
+		mAdjacencyOffsets[vi + 1] += mAdjacencyOffsets[vi];
+
+	mAdjacency.resize(triangles.size());
+	std::vector<uint32_t>& fill = mRemap; // the remap is only set up after the adjacency
+	std::copy(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1, fill.begin());
+	for (size_t i = 0; i < triangles.size(); i++)
+		mAdjacency[fill[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+}
+
+} // namespace Decimation
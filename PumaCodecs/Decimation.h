@@ -0,0 +1,89 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Decimation {
+
+/**
+ * Quadric error decimation of indexed triangle meshes by half-edge collapses: a vertex is moved onto a neighbor, so the
+ * remaining vertices keep their normals and texture coordinates. Vertices on open or non-manifold edges are locked,
+ * which preserves the mesh borders and thereby material boundaries, texture seams and hard edges of welded meshes, as
+ * their vertices are split there. The buffers are reused across meshes.
+ */
+class MeshDecimator {
+public:
+	/**
+	 * @param vertexCoords xyz coordinates of the mesh vertices
+	 * @param vertexCount number of vertices
+	 * @param [in,out] triangles 3 vertex indices per triangle, receives the remaining triangles
+	 * @param targetTriangleCount collapses stop once no more than this many triangles are left
+	 * @param maxError collapses stop before the first one whose error exceeds this distance, 0 for no bound. The error
+	 * is the root of the summed squared distances of the moved vertex to the planes of the triangles it replaces.
+	 */
+	void decimate(const double* vertexCoords, size_t vertexCount, std::vector<uint32_t>& triangles,
+	              size_t targetTriangleCount, double maxError);
+
+	size_t getInputTriangleCount() const {
+		return mInputTriangleCount;
+	}
+
+	size_t getOutputTriangleCount() const {
+		return mOutputTriangleCount;
+	}
+
+	double getSeconds() const {
+		return mSeconds;
+	}
+
+private:
+	using Quadric = std::array<double, 10>; // symmetric 4x4: xx, xy, xz, xw, yy, yz, yw, zz, zw, ww
+
+	struct Collapse {
+		double cost;
+		uint32_t from;
+		uint32_t to;
+	};
+
+	bool isValidCollapse(const double* vertexCoords, const std::vector<uint32_t>& triangles, uint32_t from,
+	                     uint32_t to);
+	void buildAdjacency(size_t vertexCount, const std::vector<uint32_t>& triangles);
+
+	std::vector<Quadric> mQuadrics;
+	std::vector<uint8_t> mLocked;
+	std::vector<uint8_t> mTouched; // vertices whose neighborhood changed in the current pass
+	std::vector<uint32_t> mRemap;
+	std::vector<uint64_t> mEdges;
+	std::vector<Collapse> mCollapses;
+	std::vector<uint32_t> mAdjacencyOffsets; // triangles of each vertex
+	std::vector<uint32_t> mAdjacency;
+	std::vector<uint32_t> mMarks;
+	uint32_t mMark = 0;
+
+	size_t mInputTriangleCount = 0;
+	size_t mOutputTriangleCount = 0;
+	double mSeconds = 0.0;
+};
+
+} // namespace Decimation
@@ -26,19 +26,94 @@ class IRhinoCallbacks : public prt::Callbacks {
 public:
 	virtual ~IRhinoCallbacks() override = default;
 
-	///< summary>
-	/// Adds a geometry and corresponding materials.
-	///</summary>
-	///< param name='faceRanges'>The range of the reports</param>
-	///< param name='faceRangeSize'>The number of ranges</param>
-	///< param name='reports'>An array of reports</param>
-	virtual void add(const size_t initialShapeIndex, const size_t instanceIndex, const double* vertexCoords,
-	                 const size_t vertexCoordsCount, const double* normals, const size_t normalsCount,
-	                 const uint32_t* faceIndices, const size_t faceIndicesCount, const uint32_t* faceCounts,
-	                 const size_t faceCountsCount, double const* const* uvs, size_t const* uvsSizes,
-	                 uint32_t const* const* uvCounts, size_t const* uvCountsSizes, uint32_t const* const* uvIndices,
-	                 size_t const* uvIndicesSizes, uint32_t uvSets, const uint32_t* faceRanges, size_t faceRangesSize,
-	                 prt::AttributeMap const* const* materials, size_t matCount) = 0;
+	/**
+	 * Number of elements of each geometry buffer of a mesh.
+	 */
+	struct MeshBufferSizes {
+		size_t vertexCoordsCount = 0;
+		size_t normalsCount = 0;
+		size_t faceIndicesCount = 0;
+		size_t faceCountsCount = 0;
+		size_t uvsCount = 0;              // floats of the first uv set, one (u, v) pair per face vertex
+		size_t uvCountsCount = 0;         // number of texture coordinates per face
+		size_t polygonTrianglesCount = 0; // (n - 2) * 3 for each face with n > 4 corners
+
+		// vertices and normals are requested in single precision, the vertices relative to the local origin
+		bool singlePrecision = false;
+
+		// welded mesh: the faces index shared vertices, the uvs hold one (u, v) pair per vertex and there are no uv
+		// counts
+		bool indexed = false;
+	};
+
+	/**
+	 * Geometry buffers owned by the callbacks. The encoder writes the mesh directly into them, the pointers are valid
+	 * until the next acquire call.
+	 */
+	struct MeshBuffers {
+		double* vertexCoords = nullptr;
+		double* normals = nullptr;
+		float* localVertexCoords = nullptr; // replaces vertexCoords in single precision mode
+		float* localNormals = nullptr;      // replaces normals in single precision mode
+		uint32_t* faceIndices = nullptr;
+		uint32_t* faceCounts = nullptr;
+		float* uvs = nullptr;
+		uint32_t* uvCounts = nullptr;
+		uint32_t* polygonTriangles = nullptr; // triangulation of the faces with more than 4 corners, see ModelPart
+	};
+
+	/**
+	 * Single precision mode: sets the origin of the initial shape's local vertices. Called before its first mesh.
+	 */
+	virtual void setLocalOrigin(const size_t initialShapeIndex, const double* origin) = 0;
+
+	/**
+	 * Adds a mesh to the model of the initial shape and returns its buffers with the requested sizes. Its materials
+	 * follow with addMaterials().
+	 */
+	virtual MeshBuffers acquireMeshBuffers(const size_t initialShapeIndex, const MeshBufferSizes& sizes) = 0;
+
+	/**
+	 * Adds the materials of the last acquired mesh.
+	 *
+	 * @param faceRanges the first face of each material, followed by the end of the faces.
+	 */
+	virtual void addMaterials(const size_t initialShapeIndex, const size_t instanceIndex, const uint32_t* faceRanges,
+	                          size_t faceRangesSize, prt::AttributeMap const* const* materials, size_t matCount) = 0;
+
+	/**
+	 * Instancing mode: adds a prototype mesh in its local coordinate system and returns its buffers. A prototype is
+	 * added once per initial shape, before its first instance.
+	 */
+	virtual MeshBuffers acquirePrototypeBuffers(const size_t initialShapeIndex, const size_t prototypeIndex,
+	                                            const MeshBufferSizes& sizes) = 0;
+
+	/**
+	 * Adds a coarser level of detail to the last acquired mesh and returns its buffers. A level only consists of
+	 * triangles: just the face indices and face counts are written, the faces index the vertices of the full detail
+	 * mesh and share them.
+	 *
+	 * @param level 1 for the first coarser level, the levels of a mesh are added in increasing order.
+	 */
+	virtual MeshBuffers acquireMeshLevelBuffers(const size_t initialShapeIndex, const size_t level,
+	                                            const MeshBufferSizes& sizes) = 0;
+
+	/**
+	 * Instancing mode: adds a coarser level of detail to a prototype, see acquireMeshLevelBuffers().
+	 */
+	virtual MeshBuffers acquirePrototypeLevelBuffers(const size_t initialShapeIndex, const size_t prototypeIndex,
+	                                                 const size_t level, const MeshBufferSizes& sizes) = 0;
+
+	/**
+	 * Instancing mode: places a previously added prototype.
+	 *
+	 * @param transformation column-major 4x4 matrix (16 values) from the prototype's local coordinate system to the
+	 * coordinate system of the initial shape.
+	 * @param materials the materials of the instance, the same prototype can be placed with different materials.
+	 */
+	virtual void addInstance(const size_t initialShapeIndex, const size_t instanceIndex, const size_t prototypeIndex,
+	                         const double* transformation, prt::AttributeMap const* const* materials,
+	                         size_t matCount) = 0;
 
 	virtual void addReport(const size_t initialShapeIndex, const prtx::PRTUtils::AttributeMapPtr reports) = 0;
 
@@ -53,4 +128,10 @@ public:
 	 */
 	virtual void addAsset(const wchar_t* uri, const wchar_t* fileName, const uint8_t* buffer, size_t size,
 	                      wchar_t* result, size_t& resultSize) = 0;
+
+	/**
+	 * Polled by the encoder while it processes an initial shape. Once true, the encoder stops and drops the geometry
+	 * of the current and all following initial shapes.
+	 */
+	virtual bool isCanceled() const = 0;
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LocalCoordinates.h"
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace LocalCoordinates {
+
+void CentroidBuilder::add(const double* vertexCoords, size_t vertexCount) {
+	for (size_t i = 0; i < 3 * vertexCount; i++)
+		mSum[i % 3] += vertexCoords[i];
+	mVertexCount += vertexCount;
+}
+
+bool CentroidBuilder::build(std::array<double, 3>& centroid) const {
+	if (mVertexCount == 0)
+		return false;
+
+	for (size_t i = 0; i < centroid.size(); i++)
+		centroid[i] = mSum[i] / static_cast<double>(mVertexCount);
+	return true;
+}
+
+float toLocalCoordinate(double coordinate, double origin) {
+	const float localOffset = static_cast<float>(coordinate - origin);
+	assert(std::abs(fromLocalCoordinate(localOffset, origin) - coordinate) <=
+	       getRoundTripErrorBound(coordinate, origin));
+	return localOffset;
+}
+
+double fromLocalCoordinate(float localCoordinate, double origin) {
+	return origin + static_cast<double>(localCoordinate);
+}
+
+double getRoundTripErrorBound(double coordinate, double origin) {
+	const double offset = std::abs(coordinate - origin);
+	return 0.5 * FLT_EPSILON * offset + FLT_MIN + DBL_EPSILON * (std::abs(coordinate) + offset);
+}
+
+} // namespace LocalCoordinates
@@ -0,0 +1,62 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace LocalCoordinates {
+
+/**
+ * Centroid of the vertices added so far. In single precision mode it is the local origin of an initial shape: the
+ * offsets from the centroid stay small and keep the float precision even far away from the world origin.
+ */
+class CentroidBuilder {
+public:
+	void add(const double* vertexCoords, size_t vertexCount);
+
+	/**
+	 * @return false if no vertices have been added.
+	 */
+	bool build(std::array<double, 3>& centroid) const;
+
+private:
+	std::array<double, 3> mSum{};
+	size_t mVertexCount = 0;
+};
+
+/**
+ * Single precision offset of the coordinate from the origin. The rounding error is bounded by half a float ulp of the
+ * offset, i.e. it grows with the distance to the local origin and not with the distance to the world origin.
+ */
+float toLocalCoordinate(double coordinate, double origin);
+
+/**
+ * Restores the coordinate in double precision, like the conversion to Rhino meshes in PumaRhino does.
+ */
+double fromLocalCoordinate(float localCoordinate, double origin);
+
+/**
+ * Bound of the round trip error: half a float ulp of the offset, plus the double roundings of the subtraction and the
+ * addition.
+ */
+double getRoundTripErrorBound(double coordinate, double origin);
+
+} // namespace LocalCoordinates
@@ -19,7 +19,11 @@
 
 #include "RhinoEncoder.h"
 
+#include "BoundingBox.h"
+#include "Decimation.h"
+#include "LocalCoordinates.h"
 #include "TextureEncoder.h"
+#include "Triangulation.h"
 
 #include "prtx/DataBackend.h"
 #include "prtx/EncodePreparator.h"
@@ -38,8 +42,12 @@
 #include "prt/MemoryOutputCallbacks.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <set>
 
@@ -57,18 +65,45 @@ const std::wstring ENCFILE_EXT = L".txt";
 const wchar_t* EO_EMIT_REPORTS = L"emitReport";
 const wchar_t* EO_EMIT_GEOMETRY = L"emitGeometry";
 const wchar_t* EO_EMIT_MATERIALS = L"emitMaterials";
+const wchar_t* EO_EMIT_NORMALS = L"emitNormals";
+const wchar_t* EO_EMIT_UVS = L"emitUVs";
+const wchar_t* EO_INSTANCING = L"instancing";
+const wchar_t* EO_SINGLE_PRECISION = L"singlePrecision";
+const wchar_t* EO_WELD_VERTICES = L"weldVertices";
+const wchar_t* EO_WELD_TOLERANCE_POSITION = L"weldTolerancePosition";
+const wchar_t* EO_WELD_TOLERANCE_NORMAL = L"weldToleranceNormal";
+const wchar_t* EO_WELD_TOLERANCE_UV = L"weldToleranceUV";
+const wchar_t* EO_PROXY_BOXES = L"proxyBoxes";
+const wchar_t* EO_PROXY_PER_LEAF = L"proxyPerLeaf";
+const wchar_t* EO_DECIMATION_RATIO = L"decimationRatio";
+const wchar_t* EO_DECIMATION_ERROR = L"decimationError";
+const wchar_t* EO_LOD_RATIOS = L"lodRatios";
+
+// values of the proxyBoxes option, any other value than none replaces the geometry by bounding boxes (axis-aligned
+// unless oriented), e.g. for quick previews
+constexpr int32_t PROXY_NONE = 0;
+constexpr int32_t PROXY_ORIENTED = 2;
+
+// approximate size of a vertex in a Rhino mesh: float and double point, float normal and texture coordinates
+constexpr size_t RHINO_MESH_VERTEX_BYTES =
+        3 * sizeof(float) + 3 * sizeof(double) + 3 * sizeof(float) + 2 * sizeof(float);
 
-const prtx::EncodePreparator::PreparationFlags ENC_PREP_FLAGS =
-        prtx::EncodePreparator::PreparationFlags()
-                .instancing(false)
-                .triangulate(false)
-                .mergeVertices(false)
-                .cleanupUVs(true)
-                .cleanupVertexNormals(true)
-                .processVertexNormals(prtx::VertexNormalProcessor::SET_MISSING_TO_FACE_NORMALS)
-                .indexSharing(prtx::EncodePreparator::PreparationFlags::INDICES_SAME_FOR_ALL_VERTEX_ATTRIBUTES)
-                .meshMerging(prtx::MeshMerging::ALL_OF_SAME_MATERIAL_AND_TYPE)
-                .processHoles(prtx::HoleProcessor::TRIANGULATE_FACES_WITH_HOLES);
+/**
+ * The normals and texture coordinates are only cleaned up and completed if they are encoded.
+ */
+prtx::EncodePreparator::PreparationFlags createPreparationFlags(bool instancing, bool normals, bool uvs) {
+	return prtx::EncodePreparator::PreparationFlags()
+	        .instancing(instancing)
+	        .triangulate(false)
+	        .mergeVertices(false)
+	        .cleanupUVs(uvs)
+	        .cleanupVertexNormals(normals)
+	        .processVertexNormals(normals ? prtx::VertexNormalProcessor::SET_MISSING_TO_FACE_NORMALS
+	                                      : prtx::VertexNormalProcessor::PASS)
+	        .indexSharing(prtx::EncodePreparator::PreparationFlags::INDICES_SAME_FOR_ALL_VERTEX_ATTRIBUTES)
+	        .meshMerging(prtx::MeshMerging::ALL_OF_SAME_MATERIAL_AND_TYPE)
+	        .processHoles(prtx::HoleProcessor::TRIANGULATE_FACES_WITH_HOLES);
+}
 
 std::vector<const wchar_t*> toPtrVec(const prtx::WStringVector& wsv) {
 	std::vector<const wchar_t*> pw(wsv.size());
@@ -77,24 +112,6 @@ std::vector<const wchar_t*> toPtrVec(const prtx::WStringVector& wsv) {
 	return pw;
 }
 
-template <typename T>
-std::pair<std::vector<const T*>, std::vector<size_t>> toPtrVec(const std::vector<std::vector<T>>& v) {
-	std::vector<const T*> pv(v.size());
-	std::vector<size_t> ps(v.size());
-	for (size_t i = 0; i < v.size(); i++) {
-		pv[i] = v[i].data();
-		ps[i] = v[i].size();
-	}
-	return std::make_pair(pv, ps);
-}
-
-std::vector<const prt::AttributeMap*> toPtrVec(const std::vector<prtx::PRTUtils::AttributeMapUPtr>& managedPtrVec) {
-	std::vector<const prt::AttributeMap*> rawPtrVec(managedPtrVec.size(), nullptr);
-	std::transform(managedPtrVec.begin(), managedPtrVec.end(), rawPtrVec.begin(),
-	               [](const auto& managed) { return managed.get(); });
-	return rawPtrVec;
-}
-
 template <typename C, typename FUNC, typename OBJ, typename... ARGS>
 std::basic_string<C> callAPI(FUNC f, OBJ& obj, ARGS&&... args) {
 	std::vector<C> buffer(1024, 0x0);
@@ -393,9 +410,6 @@ uint32_t scanValidTextures(const prtx::MaterialPtr& mat) {
 		return highestUVSet + 1;
 }
 
-const prtx::DoubleVector EMPTY_UVS;
-const prtx::IndexVector EMPTY_IDX;
-
 auto scanMeshes(const prtx::MeshPtrVector& meshes) {
 	uint32_t numCoords = 0;
 	uint32_t numNormalCoords = 0;
@@ -414,8 +428,551 @@ auto scanMeshes(const prtx::MeshPtrVector& meshes) {
 	return std::make_tuple(numCoords, numNormalCoords, numFaceCounts, numIndices);
 }
 
+/**
+ * Calls f for the meshes whose first uv set is encoded. Texture coordinates are only encoded for textured meshes,
+ * starting at the first mesh whose material references a valid texture, whether the materials are emitted or not.
+ * Rhino meshes have a single set of texture coordinates, the other uv sets are not encoded.
+ */
+template <typename F>
+void forEachTexturedMesh(const prtx::MeshPtrVector& meshes, const prtx::MaterialPtrVector& materials, F&& f) {
+	bool hasTextures = false;
+	for (size_t mi = 0; mi < meshes.size(); ++mi) {
+		const prtx::MeshPtr& mesh = meshes.at(mi);
+		if (mesh->getUVSetsCount() == 0)
+			continue;
+		if (!hasTextures)
+			hasTextures = scanValidTextures(materials.at(mi)) > 0;
+		if (hasTextures)
+			f(*mesh);
+	}
+}
+
+/**
+ * Triangles and quads are passed on to Rhino as they are, larger faces are triangulated by the encoder. The triangles
+ * are stored as corner offsets within their face, so the face keeps sharing its vertices.
+ */
+constexpr uint32_t MAX_MESH_FACE_CORNERS = 4;
+
+size_t getPolygonTrianglesCount(uint32_t cornerCount) {
+	return (cornerCount > MAX_MESH_FACE_CORNERS) ? 3 * static_cast<size_t>(cornerCount - 2) : 0;
+}
+
+/**
+ * Writes the triangles of a face into the polygon triangles buffer, returns the end of the written triangles.
+ */
+uint32_t* writePolygonTriangles(const double* vertexCoords, const uint32_t* corners, uint32_t cornerCount,
+                                uint32_t* polygonTriangles, Triangulation::PolygonTriangulator& triangulator) {
+	if (cornerCount <= MAX_MESH_FACE_CORNERS)
+		return polygonTriangles;
+	triangulator.triangulate(vertexCoords, corners, cornerCount, polygonTriangles);
+	return polygonTriangles + getPolygonTrianglesCount(cornerCount);
+}
+
+IRhinoCallbacks::MeshBufferSizes scanGeometry(const prtx::MeshPtrVector& meshes,
+                                              const prtx::MaterialPtrVector& materials, bool withNormals,
+                                              bool withUVs) {
+	const auto [numCoords, numNormalCoords, numFaceCounts, numIndices] = scanMeshes(meshes);
+
+	IRhinoCallbacks::MeshBufferSizes sizes;
+	sizes.vertexCoordsCount = numCoords;
+	sizes.normalsCount = withNormals ? numNormalCoords : 0;
+	sizes.faceCountsCount = numFaceCounts;
+	sizes.faceIndicesCount = numIndices;
+
+	for (const prtx::MeshPtr& mesh : meshes) {
+		for (uint32_t fi = 0; fi < mesh->getFaceCount(); ++fi)
+			sizes.polygonTrianglesCount += getPolygonTrianglesCount(mesh->getFaceVertexCount(fi));
+	}
+
+	if (withUVs) {
+		forEachTexturedMesh(meshes, materials, [&sizes](const prtx::Mesh& mesh) {
+			const prtx::IndexVector& faceUVCounts = mesh.getFaceUVCounts(0);
+			sizes.uvCountsCount += faceUVCounts.size();
+			sizes.uvsCount += 2 * std::accumulate(faceUVCounts.begin(), faceUVCounts.end(), size_t(0));
+		});
+	}
+	return sizes;
+}
+
+/**
+ * Centroid of the vertices which are not encoded as prototypes, false if there are none.
+ */
+bool getCentroid(const prtx::EncodePreparator::InstanceVector& instances, bool instancing,
+                 std::array<double, 3>& centroid) {
+	LocalCoordinates::CentroidBuilder centroidBuilder;
+	for (const auto& instance : instances) {
+		if (instancing && instance.getPrototypeIndex() >= 0)
+			continue;
+		for (const prtx::MeshPtr& mesh : instance.getGeometry()->getMeshes()) {
+			const prtx::DoubleVector& verts = mesh->getVertexCoords();
+			centroidBuilder.add(verts.data(), verts.size() / 3);
+		}
+	}
+	return centroidBuilder.build(centroid);
+}
+
+const prtx::DoubleVector NO_NORMALS;
+
+/**
+ * Merges the meshes of an instance into the buffers handed out by the callbacks, which have been sized by
+ * scanGeometry. The texture coordinates are written per face vertex. In single precision mode the vertices are written
+ * relative to the local origin.
+ */
+void writeGeometry(const prtx::MeshPtrVector& meshes, const prtx::MaterialPtrVector& materials, bool withNormals,
+                   bool withUVs, const IRhinoCallbacks::MeshBufferSizes& sizes,
+                   const IRhinoCallbacks::MeshBuffers& buffers, Triangulation::PolygonTriangulator& triangulator,
+                   const std::array<double, 3>& localOrigin = {}) {
+	double* vertexCoords = buffers.vertexCoords;
+	double* normals = buffers.normals;
+	float* localVertexCoords = buffers.localVertexCoords;
+	float* localNormals = buffers.localNormals;
+	uint32_t* faceIndices = buffers.faceIndices;
+	uint32_t* faceCounts = buffers.faceCounts;
+	uint32_t* polygonTriangles = buffers.polygonTriangles;
+
+	uint32_t vertexIndexBase = 0;
+	for (const prtx::MeshPtr& mesh : meshes) {
+		const prtx::DoubleVector& verts = mesh->getVertexCoords();
+		const prtx::DoubleVector& norms = withNormals ? mesh->getVertexNormalsCoords() : NO_NORMALS;
+		if (sizes.singlePrecision) {
+			for (size_t i = 0; i < verts.size(); i++)
+				*localVertexCoords++ = LocalCoordinates::toLocalCoordinate(verts[i], localOrigin[i % 3]);
+			localNormals = std::transform(norms.begin(), norms.end(), localNormals,
+			                              [](double n) { return static_cast<float>(n); });
+		}
+		else {
+			vertexCoords = std::copy(verts.begin(), verts.end(), vertexCoords);
+			normals = std::copy(norms.begin(), norms.end(), normals);
+		}
+
+		for (uint32_t fi = 0; fi < mesh->getFaceCount(); ++fi) {
+			const uint32_t* vtxIdx = mesh->getFaceVertexIndices(fi);
+			const uint32_t vtxCnt = mesh->getFaceVertexCount(fi);
+			*faceCounts++ = vtxCnt;
+
+			for (uint32_t vi = 0; vi < vtxCnt; vi++)
+				*faceIndices++ = vtxIdx[vi] + vertexIndexBase;
+			polygonTriangles = writePolygonTriangles(verts.data(), vtxIdx, vtxCnt, polygonTriangles, triangulator);
+		}
+		vertexIndexBase += static_cast<uint32_t>(verts.size()) / 3;
+	}
+
+	assert(sizes.singlePrecision || vertexCoords == buffers.vertexCoords + sizes.vertexCoordsCount);
+	assert(sizes.singlePrecision || normals == buffers.normals + sizes.normalsCount);
+	assert(!sizes.singlePrecision || localVertexCoords == buffers.localVertexCoords + sizes.vertexCoordsCount);
+	assert(!sizes.singlePrecision || localNormals == buffers.localNormals + sizes.normalsCount);
+	assert(faceIndices == buffers.faceIndices + sizes.faceIndicesCount);
+	assert(faceCounts == buffers.faceCounts + sizes.faceCountsCount);
+	assert(polygonTriangles == buffers.polygonTriangles + sizes.polygonTrianglesCount);
+
+	if (!withUVs)
+		return;
+
+	float* uvs = buffers.uvs;
+	uint32_t* uvCounts = buffers.uvCounts;
+	forEachTexturedMesh(meshes, materials, [&uvs, &uvCounts](const prtx::Mesh& mesh) {
+		const prtx::DoubleVector& meshUVs = mesh.getUVCoords(0);
+		const prtx::IndexVector& faceUVCounts = mesh.getFaceUVCounts(0);
+		assert(faceUVCounts.size() == mesh.getFaceCount());
+		uvCounts = std::copy(faceUVCounts.begin(), faceUVCounts.end(), uvCounts);
+
+		for (uint32_t fi = 0; fi < static_cast<uint32_t>(faceUVCounts.size()); ++fi) {
+			const uint32_t* faceUVIdx = mesh.getFaceUVIndices(fi, 0);
+			for (uint32_t vi = 0; vi < faceUVCounts[fi]; ++vi) {
+				*uvs++ = static_cast<float>(meshUVs[faceUVIdx[vi] * 2 + 0]);
+				*uvs++ = static_cast<float>(meshUVs[faceUVIdx[vi] * 2 + 1]);
+			}
+		}
+	});
+
+	assert(uvs == buffers.uvs + sizes.uvsCount);
+	assert(uvCounts == buffers.uvCounts + sizes.uvCountsCount);
+}
+
+/**
+ * Tolerances of the vertex welding: face corners share a vertex if their positions, normals and texture coordinates
+ * fall into the same tolerance cells. A tolerance of 0 only welds identical values.
+ */
+struct WeldTolerances {
+	double position = 0.0;
+	double normal = 0.0;
+	double uv = 0.0;
+};
+
+constexpr int64_t NO_UV = std::numeric_limits<int64_t>::min();
+
+int64_t quantize(double value, double tolerance) {
+	if (tolerance > 0.0)
+		return std::llround(value / tolerance);
+	int64_t bits = 0;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+uint64_t hashWeldKey(const WeldedGeometry::Key& key) {
+	uint64_t hash = 14695981039346656037ull; // FNV-1a over the quantized values
+	for (int64_t value : key) {
+		hash ^= static_cast<uint64_t>(value);
+		hash *= 1099511628211ull;
+	}
+	return hash ^ (hash >> 32);
+}
+
+uint32_t addWeldedVertex(WeldedGeometry& welded, const WeldTolerances& tolerances, const double* position,
+                         const double* normal, const double* uv, int64_t meshKey) {
+	WeldedGeometry::Key key;
+	for (size_t k = 0; k < 3; k++) {
+		key[k] = quantize(position[k], tolerances.position);
+		key[3 + k] = (normal != nullptr) ? quantize(normal[k], tolerances.normal) : 0;
+	}
+	key[6] = (uv != nullptr) ? quantize(uv[0], tolerances.uv) : NO_UV;
+	key[7] = (uv != nullptr) ? quantize(uv[1], tolerances.uv) : NO_UV;
+	key[8] = meshKey;
+
+	// the table has at least twice as many slots as there are face corners, the probing always finds a free slot
+	const size_t mask = welded.table.size() - 1;
+	for (size_t slot = hashWeldKey(key) & mask;; slot = (slot + 1) & mask) {
+		const uint32_t entry = welded.table[slot];
+		if (entry == 0) {
+			const uint32_t vertexIndex = static_cast<uint32_t>(welded.keys.size());
+			welded.table[slot] = vertexIndex + 1;
+			welded.keys.push_back(key);
+			welded.vertexCoords.insert(welded.vertexCoords.end(), position, position + 3);
+			if (normal != nullptr)
+				welded.normals.insert(welded.normals.end(), normal, normal + 3);
+			welded.uvs.push_back((uv != nullptr) ? static_cast<float>(uv[0]) : 0.0f);
+			welded.uvs.push_back((uv != nullptr) ? static_cast<float>(uv[1]) : 0.0f);
+			return vertexIndex;
+		}
+		if (welded.keys[entry - 1] == key)
+			return entry - 1;
+	}
+}
+
+/**
+ * Merges the meshes of an instance into indexed geometry with shared vertices. The first face corner of a tolerance
+ * cell defines the attributes of the welded vertex. Texture coordinates are selected as in writeGeometry.
+ *
+ * @param separateMeshes only weld the vertices within each mesh. The meshes then stay apart along their shared edges,
+ * which become borders the decimation does not collapse across, e.g. between meshes with different materials.
+ */
+void weldGeometry(const prtx::MeshPtrVector& meshes, const prtx::MaterialPtrVector& materials, bool withNormals,
+                  bool withUVs, const WeldTolerances& tolerances, bool separateMeshes, WeldedGeometry& welded) {
+	welded.clear();
+
+	const auto [numCoords, numNormalCoords, numFaceCounts, numIndices] = scanMeshes(meshes);
+	size_t tableSize = 16;
+	while (tableSize < 2 * static_cast<size_t>(numIndices))
+		tableSize <<= 1;
+	welded.table.assign(tableSize, 0u);
+	welded.faceCounts.reserve(numFaceCounts);
+	welded.faceIndices.reserve(numIndices);
+
+	bool hasTextures = false;
+	bool hasUVs = false;
+	for (size_t mi = 0; mi < meshes.size(); ++mi) {
+		const prtx::MeshPtr& mesh = meshes.at(mi);
+		const prtx::DoubleVector& verts = mesh->getVertexCoords();
+		const prtx::DoubleVector& norms = mesh->getVertexNormalsCoords();
+
+		const bool meshHasUVs = withUVs && mesh->getUVSetsCount() > 0;
+		if (meshHasUVs && !hasTextures)
+			hasTextures = scanValidTextures(materials.at(mi)) > 0;
+		const bool textured = meshHasUVs && hasTextures;
+		hasUVs = hasUVs || textured;
+		const prtx::DoubleVector* meshUVs = textured ? &mesh->getUVCoords(0) : nullptr;
+		const prtx::IndexVector* faceUVCounts = textured ? &mesh->getFaceUVCounts(0) : nullptr;
+		const int64_t meshKey = separateMeshes ? static_cast<int64_t>(mi) : 0;
+
+		for (uint32_t fi = 0; fi < mesh->getFaceCount(); ++fi) {
+			const uint32_t* vtxIdx = mesh->getFaceVertexIndices(fi);
+			const uint32_t vtxCnt = mesh->getFaceVertexCount(fi);
+			const bool faceHasUVs = textured && (*faceUVCounts)[fi] == vtxCnt;
+			const uint32_t* uvIdx = faceHasUVs ? mesh->getFaceUVIndices(fi, 0) : nullptr;
+			welded.faceCounts.push_back(vtxCnt);
+
+			for (uint32_t vi = 0; vi < vtxCnt; vi++) {
+				const double* normal = withNormals ? &norms[vtxIdx[vi] * 3] : nullptr;
+				const double* uv = faceHasUVs ? &(*meshUVs)[uvIdx[vi] * 2] : nullptr;
+				welded.faceIndices.push_back(
+				        addWeldedVertex(welded, tolerances, &verts[vtxIdx[vi] * 3], normal, uv, meshKey));
+			}
+		}
+	}
+
+	if (!hasUVs)
+		welded.uvs.clear();
+}
+
+IRhinoCallbacks::MeshBufferSizes getWeldedSizes(const WeldedGeometry& welded) {
+	IRhinoCallbacks::MeshBufferSizes sizes;
+	sizes.vertexCoordsCount = welded.vertexCoords.size();
+	sizes.normalsCount = welded.normals.size();
+	sizes.faceIndicesCount = welded.faceIndices.size();
+	sizes.faceCountsCount = welded.faceCounts.size();
+	sizes.uvsCount = welded.uvs.size();
+	for (uint32_t faceCount : welded.faceCounts)
+		sizes.polygonTrianglesCount += getPolygonTrianglesCount(faceCount);
+	sizes.indexed = true;
+	return sizes;
+}
+
+void writeWeldedGeometry(const WeldedGeometry& welded, const IRhinoCallbacks::MeshBufferSizes& sizes,
+                         const IRhinoCallbacks::MeshBuffers& buffers, Triangulation::PolygonTriangulator& triangulator,
+                         const std::array<double, 3>& localOrigin) {
+	if (sizes.singlePrecision) {
+		for (size_t i = 0; i < welded.vertexCoords.size(); i++)
+			buffers.localVertexCoords[i] =
+			        LocalCoordinates::toLocalCoordinate(welded.vertexCoords[i], localOrigin[i % 3]);
+		std::transform(welded.normals.begin(), welded.normals.end(), buffers.localNormals,
+		               [](double n) { return static_cast<float>(n); });
+	}
+	else {
+		std::copy(welded.vertexCoords.begin(), welded.vertexCoords.end(), buffers.vertexCoords);
+		std::copy(welded.normals.begin(), welded.normals.end(), buffers.normals);
+	}
+	std::copy(welded.faceIndices.begin(), welded.faceIndices.end(), buffers.faceIndices);
+	std::copy(welded.faceCounts.begin(), welded.faceCounts.end(), buffers.faceCounts);
+	std::copy(welded.uvs.begin(), welded.uvs.end(), buffers.uvs);
+
+	const uint32_t* corners = welded.faceIndices.data();
+	uint32_t* polygonTriangles = buffers.polygonTriangles;
+	for (uint32_t faceCount : welded.faceCounts) {
+		polygonTriangles =
+		        writePolygonTriangles(welded.vertexCoords.data(), corners, faceCount, polygonTriangles, triangulator);
+		corners += faceCount;
+	}
+	assert(polygonTriangles == buffers.polygonTriangles + sizes.polygonTrianglesCount);
+}
+
+/**
+ * Splits the welded faces into triangles of vertex indices, which keep the winding of their faces.
+ */
+void triangulateWeldedGeometry(const WeldedGeometry& welded, std::vector<uint32_t>& triangles,
+                               Triangulation::PolygonTriangulator& triangulator) {
+	triangles.clear();
+	const uint32_t* corners = welded.faceIndices.data();
+	for (uint32_t faceCount : welded.faceCounts) {
+		if (faceCount == 3 || faceCount == 4) {
+			triangles.insert(triangles.end(), {corners[0], corners[1], corners[2]});
+			if (faceCount == 4)
+				triangles.insert(triangles.end(), {corners[0], corners[2], corners[3]});
+		}
+		else if (faceCount > MAX_MESH_FACE_CORNERS) {
+			const size_t first = triangles.size();
+			triangles.resize(first + getPolygonTrianglesCount(faceCount));
+			writePolygonTriangles(welded.vertexCoords.data(), corners, faceCount, triangles.data() + first,
+			                      triangulator);
+			for (size_t i = first; i < triangles.size(); i++)
+				triangles[i] = corners[triangles[i]]; // corner offsets to vertex indices
+		}
+		corners += faceCount;
+	}
+}
+
+/**
+ * Triangulates and decimates the welded faces, see Decimation::MeshDecimator, and drops the vertices which are no
+ * longer used.
+ *
+ * @param ratio fraction of the triangles to keep
+ * @param maxError maximum error of a collapse in model units, 0 for no bound
+ */
+void decimateWeldedGeometry(WeldedGeometry& welded, double ratio, double maxError, std::vector<uint32_t>& triangles,
+                            std::vector<uint32_t>& vertexRemap, Triangulation::PolygonTriangulator& triangulator,
+                            Decimation::MeshDecimator& decimator) {
+	triangulateWeldedGeometry(welded, triangles, triangulator);
+
+	const size_t vertexCount = welded.vertexCoords.size() / 3;
+	const size_t triangleCount = triangles.size() / 3;
+	const size_t targetTriangleCount =
+	        (ratio < 1.0) ? static_cast<size_t>(std::ceil(std::max(ratio, 0.0) * static_cast<double>(triangleCount)))
+	                      : ((maxError > 0.0) ? 0 : triangleCount);
+	decimator.decimate(welded.vertexCoords.data(), vertexCount, triangles, targetTriangleCount, maxError);
+
+	// the used vertices move to the front, in their order, so that they can be compacted in place
+	constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+	vertexRemap.assign(vertexCount, UNUSED);
+	for (uint32_t vi : triangles)
+		vertexRemap[vi] = 0;
+	const bool hasNormals = !welded.normals.empty();
+	const bool hasUVs = !welded.uvs.empty();
+	uint32_t usedCount = 0;
+	for (size_t vi = 0; vi < vertexCount; vi++) {
+		if (vertexRemap[vi] == UNUSED)
+			continue;
+		vertexRemap[vi] = usedCount;
+		std::copy_n(&welded.vertexCoords[3 * vi], 3, &welded.vertexCoords[3 * usedCount]);
+		if (hasNormals)
+			std::copy_n(&welded.normals[3 * vi], 3, &welded.normals[3 * usedCount]);
+		if (hasUVs)
+			std::copy_n(&welded.uvs[2 * vi], 2, &welded.uvs[2 * usedCount]);
+		usedCount++;
+	}
+	welded.vertexCoords.resize(3 * static_cast<size_t>(usedCount));
+	if (hasNormals)
+		welded.normals.resize(3 * static_cast<size_t>(usedCount));
+	if (hasUVs)
+		welded.uvs.resize(2 * static_cast<size_t>(usedCount));
+
+	for (uint32_t& vi : triangles)
+		vi = vertexRemap[vi];
+	welded.faceIndices.swap(triangles);
+	welded.faceCounts.assign(welded.faceIndices.size() / 3, 3u);
+}
+
+/**
+ * Decimates the welded geometry into coarser levels of detail and sends their triangles. Each level is decimated from
+ * the previous one, and as half-edge collapses keep a subset of the vertices, all levels index the vertices of the full
+ * detail mesh instead of having their own. Stops at the first level whose decimation removes no triangle, the coarser
+ * ones could not remove any either.
+ *
+ * @param ratios fraction of the full detail triangles to keep for each level, in decreasing order. A level whose ratio
+ * is not below the previous one repeats its triangles.
+ * @param acquireLevelBuffers called with the level (starting at 1) and its sizes
+ * @return the number of sent levels
+ */
+template <typename AcquireLevelBuffers>
+size_t writeLevelsOfDetail(const WeldedGeometry& welded, const double* ratios, size_t ratioCount,
+                           std::vector<uint32_t>& triangles, Triangulation::PolygonTriangulator& triangulator,
+                           Decimation::MeshDecimator& decimator, AcquireLevelBuffers&& acquireLevelBuffers) {
+	triangulateWeldedGeometry(welded, triangles, triangulator);
+
+	const size_t vertexCount = welded.vertexCoords.size() / 3;
+	const double fullTriangleCount = static_cast<double>(triangles.size() / 3);
+	size_t level = 0;
+	while (level < ratioCount && !triangles.empty()) {
+		const size_t triangleCount = triangles.size() / 3;
+		const size_t targetTriangleCount = std::max<size_t>(
+		        1, static_cast<size_t>(std::ceil(std::clamp(ratios[level], 0.0, 1.0) * fullTriangleCount)));
+		if (targetTriangleCount < triangleCount) {
+			// closed meshes can collapse completely, the previous level then remains the coarsest one
+			decimator.decimate(welded.vertexCoords.data(), vertexCount, triangles, targetTriangleCount, 0.0);
+			if (triangles.empty() || triangles.size() / 3 == triangleCount)
+				break;
+		}
+
+		IRhinoCallbacks::MeshBufferSizes sizes;
+		sizes.faceIndicesCount = triangles.size();
+		sizes.faceCountsCount = triangles.size() / 3;
+		sizes.indexed = true;
+		const IRhinoCallbacks::MeshBuffers buffers = acquireLevelBuffers(level + 1, sizes);
+		if (buffers.faceIndices == nullptr || buffers.faceCounts == nullptr)
+			break;
+		std::copy(triangles.begin(), triangles.end(), buffers.faceIndices);
+		std::fill_n(buffers.faceCounts, sizes.faceCountsCount, 3u);
+		level++;
+	}
+	return level;
+}
+
+/**
+ * Appends the bounding box of the instances' vertices to the proxy corners, nothing if there are no vertices.
+ */
+void addProxyBox(const prtx::EncodePreparator::InstanceVector& instances, bool oriented,
+                 BoundingBox::OrientedBoxBuilder& orientedBox, std::vector<double>& proxyCorners) {
+	BoundingBox::Bounds bounds;
+	orientedBox.clear();
+	for (const auto& instance : instances) {
+		for (const prtx::MeshPtr& mesh : instance.getGeometry()->getMeshes()) {
+			const prtx::DoubleVector& verts = mesh->getVertexCoords();
+			if (oriented)
+				orientedBox.add(verts.data(), verts.size() / 3);
+			else
+				BoundingBox::extend(bounds, verts.data(), verts.size() / 3);
+		}
+	}
+
+	BoundingBox::Corners corners;
+	if (oriented) {
+		if (!orientedBox.build(corners))
+			return;
+	}
+	else {
+		if (bounds.isEmpty())
+			return;
+		corners = BoundingBox::getCorners(bounds);
+	}
+	proxyCorners.insert(proxyCorners.end(), corners.begin(), corners.end());
+}
+
+/**
+ * Sends the proxy boxes of an initial shape as a single mesh without normals, texture coordinates and materials.
+ */
+void writeProxyBoxes(const std::vector<double>& proxyCorners, size_t initialShapeIndex, IRhinoCallbacks* cb) {
+	const size_t boxCount = proxyCorners.size() / std::tuple_size<BoundingBox::Corners>::value;
+	if (boxCount == 0)
+		return;
+
+	IRhinoCallbacks::MeshBufferSizes sizes;
+	sizes.vertexCoordsCount = proxyCorners.size();
+	sizes.faceIndicesCount = boxCount * BoundingBox::FACE_CORNERS.size();
+	sizes.faceCountsCount = boxCount * 6;
+	sizes.indexed = true;
+
+	const IRhinoCallbacks::MeshBuffers buffers = cb->acquireMeshBuffers(initialShapeIndex, sizes);
+	std::copy(proxyCorners.begin(), proxyCorners.end(), buffers.vertexCoords);
+	std::fill_n(buffers.faceCounts, sizes.faceCountsCount, 4u);
+	for (size_t bi = 0; bi < boxCount; bi++) {
+		const uint32_t firstCorner = static_cast<uint32_t>(bi * 8);
+		std::transform(BoundingBox::FACE_CORNERS.begin(), BoundingBox::FACE_CORNERS.end(),
+		               buffers.faceIndices + bi * BoundingBox::FACE_CORNERS.size(),
+		               [firstCorner](uint32_t corner) { return firstCorner + corner; });
+	}
+
+	const std::array<uint32_t, 2> faceRanges = {0, static_cast<uint32_t>(sizes.faceCountsCount)};
+	cb->addMaterials(initialShapeIndex, 0, faceRanges.data(), faceRanges.size(), nullptr, 0);
+}
+
 } // namespace
 
+void WeldedGeometry::clear() {
+	vertexCoords.clear();
+	normals.clear();
+	uvs.clear();
+	faceIndices.clear();
+	faceCounts.clear();
+	keys.clear();
+}
+
+void RhinoEncoder::Scratch::beginShape() {
+	finalizedInstances.clear();
+	prototypes.clear();
+	proxyCorners.clear();
+	resetInstance();
+	mShapeCapacities = getCapacities();
+}
+
+void RhinoEncoder::Scratch::endShape() {
+	// drop the references to the geometry of the shape but keep the capacity
+	finalizedInstances.clear();
+	resetInstance();
+
+	const std::array<size_t, BUFFER_COUNT> capacities = getCapacities();
+	size_t growths = 0;
+	for (size_t i = 0; i < BUFFER_COUNT; i++) {
+		if (capacities[i] > mShapeCapacities[i])
+			growths++;
+	}
+	growthCount += growths;
+	if (growths > 0)
+		growingShapeCount++;
+	shapeCount++;
+}
+
+void RhinoEncoder::Scratch::resetInstance() {
+	matAttrMaps.clear();
+	matAttrPtrs.clear();
+	faceRanges.clear();
+}
+
+std::array<size_t, RhinoEncoder::Scratch::BUFFER_COUNT> RhinoEncoder::Scratch::getCapacities() const {
+	return {finalizedInstances.capacity(), matAttrMaps.capacity(),         matAttrPtrs.capacity(),
+	        faceRanges.capacity(),         prototypes.capacity(),          welded.vertexCoords.capacity(),
+	        welded.normals.capacity(),     welded.uvs.capacity(),          welded.faceIndices.capacity(),
+	        welded.faceCounts.capacity(),  welded.keys.capacity(),         welded.table.capacity(),
+	        proxyCorners.capacity(),       triangles.capacity(),           vertexRemap.capacity()};
+}
+
 const std::wstring RhinoEncoder::ID = L"com.esri.rhinoprt.RhinoEncoder";
 const std::wstring RhinoEncoder::NAME = L"Rhino Geometry and Report Encoder";
 const std::wstring RhinoEncoder::DESCRIPTION = L"Encodes geometry and CGA report for Rhino.";
@@ -424,6 +981,13 @@ void RhinoEncoder::init(prtx::GenerateContext&) {
 	prtx::NamePreparator::NamespacePtr nsMaterials = mNamePreparator.newNamespace();
 	prtx::NamePreparator::NamespacePtr nsMeshes = mNamePreparator.newNamespace();
 	mEncodePreparator = prtx::EncodePreparator::create(true, mNamePreparator, nsMeshes, nsMaterials);
+
+	// the proxy boxes are computed from the vertices in the coordinate system of the initial shape
+	const auto& options = getOptions();
+	const bool proxies = options->getInt(EO_PROXY_BOXES) != PROXY_NONE;
+	mPreparationFlags = createPreparationFlags(options->getBool(EO_INSTANCING) && !proxies,
+	                                           options->getBool(EO_EMIT_NORMALS) && !proxies,
+	                                           options->getBool(EO_EMIT_UVS) && !proxies);
 }
 
 void RhinoEncoder::encode(prtx::GenerateContext& context, size_t initialShapeIndex) {
@@ -434,37 +998,76 @@ void RhinoEncoder::encode(prtx::GenerateContext& context, size_t initialShapeInd
 	if (cb == nullptr)
 		throw prtx::StatusException(prt::STATUS_ILLEGAL_CALLBACK_OBJECT);
 
+	if (cb->isCanceled())
+		return;
+
+	const bool emitGeometry = getOptions()->getBool(EO_EMIT_GEOMETRY);
+	const bool emitReports = getOptions()->getBool(EO_EMIT_REPORTS);
+
 	// Initialization of report accumulator and strategy
-	prtx::ReportsAccumulatorPtr reportsAccumulator{prtx::SummarizingReportsAccumulator::create()};
-	prtx::ReportingStrategyPtr reportsCollector{
-	        prtx::AllShapesReportingStrategy::create(context, initialShapeIndex, reportsAccumulator)};
+	prtx::ReportingStrategyPtr reportsCollector;
+	if (emitReports) {
+		prtx::ReportsAccumulatorPtr reportsAccumulator{prtx::SummarizingReportsAccumulator::create()};
+		reportsCollector = prtx::AllShapesReportingStrategy::create(context, initialShapeIndex, reportsAccumulator);
+	}
 
-	if constexpr (ENC_DBG)
-		log_debug("Starting leaf iteration");
+	// the shape tree is only walked for the geometry, the reporting strategy collects the reports on its own
+	if (emitGeometry) {
+		const int32_t proxyBoxes = getOptions()->getInt(EO_PROXY_BOXES);
+		const bool orientedProxies = proxyBoxes == PROXY_ORIENTED;
+		const bool leafProxies = proxyBoxes != PROXY_NONE && getOptions()->getBool(EO_PROXY_PER_LEAF);
 
-	try {
-		prtx::LeafIteratorPtr li = prtx::LeafIterator::create(context, initialShapeIndex);
+		mScratch.beginShape();
 
-		for (prtx::ShapePtr shape = li->getNext(); shape.get() != nullptr; shape = li->getNext()) {
-			mEncodePreparator->add(context.getCache(), shape, initialShape.getAttributeMap());
+		if constexpr (ENC_DBG)
+			log_debug("Starting leaf iteration");
+
+		try {
+			prtx::LeafIteratorPtr li = prtx::LeafIterator::create(context, initialShapeIndex);
+
+			for (prtx::ShapePtr shape = li->getNext(); shape.get() != nullptr; shape = li->getNext()) {
+				if (cb->isCanceled()) {
+					// start over with an empty preparator, the already added shapes must not leak into the next shape
+					init(context);
+					mScratch.endShape();
+					return;
+				}
+				mEncodePreparator->add(context.getCache(), shape, initialShape.getAttributeMap());
+
+				// one box per leaf shape: the leaf is finalized on its own
+				if (leafProxies) {
+					mEncodePreparator->fetchFinalizedInstances(mScratch.finalizedInstances, mPreparationFlags);
+					addProxyBox(mScratch.finalizedInstances, orientedProxies, mScratch.orientedBox,
+					            mScratch.proxyCorners);
+					mScratch.finalizedInstances.clear();
+				}
+			}
 		}
-	}
-	catch (std::exception& e) {
-		log_error("Caught exception: %1%") % e.what();
+		catch (std::exception& e) {
+			log_error("Caught exception: %1%") % e.what();
 
-		mEncodePreparator->add(context.getCache(), initialShape, initialShapeIndex);
-	}
-	catch (...) {
-		log_error("Unknown exception while encoding geometry.");
+			mEncodePreparator->add(context.getCache(), initialShape, initialShapeIndex);
+		}
+		catch (...) {
+			log_error("Unknown exception while encoding geometry.");
 
-		mEncodePreparator->add(context.getCache(), initialShape, initialShapeIndex);
-	}
+			mEncodePreparator->add(context.getCache(), initialShape, initialShapeIndex);
+		}
 
-	prtx::EncodePreparator::InstanceVector finalizedInstances;
-	mEncodePreparator->fetchFinalizedInstances(finalizedInstances, ENC_PREP_FLAGS);
-	convertGeometry(initialShape, finalizedInstances, cb, context.getCache());
+		mEncodePreparator->fetchFinalizedInstances(mScratch.finalizedInstances, mPreparationFlags);
+		if (proxyBoxes == PROXY_NONE) {
+			convertGeometry(initialShape, mScratch.finalizedInstances, cb, context.getCache());
+		}
+		else {
+			// per leaf shape only the fallback geometry of a failed leaf iteration is left
+			addProxyBox(mScratch.finalizedInstances, orientedProxies, mScratch.orientedBox, mScratch.proxyCorners);
+			writeProxyBoxes(mScratch.proxyCorners, initialShapeIndex, cb);
+			mScratch.proxyBoxCount += mScratch.proxyCorners.size() / std::tuple_size<BoundingBox::Corners>::value;
+		}
+		mScratch.endShape();
+	}
 
-	if (getOptions()->getBool(EO_EMIT_REPORTS)) {
+	if (emitReports) {
 		const prtx::ReportsPtr& reports = reportsCollector->getReports();
 
 		if (reports) {
@@ -477,29 +1080,88 @@ void RhinoEncoder::encode(prtx::GenerateContext& context, size_t initialShapeInd
 
 void RhinoEncoder::convertGeometry(const prtx::InitialShape&, const prtx::EncodePreparator::InstanceVector& instances,
                                    IRhinoCallbacks* cb, prt::Cache* cache) {
-	bool emitMaterials = getOptions()->getBool(EO_EMIT_MATERIALS);
-
-	uint32_t vertexIndexBase = 0;
-	uint32_t maxNumUVSets = 0;
-	std::vector<uint32_t> uvIndexBases(maxNumUVSets, 0u);
-
-	std::vector<double> vertexCoords;
-	prtx::DoubleVector normals;
-	std::vector<uint32_t> faceIndices;
-	std::vector<uint32_t> faceCounts;
-	std::vector<prtx::PRTUtils::AttributeMapUPtr> matAttrMap;
-
-	uint32_t faceCount = 0;
-	std::vector<uint32_t> faceRanges;
+	const bool emitMaterials = getOptions()->getBool(EO_EMIT_MATERIALS);
+	const bool emitNormals = getOptions()->getBool(EO_EMIT_NORMALS);
+	const bool emitUVs = getOptions()->getBool(EO_EMIT_UVS); // independent of the material output
+	const bool instancing = getOptions()->getBool(EO_INSTANCING);
+
+	// single precision mode: the vertices of the shape are stored relative to its centroid, prototypes stay in double
+	// precision in their own coordinate system
+	std::array<double, 3> localOrigin{};
+	const bool singlePrecision =
+	        getOptions()->getBool(EO_SINGLE_PRECISION) && getCentroid(instances, instancing, localOrigin);
+	if (singlePrecision)
+		cb->setLocalOrigin(instances.front().getInitialShapeIndex(), localOrigin.data());
+
+	const bool weldVertices = getOptions()->getBool(EO_WELD_VERTICES);
+	WeldTolerances weldTolerances;
+	weldTolerances.position = getOptions()->getFloat(EO_WELD_TOLERANCE_POSITION);
+	weldTolerances.normal = getOptions()->getFloat(EO_WELD_TOLERANCE_NORMAL);
+	weldTolerances.uv = getOptions()->getFloat(EO_WELD_TOLERANCE_UV);
+
+	const double decimationRatio = getOptions()->getFloat(EO_DECIMATION_RATIO);
+	const double decimationError = getOptions()->getFloat(EO_DECIMATION_ERROR);
+	const bool decimate = decimationRatio < 1.0 || decimationError > 0.0;
+
+	// coarser levels of detail, derived from the meshes after the decimation
+	size_t lodRatioCount = 0;
+	const double* lodRatios = getOptions()->getFloatArray(EO_LOD_RATIOS, &lodRatioCount);
+	const bool buildLevels = lodRatios != nullptr && lodRatioCount > 0;
+
+	// the decimation and the levels of detail need shared vertices, without welding only identical vertices are shared
+	const bool indexed = weldVertices || decimate || buildLevels;
+
+	// writes the geometry of an instance into the buffers acquired from the callbacks, false if there is none
+	auto encodeGeometry = [&](const prtx::MeshPtrVector& meshes, const prtx::MaterialPtrVector& materials,
+	                          bool local, auto&& acquireBuffers, auto&& acquireLevelBuffers) {
+		IRhinoCallbacks::MeshBufferSizes sizes;
+		if (indexed) {
+			// the decimation must not collapse across material boundaries, each mesh of an instance has its material
+			weldGeometry(meshes, materials, emitNormals, emitUVs, weldVertices ? weldTolerances : WeldTolerances(),
+			             decimate || buildLevels, mScratch.welded);
+			if (weldVertices) {
+				mScratch.weldedCornerCount += mScratch.welded.faceIndices.size();
+				mScratch.weldedVertexCount += mScratch.welded.keys.size();
+			}
+			if (decimate) {
+				decimateWeldedGeometry(mScratch.welded, decimationRatio, decimationError, mScratch.triangles,
+				                       mScratch.vertexRemap, mScratch.triangulator, mScratch.decimator);
+			}
+			sizes = getWeldedSizes(mScratch.welded);
+		}
+		else {
+			sizes = scanGeometry(meshes, materials, emitNormals, emitUVs);
+		}
+		sizes.singlePrecision = local;
+		if (sizes.vertexCoordsCount == 0)
+			return false;
+
+		const IRhinoCallbacks::MeshBuffers buffers = acquireBuffers(sizes);
+		if (indexed) {
+			writeWeldedGeometry(mScratch.welded, sizes, buffers, mScratch.triangulator, localOrigin);
+			if (buildLevels) {
+				mScratch.levelCount +=
+				        writeLevelsOfDetail(mScratch.welded, lodRatios, lodRatioCount, mScratch.triangles,
+				                            mScratch.triangulator, mScratch.levelDecimator, acquireLevelBuffers);
+			}
+		}
+		else {
+			writeGeometry(meshes, materials, emitNormals, emitUVs, sizes, buffers, mScratch.triangulator,
+			              localOrigin);
+		}
+		return true;
+	};
 
-	std::vector<prtx::DoubleVector> uvs;
-	std::vector<prtx::IndexVector> uvCounts;
-	std::vector<prtx::IndexVector> uvIndices;
+	if (!mScratch.materialBuilder)
+		mScratch.materialBuilder = prtx::PRTUtils::AttributeMapBuilderPtr(prt::AttributeMapBuilder::create());
+	prtx::PRTUtils::AttributeMapBuilderPtr& amb = mScratch.materialBuilder;
 
-	prtx::PRTUtils::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
+	// prototypes which have already been sent to the callbacks, the encoder is called once per initial shape
+	auto& prototypes = mScratch.prototypes;
 
 	size_t instanceIndex = 0;
 	for (const auto& instance : instances) {
+		const size_t initialShapeIndex = instance.getInitialShapeIndex();
 
 		const prtx::MeshPtrVector& meshes = instance.getGeometry()->getMeshes();
 		const prtx::MaterialPtrVector& materials = instance.getMaterials();
@@ -509,141 +1171,67 @@ void RhinoEncoder::convertGeometry(const prtx::InitialShape&, const prtx::Encode
 			log_debug("Material count for instance %1%: %2%, meshes: %3%") % instance.getInitialShapeIndex() % materials.size() % mesh_count;
 		}
 
-		vertexIndexBase = 0;
-		maxNumUVSets = 0;
-		uvIndexBases.clear();
-		vertexCoords.clear();
-		normals.clear();
-		faceIndices.clear();
-		faceCounts.clear();
-		matAttrMap.clear();
-		uvs.clear();
-		uvCounts.clear();
-		uvIndices.clear();
-
-		// 1st pass: scan the geometries to preallocate the sizes of vectors
-		const auto [numCoords, numNormalCoords, numFaceCounts, numIndices] = scanMeshes(meshes);
-
-		vertexCoords.reserve(3 * numCoords);
-		normals.reserve(3 * numNormalCoords);
-		faceCounts.reserve(numFaceCounts);
-		faceIndices.reserve(numIndices);
-
-		// 2nd pass: fill the vectors
-		for (size_t mi = 0; mi < meshes.size(); ++mi) {
-			const prtx::MeshPtr& mesh = meshes.at(mi);
-
-			const prtx::DoubleVector& verts = mesh->getVertexCoords();
-			vertexCoords.insert(vertexCoords.end(), verts.begin(), verts.end());
-
-			const prtx::DoubleVector& norms = mesh->getVertexNormalsCoords();
-			normals.insert(normals.end(), norms.begin(), norms.end());
-
-			for (uint32_t fi = 0; fi < mesh->getFaceCount(); ++fi) {
-				const uint32_t* vtxIdx = mesh->getFaceVertexIndices(fi);
-				const uint32_t vtxCnt = mesh->getFaceVertexCount(fi);
-				faceCounts.push_back(vtxCnt);
-
-				for (uint32_t vi = 0; vi < vtxCnt; vi++) {
-					faceIndices.push_back(vtxIdx[vi] + vertexIndexBase);
-				}
-			}
-			vertexIndexBase += (uint32_t)verts.size() / 3;
+		mScratch.resetInstance();
+		auto& matAttrMaps = mScratch.matAttrMaps;
+		auto& matAttrPtrs = mScratch.matAttrPtrs;
+		auto& faceRanges = mScratch.faceRanges;
 
-			if (emitMaterials) {
+		// the face ranges refer to the faces of this instance's mesh
+		uint32_t faceCount = 0;
+		if (emitMaterials) {
+			for (size_t mi = 0; mi < meshes.size(); ++mi) {
 				faceRanges.push_back(faceCount);
-				faceCount += mesh->getFaceCount();
+				faceCount += meshes.at(mi)->getFaceCount();
 
 				const prtx::MaterialPtr& mat = materials.at(mi);
-				const uint32_t requiredUVSetsByMaterial = scanValidTextures(mat);
-				maxNumUVSets = std::max(maxNumUVSets, std::max(mesh->getUVSetsCount(), requiredUVSetsByMaterial));
-
-				if (mesh->getUVSetsCount() > 0 && (bool)requiredUVSetsByMaterial) {
-					uvIndexBases.resize(maxNumUVSets, 0u);
-					uvs.resize(maxNumUVSets);
-					uvCounts.resize(maxNumUVSets);
-					uvIndices.resize(maxNumUVSets);
-				}
-
-				// copy first uv set data.
-				const uint32_t numUVSets = mesh->getUVSetsCount();
-				const prtx::DoubleVector& uvs0 = (numUVSets > 0) ? mesh->getUVCoords(0) : EMPTY_UVS;
-				const prtx::IndexVector faceUVCounts0 =
-				        (numUVSets > 0) ? mesh->getFaceUVCounts(0) : prtx::IndexVector(mesh->getFaceCount(), 0);
-
-				if constexpr (ENC_DBG)
-					log_debug("-- mesh: numUVSets = %1%") % numUVSets;
-
-				if (numUVSets > 0) {
-					for (uint32_t uvSet = 0; uvSet < uvs.size(); uvSet++) {
-						// append texture coordinates
-						const prtx::DoubleVector& currUVs = (uvSet < numUVSets) ? mesh->getUVCoords(uvSet) : EMPTY_UVS;
-						const auto& src = currUVs.empty() ? uvs0 : currUVs;
-
-						// insert the curent uvs into the corresponding position in the vector of uvs
-						auto& tgt = uvs[uvSet];
-						tgt.insert(tgt.end(), src.begin(), src.end());
-
-						// append uv face counts
-						const prtx::IndexVector& faceUVCounts =
-						        (uvSet < numUVSets && !currUVs.empty()) ? mesh->getFaceUVCounts(uvSet) : faceUVCounts0;
-						assert(faceUVCounts.size() == mesh->getFaceCount());
-						auto& tgtCounts = uvCounts[uvSet];
-						tgtCounts.insert(tgtCounts.end(), faceUVCounts.begin(), faceUVCounts.end());
-
-						if constexpr (ENC_DBG)
-							log_debug("  -- uvset %1%: face counts size = %2%") % uvSet % faceUVCounts.size();
-
-						// append uv vertex indices
-						for (uint32_t faceId = 0; faceId < static_cast<uint32_t>(faceUVCounts.size()); ++faceId) {
-							const uint32_t* faceUVIdx0 =
-							        (numUVSets > 0) ? mesh->getFaceUVIndices(faceId, 0) : EMPTY_IDX.data();
-							const uint32_t* faceUVIdx = (uvSet < numUVSets && !currUVs.empty())
-							                                    ? mesh->getFaceUVIndices(faceId, uvSet)
-							                                    : faceUVIdx0;
-							const uint32_t faceUVCnt = faceUVCounts[faceId];
-
-							if constexpr (ENC_DBG)
-								log_debug("      faceId %1%: faceUVCnt = %2%, faceVtxCnt = %3%") % faceId % faceUVCnt %  mesh->getFaceVertexCount(faceId);
-
-							for (uint32_t vrtxId = 0; vrtxId < faceUVCnt; ++vrtxId) {
-								uvIndices[uvSet].push_back(uvIndexBases[uvSet] + faceUVIdx[vrtxId]);
-							}
-						}
-
-						uvIndexBases[uvSet] += static_cast<uint32_t>(src.size()) / 2u;
-					}
-				}
 				convertMaterialToAttributeMap(amb, *(mat.get()), mat->getKeys(), cb, cache);
-				matAttrMap.emplace_back(amb->createAttributeMapAndReset());
+				matAttrMaps.emplace_back(amb->createAttributeMapAndReset());
+				matAttrPtrs.push_back(matAttrMaps.back().get());
 				if constexpr (ENC_DBG)
-					log_debug("mat map: %1%") % prtx::PRTUtils::objectToXML(matAttrMap.back().get());
+					log_debug("mat map: %1%") % prtx::PRTUtils::objectToXML(matAttrMaps.back().get());
 			}
 		}
 		faceRanges.push_back(faceCount);
 
-		assert(matAttrMap.empty() || matAttrMap.size() == 1);
-
-		assert(uvs.size() == uvCounts.size());
-		assert(uvs.size() == uvIndices.size());
-
-		auto puvs = toPtrVec(uvs);
-		auto puvCounts = toPtrVec(uvCounts);
-		auto puvIndices = toPtrVec(uvIndices);
-
-		assert(uvs.size() == puvCounts.first.size());
-		assert(uvs.size() == puvCounts.second.size());
-
-		const std::vector<const prt::AttributeMap*> matAttrPtrs = toPtrVec(matAttrMap);
-
-		cb->add(instance.getInitialShapeIndex(), instanceIndex, vertexCoords.data(), vertexCoords.size(),
-		        normals.data(), normals.size(), faceIndices.data(), faceIndices.size(), faceCounts.data(),
-		        faceCounts.size(),
-
-		        puvs.first.data(), puvs.second.data(), puvCounts.first.data(), puvCounts.second.data(),
-		        puvIndices.first.data(), puvIndices.second.data(), static_cast<uint32_t>(uvs.size()),
+		assert(matAttrMaps.empty() || matAttrMaps.size() == 1);
+
+		const int32_t prototypeIndex = instance.getPrototypeIndex();
+		if (instancing && prototypeIndex >= 0) {
+			// the geometry of a prototype is the same for all of its instances, it is only sent once
+			auto prototype = std::lower_bound(prototypes.begin(), prototypes.end(), prototypeIndex,
+			                                  [](const auto& p, int32_t index) { return p.first < index; });
+			if (prototype == prototypes.end() || prototype->first != prototypeIndex) {
+				const size_t protoIndex = static_cast<size_t>(prototypeIndex);
+				const bool hasGeometry = encodeGeometry(
+				        meshes, materials, false,
+				        [&](const auto& sizes) {
+					        return cb->acquirePrototypeBuffers(initialShapeIndex, protoIndex, sizes);
+				        },
+				        [&](size_t level, const auto& sizes) {
+					        return cb->acquirePrototypeLevelBuffers(initialShapeIndex, protoIndex, level, sizes);
+				        });
+				prototype = prototypes.emplace(prototype, prototypeIndex, hasGeometry);
+			}
 
-		        faceRanges.data(), faceRanges.size(), matAttrPtrs.data(), matAttrPtrs.size());
+			if (prototype->second) {
+				const prtx::DoubleVector& transformation = instance.getTransformation();
+				assert(transformation.size() == 16);
+				cb->addInstance(initialShapeIndex, instanceIndex, static_cast<size_t>(prototypeIndex),
+				                transformation.data(), matAttrPtrs.data(), matAttrPtrs.size());
+			}
+		}
+		else {
+			const bool hasGeometry = encodeGeometry(
+			        meshes, materials, singlePrecision,
+			        [&](const auto& sizes) { return cb->acquireMeshBuffers(initialShapeIndex, sizes); },
+			        [&](size_t level, const auto& sizes) {
+				        return cb->acquireMeshLevelBuffers(initialShapeIndex, level, sizes);
+			        });
+			if (hasGeometry) {
+				cb->addMaterials(initialShapeIndex, instanceIndex, faceRanges.data(), faceRanges.size(),
+				                 matAttrPtrs.data(), matAttrPtrs.size());
+			}
+		}
 
 		instanceIndex++;
 	}
@@ -652,6 +1240,42 @@ void RhinoEncoder::convertGeometry(const prtx::InitialShape&, const prtx::Encode
 void RhinoEncoder::finish(prtx::GenerateContext&) {
 	if constexpr (ENC_DBG)
 		log_debug("In finish  function...");
+
+	log_debug("RhinoEncoder scratch buffers: %1% buffer growths, %2% of %3% shapes allocated") % mScratch.growthCount %
+	        mScratch.growingShapeCount % mScratch.shapeCount;
+
+	if (mScratch.weldedCornerCount > 0) {
+		const size_t removedVertices = mScratch.weldedCornerCount - mScratch.weldedVertexCount;
+		log_debug("RhinoEncoder vertex welding: %1% face corners welded into %2% vertices (%3%x fewer), about %4% KiB "
+		         "less mesh memory") %
+		        mScratch.weldedCornerCount % mScratch.weldedVertexCount %
+		        (static_cast<double>(mScratch.weldedCornerCount) / static_cast<double>(mScratch.weldedVertexCount)) %
+		        (removedVertices * RHINO_MESH_VERTEX_BYTES / 1024);
+	}
+
+	const Decimation::MeshDecimator& decimator = mScratch.decimator;
+	if (decimator.getInputTriangleCount() > 0) {
+		log_debug("RhinoEncoder decimation: %1% triangles reduced to %2% (%3%x fewer) in %4% ms") %
+		        decimator.getInputTriangleCount() % decimator.getOutputTriangleCount() %
+		        (static_cast<double>(decimator.getInputTriangleCount()) /
+		         static_cast<double>(std::max<size_t>(decimator.getOutputTriangleCount(), 1))) %
+		        (decimator.getSeconds() * 1000.0);
+	}
+
+	const Decimation::MeshDecimator& levelDecimator = mScratch.levelDecimator;
+	if (mScratch.levelCount > 0) {
+		log_debug("RhinoEncoder levels of detail: %1% levels with %2% triangles, decimated in %3% ms") %
+		        mScratch.levelCount % levelDecimator.getOutputTriangleCount() % (levelDecimator.getSeconds() * 1000.0);
+	}
+
+	if (mScratch.proxyBoxCount > 0)
+		log_debug("RhinoEncoder proxies: %1% bounding boxes") % mScratch.proxyBoxCount;
+
+	const Triangulation::PolygonTriangulator& triangulator = mScratch.triangulator;
+	if (triangulator.getPolygonCount() > 0) {
+		log_debug("RhinoEncoder triangulation: %1% polygons in %2% ms, %3% fell back to a fan") %
+		        triangulator.getPolygonCount() % (triangulator.getSeconds() * 1000.0) % triangulator.getFallbackCount();
+	}
 }
 
 RhinoEncoderFactory* RhinoEncoderFactory::createInstance() {
@@ -670,6 +1294,19 @@ RhinoEncoderFactory* RhinoEncoderFactory::createInstance() {
 	amb->setBool(EO_EMIT_GEOMETRY, true);
 	amb->setBool(EO_EMIT_REPORTS, true);
 	amb->setBool(EO_EMIT_MATERIALS, true);
+	amb->setBool(EO_EMIT_NORMALS, true);
+	amb->setBool(EO_EMIT_UVS, true);
+	amb->setBool(EO_INSTANCING, false);
+	amb->setBool(EO_SINGLE_PRECISION, false);
+	amb->setBool(EO_WELD_VERTICES, false);
+	amb->setFloat(EO_WELD_TOLERANCE_POSITION, 1e-4);
+	amb->setFloat(EO_WELD_TOLERANCE_NORMAL, 1e-3);
+	amb->setFloat(EO_WELD_TOLERANCE_UV, 1e-5);
+	amb->setInt(EO_PROXY_BOXES, PROXY_NONE);
+	amb->setBool(EO_PROXY_PER_LEAF, false);
+	amb->setFloat(EO_DECIMATION_RATIO, 1.0);
+	amb->setFloat(EO_DECIMATION_ERROR, 0.0);
+	amb->setFloatArray(EO_LOD_RATIOS, nullptr, 0);
 	encoderInfoBuilder.setDefaultOptions(amb->createAttributeMap());
 
 	return new RhinoEncoderFactory(encoderInfoBuilder.create());
@@ -19,7 +19,10 @@
 
 #pragma once
 
+#include "BoundingBox.h"
+#include "Decimation.h"
 #include "IRhinoCallbacks.h"
+#include "Triangulation.h"
 
 #include "prtx/EncodePreparator.h"
 #include "prtx/Encoder.h"
@@ -29,13 +32,35 @@
 
 #include "prt/Callbacks.h"
 
+#include <array>
 #include <string>
+#include <utility>
+#include <vector>
 
 // forward declare some classes to reduce header inclusion
 namespace prtx {
 class GenerateContext;
 }
 
+/**
+ * Indexed geometry of an instance after vertex welding. The lookup table is an open addressing hash table of vertex
+ * indices + 1 (0 marks an empty slot), so that the buffers can be reused without allocations.
+ */
+struct WeldedGeometry {
+	using Key = std::array<int64_t, 9>; // quantized position, normal and uv, mesh index if the meshes are kept apart
+
+	std::vector<double> vertexCoords;
+	std::vector<double> normals;
+	std::vector<float> uvs; // one (u, v) pair per vertex, empty without textures
+	std::vector<uint32_t> faceIndices;
+	std::vector<uint32_t> faceCounts;
+
+	std::vector<Key> keys;
+	std::vector<uint32_t> table;
+
+	void clear();
+};
+
 class RhinoEncoder : public prtx::GeometryEncoder {
 public:
 	static const std::wstring ID;
@@ -54,8 +79,51 @@ public:
 	virtual void finish(prtx::GenerateContext& context) override;
 
 private:
+	/**
+	 * Scratch buffers of encode() and convertGeometry(). They live as long as the encoder, i.e. for all initial shapes
+	 * of a generate call, and are only cleared between shapes and instances. Once their capacity fits the largest
+	 * shape, encoding a shape does not allocate them anymore; the counters track how often they still had to grow.
+	 */
+	struct Scratch {
+		prtx::EncodePreparator::InstanceVector finalizedInstances;
+		std::vector<prtx::PRTUtils::AttributeMapUPtr> matAttrMaps;
+		std::vector<const prt::AttributeMap*> matAttrPtrs;
+		std::vector<uint32_t> faceRanges;
+		std::vector<std::pair<int32_t, bool>> prototypes; // sorted by prototype index, true if it has geometry
+		prtx::PRTUtils::AttributeMapBuilderPtr materialBuilder;
+		WeldedGeometry welded;
+		Triangulation::PolygonTriangulator triangulator;
+		std::vector<double> proxyCorners; // BoundingBox::Corners of the proxy boxes of the shape
+		BoundingBox::OrientedBoxBuilder orientedBox;
+		Decimation::MeshDecimator decimator;
+		Decimation::MeshDecimator levelDecimator; // levels of detail, separate for its statistics
+		std::vector<uint32_t> triangles;
+		std::vector<uint32_t> vertexRemap;
+
+		size_t shapeCount = 0;
+		size_t growingShapeCount = 0; // shapes for which at least one buffer had to grow
+		size_t growthCount = 0;       // number of buffers which had to grow, counted once per shape
+
+		size_t weldedCornerCount = 0; // face corners, i.e. the vertex count of the meshes without welding
+		size_t weldedVertexCount = 0;
+
+		size_t proxyBoxCount = 0;
+		size_t levelCount = 0; // levels of detail over all meshes and prototypes
+
+		void beginShape();
+		void endShape();
+		void resetInstance();
+
+	private:
+		static constexpr size_t BUFFER_COUNT = 15;
+		std::array<size_t, BUFFER_COUNT> getCapacities() const;
+		std::array<size_t, BUFFER_COUNT> mShapeCapacities{};
+	};
+
 	prtx::DefaultNamePreparator mNamePreparator;
 	prtx::EncodePreparatorPtr mEncodePreparator;
+	prtx::EncodePreparator::PreparationFlags mPreparationFlags;
+	Scratch mScratch;
 
 	void convertGeometry(const prtx::InitialShape& initialShape,
 	                     const prtx::EncodePreparator::InstanceVector& instances, IRhinoCallbacks* cb,
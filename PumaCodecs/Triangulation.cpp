@@ -0,0 +1,132 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Triangulation.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+double cross(const double* a, const double* b, const double* c) {
+	return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+/**
+ * True if p lies inside or on the boundary of the triangle abc, whose orientation is given by the sign.
+ */
+bool isInTriangle(const double* p, const double* a, const double* b, const double* c, double orientation) {
+	return cross(a, b, p) * orientation >= 0.0 && cross(b, c, p) * orientation >= 0.0 &&
+	       cross(c, a, p) * orientation >= 0.0;
+}
+
+} // namespace
+
+namespace Triangulation {
+
+bool PolygonTriangulator::triangulate(const double* vertexCoords, const uint32_t* corners, uint32_t cornerCount,
+                                      uint32_t* triangles) {
+	const auto start = std::chrono::steady_clock::now();
+
+	// Newell normal, its dominant axis is dropped for the projection
+	double normal[3] = {0.0, 0.0, 0.0};
+	for (uint32_t i = 0; i < cornerCount; i++) {
+		const double* a = vertexCoords + 3 * static_cast<size_t>(corners[i]);
+		const double* b = vertexCoords + 3 * static_cast<size_t>(corners[(i + 1) % cornerCount]);
+		normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+		normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+		normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+	}
+	size_t axis = 0;
+	if (std::abs(normal[1]) > std::abs(normal[axis]))
+		axis = 1;
+	if (std::abs(normal[2]) > std::abs(normal[axis]))
+		axis = 2;
+	const size_t u = (axis + 1) % 3;
+	const size_t v = (axis + 2) % 3;
+
+	// the projection keeps the winding if the normal points along the dropped axis
+	const double orientation = (normal[axis] >= 0.0) ? 1.0 : -1.0;
+
+	mPoints.resize(2 * static_cast<size_t>(cornerCount));
+	mRemaining.resize(cornerCount);
+	for (uint32_t i = 0; i < cornerCount; i++) {
+		const double* p = vertexCoords + 3 * static_cast<size_t>(corners[i]);
+		mPoints[2 * i] = p[u];
+		mPoints[2 * i + 1] = p[v];
+		mRemaining[i] = i;
+	}
+	auto point = [this](uint32_t corner) { return mPoints.data() + 2 * static_cast<size_t>(corner); };
+
+	std::vector<uint32_t>& remaining = mRemaining;
+	uint32_t* triangle = triangles;
+	bool clipped = true;
+	size_t current = 0;
+	size_t attempts = 0;
+	while (remaining.size() > 3) {
+		if (attempts >= remaining.size()) {
+			clipped = false;
+			break;
+		}
+
+		const size_t count = remaining.size();
+		const uint32_t prev = remaining[(current + count - 1) % count];
+		const uint32_t ear = remaining[current];
+		const uint32_t next = remaining[(current + 1) % count];
+		const double* a = point(prev);
+		const double* b = point(ear);
+		const double* c = point(next);
+
+		bool isEar = cross(a, b, c) * orientation > 0.0;
+		for (size_t i = 0; isEar && i < count; i++) {
+			const uint32_t other = remaining[i];
+			if (other != prev && other != ear && other != next)
+				isEar = !isInTriangle(point(other), a, b, c, orientation);
+		}
+
+		if (isEar) {
+			*triangle++ = prev;
+			*triangle++ = ear;
+			*triangle++ = next;
+			remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(current));
+			if (current >= remaining.size())
+				current = 0;
+			attempts = 0;
+		}
+		else {
+			current = (current + 1) % count;
+			attempts++;
+		}
+	}
+
+	// last triangle, or a fan over the corners which could not be clipped
+	for (size_t i = 1; i + 1 < remaining.size(); i++) {
+		*triangle++ = remaining[0];
+		*triangle++ = remaining[i];
+		*triangle++ = remaining[i + 1];
+	}
+
+	mPolygonCount++;
+	if (!clipped)
+		mFallbackCount++;
+	mSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return clipped;
+}
+
+} // namespace Triangulation
@@ -0,0 +1,65 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Triangulation {
+
+/**
+ * Ear clipping triangulation of simple, planar or nearly planar polygons. Each polygon is projected along its dominant
+ * normal axis and its ears are clipped in the winding order of the polygon. The buffers are reused across polygons.
+ */
+class PolygonTriangulator {
+public:
+	/**
+	 * @param vertexCoords xyz coordinates of the mesh vertices
+	 * @param corners the vertex indices of the polygon
+	 * @param cornerCount number of corners, at least 3
+	 * @param [out] triangles receives (cornerCount - 2) * 3 corner offsets in [0, cornerCount)
+	 * @return false if no ear could be found for a degenerate or self-intersecting polygon, its remaining corners are
+	 * then triangulated as a fan.
+	 */
+	bool triangulate(const double* vertexCoords, const uint32_t* corners, uint32_t cornerCount, uint32_t* triangles);
+
+	size_t getPolygonCount() const {
+		return mPolygonCount;
+	}
+
+	size_t getFallbackCount() const {
+		return mFallbackCount;
+	}
+
+	double getSeconds() const {
+		return mSeconds;
+	}
+
+private:
+	std::vector<double> mPoints; // projected 2d points
+	std::vector<uint32_t> mRemaining;
+
+	size_t mPolygonCount = 0;
+	size_t mFallbackCount = 0;
+	double mSeconds = 0.0;
+};
+
+} // namespace Triangulation
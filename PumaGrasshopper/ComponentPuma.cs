@@ -56,6 +56,9 @@ namespace PumaGrasshopper
             new ParameterDescriptor{ type = ParamType.INTEGER, name = SEED_KEY, nickName = SEED_INPUT_NAME, desc = SEED_INPUT_DESC },
         };
 
+        // shapes of the latest solution whose default values are prefetched in the background, fetched on demand
+        private List<Mesh> mPrefetchedShapes;
+
         public ComponentPuma()
           : base(COMPONENT_NAME, COMPONENT_NICK_NAME) { }
 
@@ -91,16 +94,29 @@ namespace PumaGrasshopper
             if (inputMeshes == null || inputMeshes.Count == 0)
                 return;
 
+            // evaluates the default values of the shapes while the rule attributes are loaded, repeated calls for the
+            // same rule package and shapes have no effect
+            PRTWrapper.PrefetchRulePackage(rpk.path, inputMeshes);
+
             if(mCurrentRpk == null || !mCurrentRpk.IsSame(rpk))
             {
                 mCurrentRpk = rpk;
                 mRuleAttributes = PRTWrapper.GetRuleAttributes(rpk.path);
                 mDefaultValues = PRTWrapper.GetDefaultValues(rpk.path, inputMeshes);
+                mPrefetchedShapes = null;
+            }
+            else
+            {
+                mPrefetchedShapes = inputMeshes;
             }
 
             RuleAttributesMap MM = FillAttributesFromNode(DA, inputMeshes.Count);
 
-            var generatedMeshes = PRTWrapper.Generate(rpk.path, ref MM, inputMeshes);
+            SetOutputChannels();
+            var generatedMeshes = GenerateModels(rpk, ref MM, inputMeshes);
+            if (generatedMeshes == null)
+                return;
+
             OutputGeometry(DA, generatedMeshes.meshes);
             OutputMaterials(DA, generatedMeshes.materials);
             OutputReports(DA, generatedMeshes.reports);
@@ -293,6 +309,13 @@ namespace PumaGrasshopper
         {
             Debug.Assert(mRuleAttributes.Length > 0); // ensured by CanInsertParameter
 
+            // the shapes may have changed since the default values were fetched
+            if (mPrefetchedShapes != null)
+            {
+                mDefaultValues = PRTWrapper.GetDefaultValues(mCurrentRpk.path, mPrefetchedShapes) ?? mDefaultValues;
+                mPrefetchedShapes = null;
+            }
+
             List<RuleAttribute> eligibleAttributes = GetEligibleAttributes();
 
             var form = new AttributeForm(eligibleAttributes,
@@ -100,7 +100,11 @@ namespace PumaGrasshopper
 
             RuleAttributesMap MM = ParseBulkInputTree(DA, inputMeshes.Count);
 
-            var generatedMeshes = PRTWrapper.Generate(rpk.path, ref MM, inputMeshes);
+            SetOutputChannels();
+            var generatedMeshes = GenerateModels(rpk, ref MM, inputMeshes);
+            if (generatedMeshes == null)
+                return;
+
             OutputGeometry(DA, generatedMeshes.meshes);
             OutputMaterials(DA, generatedMeshes.materials);
             OutputReports(DA, generatedMeshes.reports);
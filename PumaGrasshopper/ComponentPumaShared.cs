@@ -108,6 +108,27 @@ namespace PumaGrasshopper
 
         protected bool mDoGenerateMaterials;
 
+        protected bool mDoInstancing;
+
+        protected bool mPositionIndependentRules;
+
+        protected bool mSinglePrecision;
+
+        // welding tolerances of the position, normal and texture coordinates, as the native defaults
+        private const double WELD_POSITION_TOLERANCE = 1e-4;
+        private const double WELD_NORMAL_TOLERANCE = 1e-3;
+        private const double WELD_UV_TOLERANCE = 1e-5;
+        protected bool mWeldVertices;
+
+        // the generation threads are shared by all components, like the worker pool they configure
+        private static readonly int[] RESERVED_CORE_CHOICES = { 0, 1, 2 };
+        private static int sReservedCores = 0;
+        private static bool sPinGenerationThreads = false;
+
+        // large batches are generated in chunks which fit into the memory budget, 0 generates all shapes at once
+        private static readonly int[] MEMORY_BUDGET_CHOICES_MB = { 512, 1024, 4096, 16384, 0 };
+        private static int sMemoryBudgetMB = 1024;
+
         public ComponentPumaShared(string name, string nickname): base(name, nickname, "ArcGIS CityEngine for Rhino runs CityEngine CGA rules on input shapes and returns the generated models. (Version " + PRTWrapper.GetVersion() + ")",
             ComponentLibraryInfo.MainCategory, ComponentLibraryInfo.SubCategoryMain)
         {
@@ -118,6 +139,14 @@ namespace PumaGrasshopper
 
             mDoGenerateMaterials = true;
 
+            mDoInstancing = false;
+
+            mPositionIndependentRules = false;
+
+            mSinglePrecision = false;
+
+            mWeldVertices = false;
+
             mCurrentRpk = null;
         }
 
@@ -225,6 +254,27 @@ namespace PumaGrasshopper
             base.AppendAdditionalComponentMenuItems(menu);
 
             Menu_AppendItem(menu, "Generate Materials", OnMaterialToggleClicked, true, mDoGenerateMaterials);
+            Menu_AppendItem(menu, "Instance Repeated Assets", OnInstancingToggleClicked, true, mDoInstancing);
+            Menu_AppendItem(menu, "Position Independent Rules", OnPositionIndependentToggleClicked, true, mPositionIndependentRules);
+            Menu_AppendItem(menu, "Single Precision Vertices", OnSinglePrecisionToggleClicked, true, mSinglePrecision);
+            Menu_AppendItem(menu, "Weld Vertices", OnWeldVerticesToggleClicked, true, mWeldVertices);
+            Menu_AppendSeparator(menu);
+
+            var threadsMenu = Menu_AppendItem(menu, "Generation Threads");
+            foreach (int reservedCores in RESERVED_CORE_CHOICES)
+            {
+                string text = reservedCores == 0 ? "Use All Cores" : "Keep " + reservedCores + (reservedCores == 1 ? " Core" : " Cores") + " Free";
+                Menu_AppendItem(threadsMenu.DropDown, text, (object sender, EventArgs e) => SetReservedCores(reservedCores), true, sReservedCores == reservedCores);
+            }
+            Menu_AppendSeparator(threadsMenu.DropDown);
+            Menu_AppendItem(threadsMenu.DropDown, "Pin Threads to Cores", OnPinThreadsToggleClicked, true, sPinGenerationThreads);
+
+            var memoryMenu = Menu_AppendItem(menu, "Generation Memory Budget");
+            foreach (int budgetMB in MEMORY_BUDGET_CHOICES_MB)
+            {
+                string text = budgetMB == 0 ? "Unlimited" : (budgetMB < 1024 ? budgetMB + " MB" : budgetMB / 1024 + " GB");
+                Menu_AppendItem(memoryMenu.DropDown, text, (object sender, EventArgs e) => SetMemoryBudget(budgetMB), true, sMemoryBudgetMB == budgetMB);
+            }
             Menu_AppendSeparator(menu);
             Menu_AppendItem(menu, "Go to CityEngine Resources", (object sender, EventArgs e) => { Process.Start(CITYENGINE_RESOURCES_URL); });
         }
@@ -237,6 +287,131 @@ namespace PumaGrasshopper
             ExpireSolution(true);
         }
 
+        /// Repeated assets are returned once per shape as prototypes, see GenerationResult.prototypes. The model
+        /// outputs still contain a placed copy of the prototype per instance.
+        private void OnInstancingToggleClicked(object sender, EventArgs e)
+        {
+            mDoInstancing = !mDoInstancing;
+
+            ExpireSolution(true);
+        }
+
+        /// Shapes which only differ by a translation are generated once. Must stay off for rules which read absolute
+        /// coordinates, their models would be wrong.
+        private void OnPositionIndependentToggleClicked(object sender, EventArgs e)
+        {
+            mPositionIndependentRules = !mPositionIndependentRules;
+
+            ExpireSolution(true);
+        }
+
+        /// Halves the memory of the generated vertices, which are stored as floats relative to the centroid of each
+        /// model. The output meshes are restored in double precision.
+        private void OnSinglePrecisionToggleClicked(object sender, EventArgs e)
+        {
+            mSinglePrecision = !mSinglePrecision;
+
+            ExpireSolution(true);
+        }
+
+        /// Face corners with equal positions, normals and texture coordinates share their vertices, the output meshes
+        /// have far fewer vertices.
+        private void OnWeldVerticesToggleClicked(object sender, EventArgs e)
+        {
+            mWeldVertices = !mWeldVertices;
+
+            ExpireSolution(true);
+        }
+
+        /// Only affects how fast the models are generated, the outputs stay valid.
+        private static void SetReservedCores(int reservedCores)
+        {
+            sReservedCores = reservedCores;
+            PRTWrapper.SetGenerationConcurrency(0, sReservedCores, sPinGenerationThreads);
+        }
+
+        private static void OnPinThreadsToggleClicked(object sender, EventArgs e)
+        {
+            sPinGenerationThreads = !sPinGenerationThreads;
+            PRTWrapper.SetGenerationConcurrency(0, sReservedCores, sPinGenerationThreads);
+        }
+
+        /// Only bounds the memory held during a generation, the outputs stay valid.
+        private static void SetMemoryBudget(int budgetMB)
+        {
+            sMemoryBudgetMB = budgetMB;
+            PRTWrapper.SetGenerationMemoryBudget(sMemoryBudgetMB);
+        }
+
+        /// The native generation options are shared by all components, each component sets its own before generating.
+        private void ApplyGenerationOptions(RulePackage rpk)
+        {
+            PRTWrapper.SetInstancing(mDoInstancing);
+            PRTWrapper.SetRulePackagePositionIndependent(rpk.path, mPositionIndependentRules);
+            PRTWrapper.SetSinglePrecision(mSinglePrecision);
+            PRTWrapper.SetVertexWelding(mWeldVertices, WELD_POSITION_TOLERANCE, WELD_NORMAL_TOLERANCE, WELD_UV_TOLERANCE);
+        }
+
+        /// Only the outputs which are connected (or previewed, for the models) are generated, the work of the others
+        /// is skipped.
+        protected void SetOutputChannels()
+        {
+            bool IsConnected(OutputParams param) => Params.Output[(int)param].Recipients.Count > 0;
+
+            var channels = (OutputChannels)0;
+            if (IsConnected(OutputParams.MODELS) || !Hidden)
+                channels |= OutputChannels.GEOMETRY | OutputChannels.NORMALS | OutputChannels.UVS;
+            if (IsConnected(OutputParams.MATERIALS))
+                channels |= OutputChannels.GEOMETRY | OutputChannels.MATERIALS;
+            if (IsConnected(OutputParams.REPORTS))
+                channels |= OutputChannels.REPORTS;
+            if (IsConnected(OutputParams.PRINTS))
+                channels |= OutputChannels.PRINTS;
+            if (IsConnected(OutputParams.ERRORS))
+                channels |= OutputChannels.ERRORS;
+
+            PRTWrapper.SetOutputChannels((uint)channels);
+        }
+
+        /// Generates while the solution waits, with the progress in the Rhino status bar. Escape (or any other abort of
+        /// the solution) cancels the generation, which then returns null.
+        protected GenerationResult GenerateModels(RulePackage rpk, ref RuleAttributesMap MM, List<Mesh> inputMeshes)
+        {
+            GH_Document document = OnPingDocument();
+            bool progressShown = false;
+
+            bool KeepGenerating(int shapesDone, int shapesTotal)
+            {
+                if (GH_Document.IsEscapeKeyDown())
+                    document?.RequestAbortSolution();
+                if (document != null && document.AbortRequested)
+                    return false;
+
+                if (shapesTotal > 0)
+                {
+                    if (!progressShown)
+                        progressShown = Rhino.UI.StatusBar.ShowProgressMeter(0, shapesTotal, "Generating", true, true) != 0;
+                    if (progressShown)
+                        Rhino.UI.StatusBar.UpdateProgressMeter(shapesDone, true);
+                }
+                return true;
+            }
+
+            try
+            {
+                ApplyGenerationOptions(rpk);
+                var generationResult = PRTWrapper.Generate(rpk.path, ref MM, inputMeshes, keepWaiting: KeepGenerating);
+                if (generationResult == null)
+                    AddRuntimeMessage(GH_RuntimeMessageLevel.Warning, "Generation has been canceled.");
+                return generationResult;
+            }
+            finally
+            {
+                if (progressShown)
+                    Rhino.UI.StatusBar.HideProgressMeter();
+            }
+        }
+
         protected void OutputGeometry(IGH_DataAccess dataAccess, List<Mesh[]> generatedMeshes)
         {
             var meshStructure = Utils.CreateMeshStructure(generatedMeshes);
@@ -34,6 +34,34 @@ using System.Diagnostics;
 
 namespace PumaGrasshopper
 {
+    /// <summary>
+    /// Outputs of the generation, see PRTWrapper.SetOutputChannels. Must match OutputChannel in ModelGenerator.h.
+    /// </summary>
+    [Flags]
+    public enum OutputChannels : uint
+    {
+        GEOMETRY = 1 << 0,
+        NORMALS = 1 << 1,
+        UVS = 1 << 2,
+        MATERIALS = 1 << 3,
+        REPORTS = 1 << 4,
+        PRINTS = 1 << 5,
+        ERRORS = 1 << 6,
+        ALL = (1 << 7) - 1
+    }
+
+    /// <summary>
+    /// Bounding box proxies which replace the generated geometry, see PRTWrapper.Generate. Must match ProxyMode in ModelGenerator.h.
+    /// </summary>
+    [Flags]
+    public enum ProxyMode : uint
+    {
+        NONE = 0,
+        AXIS_ALIGNED = 1 << 0,
+        ORIENTED = 1 << 1,
+        PER_LEAF_SHAPE = 1 << 2
+    }
+
     public class GenerationResult
     {
         public List<Mesh[]> meshes = new List<Mesh[]>();
@@ -41,6 +69,16 @@ namespace PumaGrasshopper
         public List<ReportAttribute[]> reports = new List<ReportAttribute[]>();
         public List<GH_String[]> prints = new List<GH_String[]>();
         public List<GH_String[]> errors = new List<GH_String[]>();
+
+        // coarser levels of detail: per shape one array of meshes per level, matching the meshes and materials
+        public List<Mesh[][]> lodMeshes = new List<Mesh[][]>();
+
+        // instancing, see PRTWrapper.SetInstancing: per shape the prototype meshes, and per mesh the index of its
+        // prototype (-1 for the generated parts) with the transformation which places it. The meshes of the
+        // instances are transformed copies of their prototypes.
+        public List<Mesh[]> prototypes = new List<Mesh[]>();
+        public List<int[]> meshPrototypes = new List<int[]>();
+        public List<Transform[]> meshTransforms = new List<Transform[]>();
     }
 
     /// <summary>
@@ -49,6 +87,7 @@ namespace PumaGrasshopper
     public static class PRTWrapper
     {
         public static String INIT_SHAPE_IDX_KEY = "InitShapeIdx";
+        public static String LOD_LEVEL_KEY = "LodLevel";
         private const String PUMA_RHINO_LIBRARY = "CityEngineRhino.rhp";
 
         [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
@@ -76,7 +115,11 @@ namespace PumaGrasshopper
             [In] IntPtr pDoubleArrayKeys, [In] IntPtr pDoubleArrayVals,
             [In] IntPtr pStringArrayStarts, int stringArrayCount,
             [In] IntPtr pStringArrayKeys, [In] IntPtr pStringArrayVals,
-            [In] IntPtr pInitialMeshes, [Out] IntPtr pMeshCounts, [Out] IntPtr pMeshArray,
+            [In] IntPtr pInitialMeshes, uint proxyMode, double decimationRatio, double decimationError,
+            [In] double[] lodRatios, int lodRatioCount,
+            [Out] IntPtr pMeshCounts, [Out] IntPtr pMeshArray, [Out] IntPtr pLodMeshArray,
+            [Out] IntPtr pPrototypeCounts, [Out] IntPtr pPrototypeArray,
+            [Out] IntPtr pInstancePrototypes, [Out] IntPtr pInstanceTransforms,
             [Out] IntPtr pColorsArray, [Out] IntPtr pTexIndices, [Out] IntPtr pTexKeys, [Out] IntPtr pTexPaths,
             [Out] IntPtr pReportCountArray, [Out] IntPtr pReportKeyArray, [Out] IntPtr pReportDoubleArray,
             [Out] IntPtr pReportBoolArray, [Out] IntPtr pReportStringArray,
@@ -86,6 +129,9 @@ namespace PumaGrasshopper
         [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern int GetRuleAttributes(string rpk_path, [Out] IntPtr pAttributesBuffer, [Out] IntPtr pAttributesTypes, [Out] IntPtr pBaseAnnotations, [Out] IntPtr pDoubleAnnotations, [Out] IntPtr pStringAnnotations);
 
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern void PrefetchRulePackage(string rpk_path, [In] IntPtr pMeshes);
+
         [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern bool GetDefaultAttributes(
             string rpk_path, [In] IntPtr pMeshes, 
@@ -107,9 +153,151 @@ namespace PumaGrasshopper
         [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
         public static extern void SetMaterialGenerationOption(bool doGenerate);
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate void GenerateProgressCallback(int shapesDone, int shapesTotal);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, EntryPoint = "SetGenerateProgressCallback")]
+        private static extern void SetGenerateProgressCallbackNative(GenerateProgressCallback progressCallback);
+
+        // the native side only keeps the function pointer, the delegate must not be collected while it is registered
+        private static GenerateProgressCallback sProgressCallback;
+
+        /// <summary>
+        /// Registers the progress callback of the synchronous Generate, null removes it. The callback runs on the
+        /// generation threads, updates of the UI have to be marshalled (e.g. with RhinoApp.InvokeOnUiThread).
+        /// </summary>
+        public static void SetGenerateProgressCallback(GenerateProgressCallback progressCallback)
+        {
+            sProgressCallback = progressCallback;
+            SetGenerateProgressCallbackNative(progressCallback);
+        }
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void CancelGenerate();
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetGenerationConcurrency(int maxWorkerThreads, int reservedCores, bool pinWorkers);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetGenerationMemoryBudget(int megabytes);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern void SetRulePackagePositionIndependent(string rpk_path, bool positionIndependent);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetInstancing(bool instancing);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetSinglePrecision(bool singlePrecision);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetVertexWelding(bool enabled, double positionTolerance, double normalTolerance, double uvTolerance);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetOutputChannels(uint channels);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern bool GenerateReports(string rpk_path,
+            int shapeCount,
+            [In] IntPtr pBoolStarts, int boolCount,
+            [In] IntPtr pBoolKeys, [In] IntPtr pBoolVals,
+            [In] IntPtr pIntegerStarts, int integerCount,
+            [In] IntPtr pIntegerKeys, [In] IntPtr pIntegerVals,
+            [In] IntPtr pDoubleStarts, int doubleCount,
+            [In] IntPtr pDoubleKeys, [In] IntPtr pDoubleVals,
+            [In] IntPtr pStringStarts, int stringCount,
+            [In] IntPtr pStringKeys, [In] IntPtr pStringVals,
+            [In] IntPtr pBoolArrayStarts, int boolArrayCount,
+            [In] IntPtr pBoolArrayKeys, [In] IntPtr pBoolArrayVals,
+            [In] IntPtr pIntegerArrayStarts, int integerArrayCount,
+            [In] IntPtr pIntegerArrayKeys, [In] IntPtr pIntegerArrayVals,
+            [In] IntPtr pDoubleArrayStarts, int doubleArrayCount,
+            [In] IntPtr pDoubleArrayKeys, [In] IntPtr pDoubleArrayVals,
+            [In] IntPtr pStringArrayStarts, int stringArrayCount,
+            [In] IntPtr pStringArrayKeys, [In] IntPtr pStringArrayVals,
+            [In] IntPtr pInitialMeshes,
+            [Out] IntPtr pReportCountArray, [Out] IntPtr pReportKeyArray, [Out] IntPtr pReportDoubleArray,
+            [Out] IntPtr pReportBoolArray, [Out] IntPtr pReportStringArray);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern int SubmitGenerate(string rpk_path,
+            int shapeCount,
+            [In] IntPtr pBoolStarts, int boolCount,
+            [In] IntPtr pBoolKeys, [In] IntPtr pBoolVals,
+            [In] IntPtr pIntegerStarts, int integerCount,
+            [In] IntPtr pIntegerKeys, [In] IntPtr pIntegerVals,
+            [In] IntPtr pDoubleStarts, int doubleCount,
+            [In] IntPtr pDoubleKeys, [In] IntPtr pDoubleVals,
+            [In] IntPtr pStringStarts, int stringCount,
+            [In] IntPtr pStringKeys, [In] IntPtr pStringVals,
+            [In] IntPtr pBoolArrayStarts, int boolArrayCount,
+            [In] IntPtr pBoolArrayKeys, [In] IntPtr pBoolArrayVals,
+            [In] IntPtr pIntegerArrayStarts, int integerArrayCount,
+            [In] IntPtr pIntegerArrayKeys, [In] IntPtr pIntegerArrayVals,
+            [In] IntPtr pDoubleArrayStarts, int doubleArrayCount,
+            [In] IntPtr pDoubleArrayKeys, [In] IntPtr pDoubleArrayVals,
+            [In] IntPtr pStringArrayStarts, int stringArrayCount,
+            [In] IntPtr pStringArrayKeys, [In] IntPtr pStringArrayVals,
+            [In] IntPtr pInitialMeshes, uint proxyMode, double decimationRatio, double decimationError,
+            [In] double[] lodRatios, int lodRatioCount);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int PollGenerate(int jobId, out int shapesDone, out int shapesTotal);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern bool FetchGenerateResults(int jobId,
+            [Out] IntPtr pMeshCounts, [Out] IntPtr pMeshArray, [Out] IntPtr pLodMeshArray,
+            [Out] IntPtr pPrototypeCounts, [Out] IntPtr pPrototypeArray,
+            [Out] IntPtr pInstancePrototypes, [Out] IntPtr pInstanceTransforms,
+            [Out] IntPtr pColorsArray, [Out] IntPtr pTexIndices, [Out] IntPtr pTexKeys, [Out] IntPtr pTexPaths,
+            [Out] IntPtr pReportCountArray, [Out] IntPtr pReportKeyArray, [Out] IntPtr pReportDoubleArray,
+            [Out] IntPtr pReportBoolArray, [Out] IntPtr pReportStringArray,
+            [Out] IntPtr pPrintCountsArray, [Out] IntPtr pPrintValuesArray,
+            [Out] IntPtr pErrorCountsArray, [Out] IntPtr pErrorValuesArray);
+
+        [DllImport(dllName: PUMA_RHINO_LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void DiscardGenerateJob(int jobId);
+
+        private const int JOB_POLL_INTERVAL_MS = 20;
+
+        /// <summary>
+        /// Waits on the calling thread for a job submitted with SubmitGenerate, keepWaiting is called with the progress
+        /// of the job on every poll. Discards the job and returns false as soon as keepWaiting returns false.
+        /// </summary>
+        private static bool WaitForGenerateJob(int jobId, Func<int, int, bool> keepWaiting)
+        {
+            if (jobId < 0)
+                return false;
+
+            while (true)
+            {
+                int status = PollGenerate(jobId, out int shapesDone, out int shapesTotal);
+                if (status != 0)
+                    return status == 1;
+
+                if (!keepWaiting(shapesDone, shapesTotal))
+                {
+                    DiscardGenerateJob(jobId);
+                    return false;
+                }
+
+                System.Threading.Thread.Sleep(JOB_POLL_INTERVAL_MS);
+            }
+        }
+
+        /// <summary>
+        /// Generates the models of the initial meshes. With keepWaiting, the generation runs as a job which the calling
+        /// thread polls, see WaitForGenerateJob: it receives the progress on the calling thread and can cancel the
+        /// generation, which then returns null.
+        /// </summary>
         public static GenerationResult Generate(string rpkPath,
             ref RuleAttributesMap MM,
-            List<Mesh> initialMeshes)
+            List<Mesh> initialMeshes,
+            ProxyMode proxyMode = ProxyMode.NONE,
+            double decimationRatio = 1.0,
+            double decimationError = 0.0,
+            double[] lodRatios = null,
+            Func<int, int, bool> keepWaiting = null)
         {
             SimpleArrayMeshPointer initialMeshesArray = new SimpleArrayMeshPointer();
             foreach(var mesh in initialMeshes)
@@ -125,6 +313,20 @@ namespace PumaGrasshopper
             var meshes = new SimpleArrayMeshPointer();
             var pMeshes = meshes.NonConstPointer();
 
+            double[] levelRatios = lodRatios ?? new double[0];
+            var lodMeshes = new SimpleArrayMeshPointer();
+            var pLodMeshes = lodMeshes.NonConstPointer();
+
+            // Instances
+            var prototypeCounts = new SimpleArrayInt();
+            var pPrototypeCounts = prototypeCounts.NonConstPointer();
+            var prototypeMeshes = new SimpleArrayMeshPointer();
+            var pPrototypeMeshes = prototypeMeshes.NonConstPointer();
+            var instancePrototypes = new SimpleArrayInt();
+            var pInstancePrototypes = instancePrototypes.NonConstPointer();
+            var instanceTransforms = new SimpleArrayDouble();
+            var pInstanceTransforms = instanceTransforms.NonConstPointer();
+
             var stringWrapper = new InteropWrapperString(MM.GetStringStarts(), ref MM.stringKeys, ref MM.stringValues);
             var boolWrapper = new InteropWrapperBoolean(MM.GetBoolStarts(), ref MM.boolKeys, ref MM.boolValues);
             var integerWrapper = new InteropWrapperInteger(MM.GetIntegerStarts(), ref MM.integerKeys, ref MM.integerValues);
@@ -168,54 +370,81 @@ namespace PumaGrasshopper
             var errorValuesClassArray = new ClassArrayString();
             IntPtr pErrorValuesClassArray = errorValuesClassArray.NonConstPointer();
 
-            Generate(rpkPath,
-                     initialMeshes.Count,
-                     boolWrapper.StartsPtr(),
-                     boolWrapper.Count,
-                     boolWrapper.KeysPtr(),
-                     boolWrapper.ValuesPtr(),
-                     integerWrapper.StartsPtr(),
-                     integerWrapper.Count,
-                     integerWrapper.KeysPtr(),
-                     integerWrapper.ValuesPtr(),
-                     doubleWrapper.StartsPtr(),
-                     doubleWrapper.Count,
-                     doubleWrapper.KeysPtr(),
-                     doubleWrapper.ValuesPtr(),
-                     stringWrapper.StartsPtr(),
-                     stringWrapper.Count,
-                     stringWrapper.KeysPtr(),
-                     stringWrapper.ValuesPtr(),
-                     boolArrayWrapper.StartsPtr(),
-                     boolArrayWrapper.Count,
-                     boolArrayWrapper.KeysPtr(),
-                     boolArrayWrapper.ValuesPtr(),
-                     integerArrayWrapper.StartsPtr(),
-                     integerArrayWrapper.Count,
-                     integerArrayWrapper.KeysPtr(),
-                     integerArrayWrapper.ValuesPtr(),
-                     doubleArrayWrapper.StartsPtr(),
-                     doubleArrayWrapper.Count,
-                     doubleArrayWrapper.KeysPtr(),
-                     doubleArrayWrapper.ValuesPtr(),
-                     stringArrayWrapper.StartsPtr(),
-                     stringArrayWrapper.Count,
-                     stringArrayWrapper.KeysPtr(),
-                     stringArrayWrapper.ValuesPtr(),
-                     pMeshesArray,
-                     pMeshCounts,
-                     pMeshes,
-                     pColorsArray,
-                     pMatIndices,
-                     pTexKeys,
-                     pTexPaths,
-                     pReportCountArray,
-                     pReportKeyArray,
-                     pReportDoubleArray,
-                     pReportBoolArray,
-                     pReportStringArray,
-                     pPrintCountsClassArray, pPrintValuesClassArray,
-                     pErrorCountsClassArray, pErrorValuesClassArray);
+            int jobId = -1;
+            if (keepWaiting == null)
+            {
+                Generate(rpkPath,
+                         initialMeshes.Count,
+                         boolWrapper.StartsPtr(),
+                         boolWrapper.Count,
+                         boolWrapper.KeysPtr(),
+                         boolWrapper.ValuesPtr(),
+                         integerWrapper.StartsPtr(),
+                         integerWrapper.Count,
+                         integerWrapper.KeysPtr(),
+                         integerWrapper.ValuesPtr(),
+                         doubleWrapper.StartsPtr(),
+                         doubleWrapper.Count,
+                         doubleWrapper.KeysPtr(),
+                         doubleWrapper.ValuesPtr(),
+                         stringWrapper.StartsPtr(),
+                         stringWrapper.Count,
+                         stringWrapper.KeysPtr(),
+                         stringWrapper.ValuesPtr(),
+                         boolArrayWrapper.StartsPtr(),
+                         boolArrayWrapper.Count,
+                         boolArrayWrapper.KeysPtr(),
+                         boolArrayWrapper.ValuesPtr(),
+                         integerArrayWrapper.StartsPtr(),
+                         integerArrayWrapper.Count,
+                         integerArrayWrapper.KeysPtr(),
+                         integerArrayWrapper.ValuesPtr(),
+                         doubleArrayWrapper.StartsPtr(),
+                         doubleArrayWrapper.Count,
+                         doubleArrayWrapper.KeysPtr(),
+                         doubleArrayWrapper.ValuesPtr(),
+                         stringArrayWrapper.StartsPtr(),
+                         stringArrayWrapper.Count,
+                         stringArrayWrapper.KeysPtr(),
+                         stringArrayWrapper.ValuesPtr(),
+                         pMeshesArray,
+                         (uint)proxyMode,
+                         decimationRatio,
+                         decimationError,
+                         levelRatios,
+                         levelRatios.Length,
+                         pMeshCounts,
+                         pMeshes,
+                         pLodMeshes,
+                         pPrototypeCounts,
+                         pPrototypeMeshes,
+                         pInstancePrototypes,
+                         pInstanceTransforms,
+                         pColorsArray,
+                         pMatIndices,
+                         pTexKeys,
+                         pTexPaths,
+                         pReportCountArray,
+                         pReportKeyArray,
+                         pReportDoubleArray,
+                         pReportBoolArray,
+                         pReportStringArray,
+                         pPrintCountsClassArray, pPrintValuesClassArray,
+                         pErrorCountsClassArray, pErrorValuesClassArray);
+            }
+            else
+            {
+                jobId = SubmitGenerate(rpkPath, initialMeshes.Count,
+                    boolWrapper.StartsPtr(), boolWrapper.Count, boolWrapper.KeysPtr(), boolWrapper.ValuesPtr(),
+                    integerWrapper.StartsPtr(), integerWrapper.Count, integerWrapper.KeysPtr(), integerWrapper.ValuesPtr(),
+                    doubleWrapper.StartsPtr(), doubleWrapper.Count, doubleWrapper.KeysPtr(), doubleWrapper.ValuesPtr(),
+                    stringWrapper.StartsPtr(), stringWrapper.Count, stringWrapper.KeysPtr(), stringWrapper.ValuesPtr(),
+                    boolArrayWrapper.StartsPtr(), boolArrayWrapper.Count, boolArrayWrapper.KeysPtr(), boolArrayWrapper.ValuesPtr(),
+                    integerArrayWrapper.StartsPtr(), integerArrayWrapper.Count, integerArrayWrapper.KeysPtr(), integerArrayWrapper.ValuesPtr(),
+                    doubleArrayWrapper.StartsPtr(), doubleArrayWrapper.Count, doubleArrayWrapper.KeysPtr(), doubleArrayWrapper.ValuesPtr(),
+                    stringArrayWrapper.StartsPtr(), stringArrayWrapper.Count, stringArrayWrapper.KeysPtr(), stringArrayWrapper.ValuesPtr(),
+                    pMeshesArray, (uint)proxyMode, decimationRatio, decimationError, levelRatios, levelRatios.Length);
+            }
 
             initialMeshesArray.Dispose();
             boolWrapper.Dispose();
@@ -227,24 +456,112 @@ namespace PumaGrasshopper
             doubleArrayWrapper.Dispose();
             stringArrayWrapper.Dispose();
 
+            // the job owns a copy of the inputs, only its outputs are left to fetch
+            if (keepWaiting != null)
+            {
+                if (!WaitForGenerateJob(jobId, keepWaiting))
+                    return null;
+
+                FetchGenerateResults(jobId, pMeshCounts, pMeshes, pLodMeshes,
+                    pPrototypeCounts, pPrototypeMeshes, pInstancePrototypes, pInstanceTransforms,
+                    pColorsArray, pMatIndices, pTexKeys, pTexPaths,
+                    pReportCountArray, pReportKeyArray, pReportDoubleArray, pReportBoolArray, pReportStringArray,
+                    pPrintCountsClassArray, pPrintValuesClassArray,
+                    pErrorCountsClassArray, pErrorValuesClassArray);
+            }
+
             GenerationResult generationResult = new GenerationResult();
 
-            // Geometry
-            var meshCountsArray = meshCounts.ToArray();
-            var meshesArray = meshes.ToNonConstArray();
-            int indexOffset = 0;
+            // Geometry, per shape the meshes of the generated parts are interleaved with the placed prototypes
+            var meshCountsArray = meshCounts.ToArray();
+            var meshesArray = meshes.ToNonConstArray();
+            var lodMeshesArray = lodMeshes.ToNonConstArray();
+            var prototypeCountsArray = prototypeCounts.ToArray();
+            var prototypeMeshesArray = prototypeMeshes.ToNonConstArray();
+            var instancePrototypesArray = instancePrototypes.ToArray();
+            var instanceTransformsArray = instanceTransforms.ToArray();
+            int partOffset = 0;
+            int lodOffset = 0;
+            int prototypeOffset = 0;
+            int instancePrototypeOffset = 0;
+            int transformOffset = 0;
             for (int id = 0; id < meshCountsArray.Length; id++)
-            {
-                if (meshCountsArray[id] > 0)
-                {
-                    var meshesForShape = meshesArray.Skip(indexOffset).Take(meshCountsArray[id]).ToArray();
-                    generationResult.meshes.Add(meshesForShape);
-                }
-                else
+            {
+                int meshCount = meshCountsArray[id];
+                int prototypeCount = prototypeCountsArray[id];
+                if (meshCount == 0)
+                {
                     generationResult.meshes.Add(null);
+                    generationResult.lodMeshes.Add(null);
+                    generationResult.prototypes.Add(null);
+                    generationResult.meshPrototypes.Add(null);
+                    generationResult.meshTransforms.Add(null);
+                    prototypeOffset += prototypeCount * (levelRatios.Length + 1);
+                    continue;
+                }
 
-                indexOffset += meshCountsArray[id];
-            }
+                // the prototypes are laid out level by level, starting with the full detail
+                var shapePrototypeLevels = new Mesh[levelRatios.Length + 1][];
+                for (int level = 0; level <= levelRatios.Length; level++)
+                {
+                    shapePrototypeLevels[level] = new Mesh[prototypeCount];
+                    Array.Copy(prototypeMeshesArray, prototypeOffset, shapePrototypeLevels[level], 0, prototypeCount);
+                    prototypeOffset += prototypeCount;
+                }
+
+                var shapeMeshPrototypes = new int[meshCount];
+                Array.Copy(instancePrototypesArray, instancePrototypeOffset, shapeMeshPrototypes, 0, meshCount);
+                instancePrototypeOffset += meshCount;
+
+                var shapeTransforms = new Transform[meshCount];
+                for (int meshId = 0; meshId < meshCount; meshId++)
+                {
+                    shapeTransforms[meshId] = Transform.Identity;
+                    if (shapeMeshPrototypes[meshId] < 0)
+                        continue;
+                    for (int row = 0; row < 4; row++)
+                    {
+                        for (int col = 0; col < 4; col++)
+                            shapeTransforms[meshId][row, col] = instanceTransformsArray[transformOffset + row * 4 + col];
+                    }
+                    transformOffset += 16;
+                }
+
+                int partCount = shapeMeshPrototypes.Count(prototypeId => prototypeId < 0);
+                Mesh[] PlaceMeshes(Mesh[] levelMeshesArray, int levelOffset, Mesh[] levelPrototypes)
+                {
+                    var levelMeshes = new Mesh[meshCount];
+                    int partId = 0;
+                    for (int meshId = 0; meshId < meshCount; meshId++)
+                    {
+                        int prototypeId = shapeMeshPrototypes[meshId];
+                        if (prototypeId < 0)
+                        {
+                            levelMeshes[meshId] = levelMeshesArray[levelOffset + partId++];
+                            continue;
+                        }
+                        levelMeshes[meshId] = levelPrototypes[prototypeId].DuplicateMesh();
+                        levelMeshes[meshId].Transform(shapeTransforms[meshId]);
+                    }
+                    return levelMeshes;
+                }
+
+                generationResult.meshes.Add(PlaceMeshes(meshesArray, partOffset, shapePrototypeLevels[0]));
+                partOffset += partCount;
+
+                // Levels of detail, level by level with as many part meshes as the full detail of the shape
+                var shapeLevels = new Mesh[levelRatios.Length][];
+                for (int level = 0; level < levelRatios.Length; level++)
+                {
+                    shapeLevels[level] = PlaceMeshes(lodMeshesArray, lodOffset, shapePrototypeLevels[level + 1]);
+                    lodOffset += partCount;
+                }
+                generationResult.lodMeshes.Add(shapeLevels);
+
+                generationResult.prototypes.Add(shapePrototypeLevels[0]);
+                generationResult.meshPrototypes.Add(shapeMeshPrototypes);
+                generationResult.meshTransforms.Add(shapeTransforms);
+            }
 
             // Materials
             double[] colors = colorsArray.ToArray();
@@ -415,6 +732,25 @@ namespace PumaGrasshopper
             return generationResult;
         }
 
+        /// <summary>
+        /// Starts loading the rule package (and evaluating the default values of the initial meshes, if any) in the
+        /// background, so that the next calls for it do not block the UI as long.
+        /// </summary>
+        public static void PrefetchRulePackage(string rulePkg, List<Mesh> initialMeshes)
+        {
+            SimpleArrayMeshPointer initialMeshesArray = new SimpleArrayMeshPointer();
+            if (initialMeshes != null)
+            {
+                foreach (var mesh in initialMeshes)
+                {
+                    initialMeshesArray.Add(mesh, true);
+                }
+            }
+
+            PrefetchRulePackage(rulePkg, initialMeshesArray.ConstPointer());
+            initialMeshesArray.Dispose();
+        }
+
         public static AttributesValuesMap[] GetDefaultValues(string rulePkg, List<Mesh> initialMeshes)
         {
             SimpleArrayMeshPointer initialMeshesArray = new SimpleArrayMeshPointer();
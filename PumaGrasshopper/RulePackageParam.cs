@@ -106,6 +106,9 @@ namespace PumaGrasshopper
                     return GH_GetterResult.cancel;
                 }
 
+                // start loading the rule package while the solution is being expired
+                PRTWrapper.PrefetchRulePackage(fd.FileName, null);
+
                 value = new GH_String(relPath);
                 return GH_GetterResult.success;
             }
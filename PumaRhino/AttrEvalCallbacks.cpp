@@ -87,7 +87,7 @@ prt::Status AttrEvalCallbacks::attrBool(size_t isIndex, int32_t /*shapeID*/, con
 	if (DBG)
 		LOG_DBG << "attrBool: isIndex = " << isIndex << ", key = " << key << " = " << value;
 	if (mRuleFileInfo && !isHiddenAttribute(mRuleFileInfo, key))
-		mAMBS[isIndex]->setBool(key, value);
+		mAMBS[mIsIndexOffset + isIndex]->setBool(key, value);
 	return prt::STATUS_OK;
 }
 
@@ -95,7 +95,7 @@ prt::Status AttrEvalCallbacks::attrFloat(size_t isIndex, int32_t /*shapeID*/, co
 	if (DBG)
 		LOG_DBG << "attrFloat: isIndex = " << isIndex << ", key = " << key << " = " << value;
 	if (mRuleFileInfo && !isHiddenAttribute(mRuleFileInfo, key))
-		mAMBS[isIndex]->setFloat(key, value);
+		mAMBS[mIsIndexOffset + isIndex]->setFloat(key, value);
 	return prt::STATUS_OK;
 }
 
@@ -104,7 +104,7 @@ prt::Status AttrEvalCallbacks::attrString(size_t isIndex, int32_t /*shapeID*/, c
 	if (DBG)
 		LOG_DBG << "attrString: isIndex = " << isIndex << ", key = " << key << " = " << value;
 	if (mRuleFileInfo && !isHiddenAttribute(mRuleFileInfo, key))
-		mAMBS[isIndex]->setString(key, value);
+		mAMBS[mIsIndexOffset + isIndex]->setString(key, value);
 	return prt::STATUS_OK;
 }
 
@@ -113,7 +113,7 @@ prt::Status AttrEvalCallbacks::attrBoolArray(size_t isIndex, int32_t /*shapeID*/
 	if (DBG)
 		LOG_DBG << "attrBoolArray: isIndex = " << isIndex << ", key = " << key << " = " << *ptr << " size = " << size;
 	if (mRuleFileInfo && !isHiddenAttribute(mRuleFileInfo, key))
-		mAMBS[isIndex]->setBoolArray(key, ptr, size);
+		mAMBS[mIsIndexOffset + isIndex]->setBoolArray(key, ptr, size);
 	return prt::STATUS_OK;
 }
 
@@ -122,7 +122,7 @@ prt::Status AttrEvalCallbacks::attrFloatArray(size_t isIndex, int32_t /*shapeID*
 	if (DBG)
 		LOG_DBG << "attrFloatArray: isIndex = " << isIndex << ", key = " << key << " = " << *ptr << " size = " << size;
 	if (mRuleFileInfo && !isHiddenAttribute(mRuleFileInfo, key))
-		mAMBS[isIndex]->setFloatArray(key, ptr, size);
+		mAMBS[mIsIndexOffset + isIndex]->setFloatArray(key, ptr, size);
 	return prt::STATUS_OK;
 }
 
@@ -131,6 +131,6 @@ prt::Status AttrEvalCallbacks::attrStringArray(size_t isIndex, int32_t /*shapeID
 	if (DBG)
 		LOG_DBG << "attrStringArray: isIndex = " << isIndex << ", key = " << key << " = " << *ptr << " size = " << size;
 	if (mRuleFileInfo && !isHiddenAttribute(mRuleFileInfo, key))
-		mAMBS[isIndex]->setStringArray(key, ptr, size);
+		mAMBS[mIsIndexOffset + isIndex]->setStringArray(key, ptr, size);
 	return prt::STATUS_OK;
 }
@@ -27,8 +27,13 @@
 
 class AttrEvalCallbacks : public prt::Callbacks {
 public:
-	explicit AttrEvalCallbacks(pcu::AttributeMapBuilderVector& ambs, pcu::RuleFileInfoPtr& ruleFileInfo)
-	    : mAMBS(ambs), mRuleFileInfo(ruleFileInfo) {}
+	/**
+	 * @param isIndexOffset position of the first generated initial shape in ambs, used if only a range of the shapes
+	 * is passed to prt::generate
+	 */
+	explicit AttrEvalCallbacks(pcu::AttributeMapBuilderVector& ambs, pcu::RuleFileInfoPtr& ruleFileInfo,
+	                           size_t isIndexOffset = 0)
+	    : mAMBS(ambs), mRuleFileInfo(ruleFileInfo), mIsIndexOffset(isIndexOffset) {}
 	~AttrEvalCallbacks() override = default;
 
 	// Inherited via Callbacks
@@ -54,4 +59,5 @@ public:
 private:
 	pcu::AttributeMapBuilderVector& mAMBS;
 	pcu::RuleFileInfoPtr& mRuleFileInfo;
+	const size_t mIsIndexOffset;
 };
@@ -30,58 +30,113 @@
 #include "GeneratedModel.h"
 #include "RawInitialShape.h"
 #include "Logger.h"
+#include "utils.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 namespace {
 
-ON_Mesh toON_Mesh(const ModelPart& modelPart, const std::wstring& idKey) {
-	ON_Mesh mesh(static_cast<int>(modelPart.mFaces.size()), static_cast<int>(modelPart.mIndices.size()), true, true);
-
-	for (size_t v_id = 0; v_id < modelPart.mIndices.size(); ++v_id) {
-		auto index = modelPart.mIndices[v_id];
-		mesh.SetVertex(static_cast<int>(v_id),
-		               ON_3dPoint(modelPart.mVertices[index * 3], -modelPart.mVertices[index * 3 + 2],
-		                          modelPart.mVertices[index * 3 + 1]));
-		mesh.SetVertexNormal(static_cast<int>(v_id),
-		                     ON_3dVector(modelPart.mNormals[index * 3], -modelPart.mNormals[index * 3 + 2],
-		                                 modelPart.mNormals[index * 3 + 1]));
+const std::wstring LOD_LEVEL_KEY = L"LodLevel";
+
+/**
+ * Converts the model part, or one of its coarser levels of detail, whose faces index the vertices of the part. All
+ * vertices are moved by the translation, single precision vertices are relative to the local origin in addition.
+ */
+ON_Mesh toON_Mesh(const ModelPart& modelPart, const std::array<double, 3>& localOrigin,
+                  const std::array<double, 3>& translation, const std::wstring& idKey, size_t level = 0) {
+	const ModelPart& faces =
+	        (level > 0 && !modelPart.mLevels.empty()) ? modelPart.mLevels[std::min(level, modelPart.mLevels.size()) - 1]
+	                                                  : modelPart;
+
+	const bool singlePrecision = !modelPart.mLocalVertices.empty();
+
+	// welded parts share their vertices between the faces, otherwise every face corner gets its own vertex
+	const size_t sharedVertexCount =
+	        (singlePrecision ? modelPart.mLocalVertices.size() : modelPart.mVertices.size()) / 3;
+	const size_t vertexCount = modelPart.mIndexed ? sharedVertexCount : modelPart.mIndices.size();
+	auto getCorner = [&modelPart, &faces](int corner) {
+		return modelPart.mIndexed ? static_cast<int>(faces.mIndices[corner]) : corner;
+	};
+
+	// the normals are not encoded if their output channel is off, Rhino computes them when it needs them
+	const bool hasNormals = !(singlePrecision ? modelPart.mLocalNormals.empty() : modelPart.mNormals.empty());
+
+	ON_Mesh mesh(static_cast<int>(faces.mFaces.size()), static_cast<int>(vertexCount), hasNormals, true);
+
+	if (singlePrecision) {
+		// the vertices are restored in double precision, the single precision vertices only carry the local offsets
+		const std::array<double, 3> origin = {localOrigin[0] + translation[0], localOrigin[1] + translation[1],
+		                                      localOrigin[2] + translation[2]};
+		for (size_t v_id = 0; v_id < vertexCount; ++v_id) {
+			const size_t index = modelPart.mIndexed ? v_id : modelPart.mIndices[v_id];
+			const float* vertex = &modelPart.mLocalVertices[index * 3];
+			mesh.SetVertex(static_cast<int>(v_id),
+			               ON_3dPoint(origin[0] + vertex[0], -(origin[2] + vertex[2]), origin[1] + vertex[1]));
+			if (hasNormals) {
+				const float* normal = &modelPart.mLocalNormals[index * 3];
+				mesh.SetVertexNormal(static_cast<int>(v_id), ON_3fVector(normal[0], -normal[2], normal[1]));
+			}
+		}
+	}
+	else {
+		for (size_t v_id = 0; v_id < vertexCount; ++v_id) {
+			const size_t index = modelPart.mIndexed ? v_id : modelPart.mIndices[v_id];
+			const double* vertex = &modelPart.mVertices[index * 3];
+			mesh.SetVertex(static_cast<int>(v_id),
+			               ON_3dPoint(vertex[0] + translation[0], -(vertex[2] + translation[2]),
+			                          vertex[1] + translation[1]));
+			if (hasNormals) {
+				mesh.SetVertexNormal(static_cast<int>(v_id),
+				                     ON_3dVector(modelPart.mNormals[index * 3], -modelPart.mNormals[index * 3 + 2],
+				                                 modelPart.mNormals[index * 3 + 1]));
+			}
+		}
 	}
 
 	int faceid(0);
 	int currindex(0);
-	for (int faceVertexCount : modelPart.mFaces) {
+	size_t triangleIndex(0);
+	for (int faceVertexCount : faces.mFaces) {
 		if (faceVertexCount == 3) {
-			mesh.SetTriangle(faceid++, currindex, currindex + 1, currindex + 2);
+			mesh.SetTriangle(faceid++, getCorner(currindex), getCorner(currindex + 1), getCorner(currindex + 2));
 		}
 		else if (faceVertexCount == 4) {
-			mesh.SetQuad(faceid++, currindex, currindex + 1, currindex + 2, currindex + 3);
+			mesh.SetQuad(faceid++, getCorner(currindex), getCorner(currindex + 1), getCorner(currindex + 2),
+			             getCorner(currindex + 3));
 		}
 		else {
-			ON_SimpleArray<int> triangleIndices((faceVertexCount - 2) * 3);
-			triangleIndices.SetCount(triangleIndices.Capacity());
-			int rc = RhinoTriangulate3dPolygon(faceVertexCount, 3, mesh.m_dV[currindex], 3, triangleIndices.Array());
-			if (rc >= 0) {
-				int triangle_count = triangleIndices.Count() / 3;
-				for (int i = 0; i < triangle_count; i++) {
-					mesh.SetTriangle(faceid++, currindex + triangleIndices[3 * i],
-					                 currindex + triangleIndices[(3 * i) + 1],
-					                 currindex + triangleIndices[(3 * i) + 2]);
+			// larger polygons have been triangulated by the encoder, the triangles are corner offsets within the face
+			const size_t triangleIndicesCount = 3 * static_cast<size_t>(faceVertexCount - 2);
+			if (triangleIndex + triangleIndicesCount <= faces.mPolygonTriangles.size()) {
+				const uint32_t* triangles = &faces.mPolygonTriangles[triangleIndex];
+				for (size_t i = 0; i < triangleIndicesCount; i += 3) {
+					mesh.SetTriangle(faceid++, getCorner(currindex + triangles[i]),
+					                 getCorner(currindex + triangles[i + 1]), getCorner(currindex + triangles[i + 2]));
 				}
 			}
 			else {
-				LOG_ERR << "Rhino failed to triangulate a generated polygon from shape " << idKey;
+				LOG_ERR << "Missing triangulation of a generated polygon from shape " << idKey;
 			}
+			triangleIndex += triangleIndicesCount;
 		}
 		currindex += faceVertexCount;
 	}
 
+	// welding can collapse faces which are smaller than the tolerance
+	if (modelPart.mIndexed)
+		mesh.CullDegenerateFaces();
+
 	for (int i = 0; i < modelPart.mUVs.Count(); ++i) {
 		mesh.SetTextureCoord(i, modelPart.mUVs[i].x, modelPart.mUVs[i].y);
 	}
 
+	// the coarser levels only use a subset of the vertices
 	mesh.Compact();
 	mesh.SetUserString(INIT_SHAPE_ID_KEY.c_str(), idKey.c_str());
+	if (level > 0)
+		mesh.SetUserString(LOD_LEVEL_KEY.c_str(), std::to_wstring(level).c_str());
 
 	// Printing a rhino error log if the created mesh is invalid
 	ON_wString log_str;
@@ -94,15 +149,117 @@ ON_Mesh toON_Mesh(const ModelPart& modelPart, const std::wstring& idKey) {
 	return mesh;
 }
 
+/**
+ * Applies the column-major transformation to the prototype geometry. Normals are transformed with the cofactor matrix
+ * of the linear part, which keeps them perpendicular under non-uniform scaling.
+ */
+ModelPart transformModelPart(const ModelPart& prototype, const std::array<double, 16>& m) {
+	ModelPart part = prototype;
+
+	for (size_t i = 0; i + 2 < part.mVertices.size(); i += 3) {
+		const double x = prototype.mVertices[i];
+		const double y = prototype.mVertices[i + 1];
+		const double z = prototype.mVertices[i + 2];
+		part.mVertices[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+		part.mVertices[i + 1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+		part.mVertices[i + 2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+	}
+
+	// cofactor matrix C of the upper 3x3 part A (row-major), C = det(A) * inverse(A)^T
+	const double c[9] = {m[5] * m[10] - m[9] * m[6],  m[9] * m[2] - m[1] * m[10], m[1] * m[6] - m[5] * m[2],
+	                     m[8] * m[6] - m[4] * m[10], m[0] * m[10] - m[8] * m[2], m[4] * m[2] - m[0] * m[6],
+	                     m[4] * m[9] - m[8] * m[5],  m[8] * m[1] - m[0] * m[9],  m[0] * m[5] - m[4] * m[1]};
+
+	for (size_t i = 0; i + 2 < part.mNormals.size(); i += 3) {
+		const double x = prototype.mNormals[i];
+		const double y = prototype.mNormals[i + 1];
+		const double z = prototype.mNormals[i + 2];
+		const double nx = c[0] * x + c[1] * y + c[2] * z;
+		const double ny = c[3] * x + c[4] * y + c[5] * z;
+		const double nz = c[6] * x + c[7] * y + c[8] * z;
+		const double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+		const double scale = (length > 0.0) ? 1.0 / length : 0.0;
+		part.mNormals[i] = nx * scale;
+		part.mNormals[i + 1] = ny * scale;
+		part.mNormals[i + 2] = nz * scale;
+	}
+
+	return part;
+}
+
+/**
+ * Converts the column-major PRT transformation of an instance, moved by the translation, into a Rhino transformation of
+ * the prototype mesh created by toON_Mesh.
+ */
+ON_Xform toRhinoTransform(const std::array<double, 16>& m, const std::array<double, 3>& translation) {
+	ON_Xform transform;
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++)
+			transform.m_xform[row][col] = m[col * 4 + row];
+	}
+	for (int row = 0; row < 3; row++)
+		transform.m_xform[row][3] += translation[row];
+
+	// toON_Mesh maps the PRT axes (x, y, z) to the Rhino axes (x, -z, y)
+	ON_Xform toRhinoAxes = ON_Xform::IdentityTransformation;
+	toRhinoAxes.m_xform[1][1] = 0.0;
+	toRhinoAxes.m_xform[1][2] = -1.0;
+	toRhinoAxes.m_xform[2][1] = 1.0;
+	toRhinoAxes.m_xform[2][2] = 0.0;
+	ON_Xform toPrtAxes = toRhinoAxes;
+	toPrtAxes.Transpose();
+
+	return toRhinoAxes * transform * toPrtAxes;
+}
+
+/**
+ * Calls onPart or onInstance for the model parts and the instances in the order of their PRT instances, i.e. the order
+ * of their materials.
+ */
+template <typename OnPart, typename OnInstance>
+void forEachPartAndInstance(const ModelGeometry& geometry, OnPart onPart, OnInstance onInstance,
+                            const std::wstring& idKey) {
+	auto part = geometry.mModelParts.begin();
+	auto instance = geometry.mInstances.begin();
+	while (part != geometry.mModelParts.end() || instance != geometry.mInstances.end()) {
+		if (instance == geometry.mInstances.end() ||
+		    (part != geometry.mModelParts.end() && part->mInstanceIndex < instance->mInstanceIndex)) {
+			onPart(*part);
+			++part;
+			continue;
+		}
+
+		const auto prototype = geometry.mPrototypes.find(instance->mPrototypeIndex);
+		if (prototype != geometry.mPrototypes.end())
+			onInstance(prototype->second, *instance);
+		else
+			LOG_WRN << "Instance of unknown prototype " << instance->mPrototypeIndex << " in shape " << idKey;
+		++instance;
+	}
+}
+
+size_t getModelPartMemoryUsage(const ModelPart& part) {
+	size_t bytes = sizeof(ModelPart);
+	bytes += (part.mVertices.capacity() + part.mNormals.capacity()) * sizeof(double);
+	bytes += (part.mLocalVertices.capacity() + part.mLocalNormals.capacity()) * sizeof(float);
+	bytes += (part.mIndices.capacity() + part.mFaces.capacity() + part.mUVIndices.capacity() +
+	          part.mUVCounts.capacity() + part.mPolygonTriangles.capacity()) *
+	         sizeof(uint32_t);
+	bytes += static_cast<size_t>(part.mUVs.Capacity()) * sizeof(ON_2fPoint);
+	for (const ModelPart& level : part.mLevels)
+		bytes += getModelPartMemoryUsage(level);
+	return bytes;
+}
+
 } // namespace
 
 ModelPart& GeneratedModel::addModelPart() {
-	mModelParts.push_back(ModelPart());
-	return mModelParts.back();
+	mGeometry->mModelParts.push_back(ModelPart());
+	return mGeometry->mModelParts.back();
 }
 
 const std::vector<ModelPart>& GeneratedModel::getModelParts() const {
-	return mModelParts;
+	return mGeometry->mModelParts;
 }
 
 int GeneratedModel::getMeshPartCount() const {
@@ -110,7 +267,37 @@ int GeneratedModel::getMeshPartCount() const {
 }
 
 ModelPart& GeneratedModel::getCurrentModelPart() {
-	return mModelParts.back();
+	return mGeometry->mModelParts.back();
+}
+
+void GeneratedModel::setLocalOrigin(const std::array<double, 3>& origin) {
+	mGeometry->mLocalOrigin = origin;
+}
+
+const std::array<double, 3>& GeneratedModel::getLocalOrigin() const {
+	return mGeometry->mLocalOrigin;
+}
+
+ModelPart& GeneratedModel::addPrototype(size_t prototypeIndex) {
+	ModelPart& prototype = mGeometry->mPrototypes[prototypeIndex];
+	prototype = ModelPart();
+	return prototype;
+}
+
+ModelPart& GeneratedModel::getPrototype(size_t prototypeIndex) {
+	return mGeometry->mPrototypes.at(prototypeIndex);
+}
+
+const std::map<size_t, ModelPart>& GeneratedModel::getPrototypes() const {
+	return mGeometry->mPrototypes;
+}
+
+void GeneratedModel::addInstance(const ModelInstance& instance) {
+	mGeometry->mInstances.push_back(instance);
+}
+
+const std::vector<ModelInstance>& GeneratedModel::getInstances() const {
+	return mGeometry->mInstances;
 }
 
 void GeneratedModel::addReport(const Reporting::ReportAttribute& ra) {
@@ -147,14 +334,100 @@ void GeneratedModel::addMaterial(const Materials::MaterialAttribute& ma) {
 }
 
 const GeneratedModel::MeshBundle GeneratedModel::createRhinoMeshes(size_t initialShapeIndex) const {
-	if (mModelParts.empty())
-		return {};
-	
+	return std::move(createRhinoLevelMeshes(initialShapeIndex, 0).front());
+}
+
+std::vector<GeneratedModel::MeshBundle> GeneratedModel::createRhinoLevelMeshes(size_t initialShapeIndex,
+                                                                               size_t levelCount) const {
+	std::vector<MeshBundle> levels(levelCount + 1);
+	const ModelGeometry& geometry = *mGeometry;
+	if (geometry.mModelParts.empty() && geometry.mInstances.empty())
+		return levels;
+
 	const std::wstring idKey = std::to_wstring(initialShapeIndex);
 
-	MeshBundle mesh;
-	mesh.reserve(mModelParts.size());
-	std::transform(mModelParts.begin(), mModelParts.end(), std::back_inserter(mesh),
-	               [this, &idKey](const ModelPart& part) -> ON_Mesh { return toON_Mesh(part, idKey); });
-	return mesh;
+	for (MeshBundle& mesh : levels)
+		mesh.reserve(geometry.mModelParts.size() + geometry.mInstances.size());
+
+	forEachPartAndInstance(
+	        geometry,
+	        [&](const ModelPart& part) {
+		        for (size_t level = 0; level <= levelCount; ++level)
+			        levels[level].push_back(toON_Mesh(part, geometry.mLocalOrigin, mTranslation, idKey, level));
+	        },
+	        [&](const ModelPart& prototype, const ModelInstance& instance) {
+		        // the levels index the vertices of the full detail, the instance is transformed once for all of them
+		        const ModelPart transformed = transformModelPart(prototype, instance.mTransformation);
+		        for (size_t level = 0; level <= levelCount; ++level)
+			        levels[level].push_back(toON_Mesh(transformed, {}, mTranslation, idKey, level));
+	        },
+	        idKey);
+	return levels;
+}
+
+GeneratedModel::InstancedMeshBundle GeneratedModel::createRhinoInstancedMeshes(size_t initialShapeIndex,
+                                                                               size_t levelCount) const {
+	InstancedMeshBundle meshes;
+	meshes.partLevels.resize(levelCount + 1);
+	meshes.prototypeLevels.resize(levelCount + 1);
+	const ModelGeometry& geometry = *mGeometry;
+	if (geometry.mModelParts.empty() && geometry.mInstances.empty())
+		return meshes;
+
+	const std::wstring idKey = std::to_wstring(initialShapeIndex);
+
+	// each prototype is converted once, in its own coordinate system, by the first of its instances
+	std::map<size_t, int> prototypePositions;
+	meshes.meshPrototypes.reserve(geometry.mModelParts.size() + geometry.mInstances.size());
+	meshes.instanceTransforms.reserve(geometry.mInstances.size());
+	forEachPartAndInstance(
+	        geometry,
+	        [&](const ModelPart& part) {
+		        for (size_t level = 0; level <= levelCount; ++level)
+			        meshes.partLevels[level].push_back(
+			                toON_Mesh(part, geometry.mLocalOrigin, mTranslation, idKey, level));
+		        meshes.meshPrototypes.push_back(-1);
+	        },
+	        [&](const ModelPart& prototype, const ModelInstance& instance) {
+		        const auto [position, isNew] = prototypePositions.try_emplace(
+		                instance.mPrototypeIndex, static_cast<int>(meshes.prototypeLevels.front().size()));
+		        if (isNew) {
+			        for (size_t level = 0; level <= levelCount; ++level)
+				        meshes.prototypeLevels[level].push_back(toON_Mesh(prototype, {}, {}, idKey, level));
+		        }
+		        meshes.meshPrototypes.push_back(position->second);
+		        meshes.instanceTransforms.push_back(toRhinoTransform(instance.mTransformation, mTranslation));
+	        },
+	        idKey);
+	return meshes;
+}
+
+size_t GeneratedModel::getMemoryUsage() const {
+	const ModelGeometry& geometry = *mGeometry;
+	size_t bytes = sizeof(GeneratedModel) + sizeof(ModelGeometry);
+	for (const ModelPart& part : geometry.mModelParts)
+		bytes += getModelPartMemoryUsage(part);
+	for (const auto& prototype : geometry.mPrototypes)
+		bytes += sizeof(prototype.first) + getModelPartMemoryUsage(prototype.second);
+	bytes += geometry.mInstances.capacity() * sizeof(ModelInstance);
+	for (const auto& report : mReports)
+		bytes += sizeof(report) + (report.first.size() + report.second.mStringReport.size()) * sizeof(wchar_t);
+	for (const auto& material : mMaterials) {
+		bytes += sizeof(material);
+		for (const auto& texture : material.second.mTexturePaths)
+			bytes += (texture.first.size() + texture.second.size()) * sizeof(wchar_t);
+	}
+	for (const std::wstring& print : mPrints)
+		bytes += sizeof(print) + print.size() * sizeof(wchar_t);
+	for (const std::wstring& error : mErrors)
+		bytes += sizeof(error) + error.size() * sizeof(wchar_t);
+	return bytes;
+}
+
+std::shared_ptr<GeneratedModel> GeneratedModel::createTranslatedCopy(const std::array<double, 3>& offset) const {
+	// only the reports, materials, prints and errors are copied, the copy shares the geometry
+	auto translatedModel = std::make_shared<GeneratedModel>(*this);
+	for (size_t i = 0; i < offset.size(); i++)
+		translatedModel->mTranslation[i] += offset[i];
+	return translatedModel;
 }
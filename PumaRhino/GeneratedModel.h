@@ -22,17 +22,59 @@
 #include "MaterialAttribute.h"
 #include "ReportAttribute.h"
 
+#include <array>
+#include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
 struct ModelPart {
 	std::vector<double> mVertices;
 	std::vector<double> mNormals;
+
+	// single precision mode: vertices relative to the local origin of the model, mVertices and mNormals stay empty
+	std::vector<float> mLocalVertices;
+	std::vector<float> mLocalNormals;
 	std::vector<uint32_t> mIndices;
 	std::vector<uint32_t> mFaces;
 	ON_2fPointArray mUVs;
 	std::vector<uint32_t> mUVIndices;
 	std::vector<uint32_t> mUVCounts;
+
+	// triangulation of the faces with more than 4 corners, computed by the encoder: (n - 2) triangles per face, as
+	// corner offsets within the face
+	std::vector<uint32_t> mPolygonTriangles;
+
+	// welded mesh: mIndices refers to shared vertices and mUVs holds one texture coordinate per vertex, otherwise each
+	// face corner becomes a vertex of its own
+	bool mIndexed = false;
+
+	// index of the PRT instance the part was encoded from, it orders the parts and instances of a model and keys their
+	// materials
+	size_t mInstanceIndex = 0;
+
+	// coarser levels of detail, the first one is level 1. They only hold triangles (mIndices and mFaces) which index
+	// the vertices of this part, their vertex buffers stay empty
+	std::vector<ModelPart> mLevels;
+};
+
+/**
+ * Placement of a prototype, the transformation is a column-major 4x4 matrix in the PRT coordinate system.
+ */
+struct ModelInstance {
+	size_t mPrototypeIndex = 0;
+	size_t mInstanceIndex = 0; // see ModelPart::mInstanceIndex
+	std::array<double, 16> mTransformation{};
+};
+
+/**
+ * The mesh buffers of a model, shared between the model and its translated copies.
+ */
+struct ModelGeometry {
+	std::vector<ModelPart> mModelParts;
+	std::array<double, 3> mLocalOrigin{};
+	std::map<size_t, ModelPart> mPrototypes;
+	std::vector<ModelInstance> mInstances;
 };
 
 class GeneratedModel final {
@@ -45,6 +87,19 @@ public:
 	int getMeshPartCount() const;
 	ModelPart& getCurrentModelPart();
 
+	/**
+	 * Origin of the single precision vertices of the model parts (PRT coordinate system).
+	 */
+	void setLocalOrigin(const std::array<double, 3>& origin);
+	const std::array<double, 3>& getLocalOrigin() const;
+
+	ModelPart& addPrototype(size_t prototypeIndex);
+	ModelPart& getPrototype(size_t prototypeIndex);
+	const std::map<size_t, ModelPart>& getPrototypes() const;
+
+	void addInstance(const ModelInstance& instance);
+	const std::vector<ModelInstance>& getInstances() const;
+
 	void addMaterial(const Materials::MaterialAttribute& ma);
 	const Materials::MaterialsMap& getMaterials() const;
 
@@ -58,10 +113,50 @@ public:
 	const std::vector<std::wstring>& getErrors() const;
 
 	using MeshBundle = std::vector<ON_Mesh>;
+
+	/**
+	 * Creates the Rhino meshes of the model parts and one mesh per instance (prototype geometry transformed into
+	 * place), in the order of their PRT instances, i.e. the order of their materials.
+	 */
 	const MeshBundle createRhinoMeshes(size_t initialShapeIndex) const;
 
+	/**
+	 * Creates the meshes of the full detail and of the levels 1 to levelCount, see createRhinoMeshes. Parts with fewer
+	 * levels use their coarsest one, so all levels have the same meshes in the same order.
+	 */
+	std::vector<MeshBundle> createRhinoLevelMeshes(size_t initialShapeIndex, size_t levelCount) const;
+
+	/**
+	 * The meshes of createRhinoLevelMeshes with the instances kept as placements of their prototypes, each prototype
+	 * is converted once.
+	 */
+	struct InstancedMeshBundle {
+		std::vector<MeshBundle> partLevels;      // per level, the meshes of the model parts
+		std::vector<MeshBundle> prototypeLevels; // per level, the meshes of the prototypes in their own coordinates
+
+		// per part and instance in the order of their materials: -1 for a part, else the index of the prototype
+		std::vector<int> meshPrototypes;
+		std::vector<ON_Xform> instanceTransforms; // per instance, moves the prototype mesh into place
+	};
+	InstancedMeshBundle createRhinoInstancedMeshes(size_t initialShapeIndex, size_t levelCount) const;
+
+	/**
+	 * Approximate heap size of the model in bytes, used to budget caches.
+	 */
+	size_t getMemoryUsage() const;
+
+	/**
+	 * Copy of the model with all vertices moved by the offset (PRT coordinate system). The copy shares the mesh buffers
+	 * of this model, the offset is only applied when its Rhino meshes are created. Copies are not meant to be cached,
+	 * the caches keep the untranslated model.
+	 */
+	std::shared_ptr<GeneratedModel> createTranslatedCopy(const std::array<double, 3>& offset) const;
+
 private:
-	std::vector<ModelPart> mModelParts;
+	friend class GeneratedModelDiskCache; // (de)serializes the model buffers
+
+	std::shared_ptr<ModelGeometry> mGeometry = std::make_shared<ModelGeometry>(); // shared by copies of the model
+	std::array<double, 3> mTranslation{}; // applied to all vertices when the Rhino meshes are created
 	Reporting::ReportMap mReports;
 	Materials::MaterialsMap mMaterials;
 	std::vector<std::wstring> mPrints;
@@ -0,0 +1,182 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef _MSC_VER
+#	pragma warning(push)
+#	pragma warning(disable : 26451)
+#	pragma warning(disable : 26495)
+#endif
+#include "stdafx.h"
+#ifdef _MSC_VER
+#	pragma warning(pop)
+#endif
+
+#include "GeneratedModelCache.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <vector>
+
+namespace {
+
+void addAttribute(pcu::Hasher& hasher, const prt::AttributeMap& attributes, const wchar_t* key) {
+	const prt::AttributeMap::PrimitiveType type = attributes.getType(key);
+	hasher.add(std::wstring(key));
+	hasher.add(static_cast<int32_t>(type));
+
+	size_t count = 0;
+	switch (type) {
+		case prt::AttributeMap::PT_BOOL:
+			hasher.add(attributes.getBool(key));
+			break;
+		case prt::AttributeMap::PT_INT:
+			hasher.add(attributes.getInt(key));
+			break;
+		case prt::AttributeMap::PT_FLOAT:
+			hasher.add(attributes.getFloat(key));
+			break;
+		case prt::AttributeMap::PT_STRING:
+			hasher.add(std::wstring(attributes.getString(key)));
+			break;
+		case prt::AttributeMap::PT_BOOL_ARRAY: {
+			const bool* values = attributes.getBoolArray(key, &count);
+			hasher.add(values, count);
+			break;
+		}
+		case prt::AttributeMap::PT_INT_ARRAY: {
+			const int32_t* values = attributes.getIntArray(key, &count);
+			hasher.add(values, count);
+			break;
+		}
+		case prt::AttributeMap::PT_FLOAT_ARRAY: {
+			const double* values = attributes.getFloatArray(key, &count);
+			hasher.add(values, count);
+			break;
+		}
+		case prt::AttributeMap::PT_STRING_ARRAY: {
+			const wchar_t* const* values = attributes.getStringArray(key, &count);
+			hasher.add(count);
+			for (size_t i = 0; i < count; i++)
+				hasher.add(std::wstring(values[i]));
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+} // namespace
+
+GeneratedModelCache::GeneratedModelCache(size_t byteBudget) : mByteBudget(byteBudget) {}
+
+uint64_t GeneratedModelCache::getRulePackageKey(const std::wstring& rulePkg,
+                                                std::chrono::system_clock::time_point timeStamp) {
+	pcu::Hasher hasher;
+	hasher.add(rulePkg);
+	hasher.add(static_cast<int64_t>(timeStamp.time_since_epoch().count()));
+	return hasher.get();
+}
+
+GeneratedModelCache::Key GeneratedModelCache::createKey(uint64_t rulePackageKey, const std::wstring& ruleFile,
+                                                        const std::wstring& startRule, int32_t seed,
+                                                        const std::wstring& shapeName,
+                                                        const prt::AttributeMap* shapeAttributes,
+                                                        uint64_t geometryHash) {
+	pcu::Hasher hasher;
+	hasher.add(rulePackageKey).add(ruleFile).add(startRule).add(seed).add(shapeName).add(geometryHash);
+
+	if (shapeAttributes != nullptr) {
+		size_t keyCount = 0;
+		const wchar_t* const* keys = shapeAttributes->getKeys(&keyCount);
+		std::vector<const wchar_t*> sortedKeys(keys, keys + keyCount);
+		std::sort(sortedKeys.begin(), sortedKeys.end(),
+		          [](const wchar_t* a, const wchar_t* b) { return std::wcscmp(a, b) < 0; });
+
+		hasher.add(keyCount);
+		for (const wchar_t* key : sortedKeys)
+			addAttribute(hasher, *shapeAttributes, key);
+	}
+
+	return hasher.get();
+}
+
+GeneratedModelPtr GeneratedModelCache::get(Key key) {
+	const auto it = mIndex.find(key);
+	if (it == mIndex.end()) {
+		mMisses++;
+		return {};
+	}
+
+	mHits++;
+	mEntries.splice(mEntries.begin(), mEntries, it->second);
+	return it->second->model;
+}
+
+void GeneratedModelCache::put(Key key, const GeneratedModelPtr& model) {
+	if (!model)
+		return;
+
+	const auto it = mIndex.find(key);
+	if (it != mIndex.end()) {
+		mByteSize -= it->second->bytes;
+		mEntries.erase(it->second);
+		mIndex.erase(it);
+	}
+
+	const size_t bytes = model->getMemoryUsage();
+	if (bytes > mByteBudget)
+		return;
+
+	evict(mByteBudget - bytes);
+	mEntries.push_front({key, model, bytes});
+	mIndex.emplace(key, mEntries.begin());
+	mByteSize += bytes;
+}
+
+void GeneratedModelCache::clear() {
+	mEntries.clear();
+	mIndex.clear();
+	mByteSize = 0;
+}
+
+size_t GeneratedModelCache::getHits() const {
+	return mHits;
+}
+
+size_t GeneratedModelCache::getMisses() const {
+	return mMisses;
+}
+
+size_t GeneratedModelCache::getEntryCount() const {
+	return mEntries.size();
+}
+
+size_t GeneratedModelCache::getByteSize() const {
+	return mByteSize;
+}
+
+void GeneratedModelCache::evict(size_t byteBudget) {
+	while (mByteSize > byteBudget && !mEntries.empty()) {
+		const Entry& lru = mEntries.back();
+		mByteSize -= lru.bytes;
+		mIndex.erase(lru.key);
+		mEntries.pop_back();
+	}
+}
@@ -0,0 +1,91 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "GeneratedModel.h"
+
+#include "prt/AttributeMap.h"
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+/**
+ * In-memory LRU cache of generated models, keyed by the content of everything which determines the generation result
+ * of an initial shape: rule package (path and modification time), rule file, start rule, seed, shape name, rule
+ * attributes and initial shape geometry. Allows to skip PRT for shapes which did not change between two solves.
+ */
+class GeneratedModelCache final {
+public:
+	using Key = uint64_t;
+
+	static constexpr size_t DEFAULT_BYTE_BUDGET = 512 * 1024 * 1024;
+
+	explicit GeneratedModelCache(size_t byteBudget = DEFAULT_BYTE_BUDGET);
+	GeneratedModelCache(const GeneratedModelCache&) = delete;
+	GeneratedModelCache& operator=(const GeneratedModelCache&) = delete;
+
+	static uint64_t getRulePackageKey(const std::wstring& rulePkg, std::chrono::system_clock::time_point timeStamp);
+
+	/**
+	 * @param shapeAttributes the per-shape attribute map, hashed in canonical (sorted by key) order
+	 */
+	static Key createKey(uint64_t rulePackageKey, const std::wstring& ruleFile, const std::wstring& startRule,
+	                     int32_t seed, const std::wstring& shapeName, const prt::AttributeMap* shapeAttributes,
+	                     uint64_t geometryHash);
+
+	/**
+	 * Returns an empty pointer on a miss. A hit marks the entry as most recently used.
+	 */
+	GeneratedModelPtr get(Key key);
+
+	/**
+	 * Inserts or replaces the model and evicts the least recently used entries until the byte budget is met. Models
+	 * larger than the whole budget are not cached.
+	 */
+	void put(Key key, const GeneratedModelPtr& model);
+
+	void clear();
+
+	size_t getHits() const;
+	size_t getMisses() const;
+	size_t getEntryCount() const;
+	size_t getByteSize() const;
+
+private:
+	struct Entry {
+		Key key;
+		GeneratedModelPtr model;
+		size_t bytes;
+	};
+	using EntryList = std::list<Entry>; // most recently used first
+
+	void evict(size_t byteBudget);
+
+	const size_t mByteBudget;
+	size_t mByteSize = 0;
+	size_t mHits = 0;
+	size_t mMisses = 0;
+
+	EntryList mEntries;
+	std::unordered_map<Key, EntryList::iterator> mIndex;
+};
@@ -0,0 +1,739 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef _MSC_VER
+#	pragma warning(push)
+#	pragma warning(disable : 26451)
+#	pragma warning(disable : 26495)
+#endif
+#include "stdafx.h"
+#ifdef _MSC_VER
+#	pragma warning(pop)
+#endif
+
+#include "GeneratedModelDiskCache.h"
+#include "Logger.h"
+#include "PRTContext.h"
+#include "utils.h"
+#include "version.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+namespace {
+
+constexpr bool DBG = false;
+
+constexpr const wchar_t* CACHE_DIR_NAME = L"model_cache";
+constexpr const wchar_t* ENTRY_FILE_EXT = L".bin";
+constexpr const wchar_t* TEMP_FILE_EXT = L".tmp";
+
+constexpr char FILE_MAGIC[8] = {'C', 'E', 'R', 'H', 'M', 'D', 'L', '\0'};
+constexpr uint32_t FORMAT_VERSION = 8;
+
+// after exceeding the size cap, evict down to this fraction of it to avoid evicting on every store
+constexpr double EVICTION_TARGET_RATIO = 0.9;
+
+/**
+ * All entry files start with this header. The payload is a sequence of arrays, each stored as a uint64 element count
+ * followed by the raw elements, padded to 8 bytes.
+ */
+struct FileHeader {
+	char magic[8];
+	uint32_t formatVersion;
+	uint32_t headerSize;
+	char pluginVersion[32];
+	uint64_t key;
+	uint64_t payloadSize;
+};
+static_assert(sizeof(FileHeader) == 64, "unexpected padding in model cache file header");
+
+void setPluginVersion(FileHeader& header) {
+	const char* pluginVersion = VER_FILE_VERSION_STR;
+	std::memset(header.pluginVersion, 0, sizeof(header.pluginVersion));
+	std::memcpy(header.pluginVersion, pluginVersion,
+	            std::min(std::strlen(pluginVersion), sizeof(header.pluginVersion) - 1));
+}
+
+bool isCompatible(const FileHeader& header, GeneratedModelCache::Key key) {
+	FileHeader current{};
+	setPluginVersion(current);
+	return std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 && header.formatVersion == FORMAT_VERSION &&
+	       header.headerSize == sizeof(FileHeader) &&
+	       std::memcmp(header.pluginVersion, current.pluginVersion, sizeof(current.pluginVersion)) == 0 &&
+	       header.key == key;
+}
+
+class Writer {
+public:
+	explicit Writer(std::vector<uint8_t>& buffer) : mBuffer(buffer) {}
+
+	template <typename T>
+	void write(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Type T must be trivially copyable");
+		append(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void writeArray(const T* values, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "Type T must be trivially copyable");
+		write(static_cast<uint64_t>(count));
+		append(values, count * sizeof(T));
+		mBuffer.resize((mBuffer.size() + 7) & ~size_t(7));
+	}
+
+	template <typename T>
+	void writeArray(const std::vector<T>& values) {
+		writeArray(values.data(), values.size());
+	}
+
+	void writeString(const std::wstring& s) {
+		writeArray(s.data(), s.size());
+	}
+
+private:
+	void append(const void* data, size_t size) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+	}
+
+	std::vector<uint8_t>& mBuffer;
+};
+
+/**
+ * Reads from the mapped file, every access is bounds checked so truncated or corrupt files are detected.
+ */
+class Reader {
+public:
+	Reader(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+	bool isValid() const {
+		return mValid;
+	}
+
+	template <typename T>
+	T read() {
+		static_assert(std::is_trivially_copyable<T>::value, "Type T must be trivially copyable");
+		T value{};
+		if (const uint8_t* src = take(sizeof(T)))
+			std::memcpy(&value, src, sizeof(T));
+		return value;
+	}
+
+	/**
+	 * Returns a pointer into the mapped data, the data is not necessarily aligned for T.
+	 */
+	template <typename T>
+	const uint8_t* readArray(size_t& count) {
+		static_assert(std::is_trivially_copyable<T>::value, "Type T must be trivially copyable");
+		const uint64_t n = read<uint64_t>();
+		if (!mValid || n > (mSize - mOffset) / sizeof(T)) {
+			mValid = false;
+			count = 0;
+			return nullptr;
+		}
+		count = static_cast<size_t>(n);
+		const uint8_t* src = take(count * sizeof(T));
+		mOffset = std::min(mSize, (mOffset + 7) & ~size_t(7));
+		return src;
+	}
+
+	template <typename T>
+	void readArray(std::vector<T>& values) {
+		size_t count = 0;
+		const uint8_t* src = readArray<T>(count);
+		values.resize(count);
+		if (count > 0 && src != nullptr)
+			std::memcpy(values.data(), src, count * sizeof(T));
+	}
+
+	std::wstring readString() {
+		std::wstring s;
+		size_t count = 0;
+		const uint8_t* src = readArray<wchar_t>(count);
+		if (count > 0 && src != nullptr) {
+			s.resize(count);
+			std::memcpy(s.data(), src, count * sizeof(wchar_t));
+		}
+		return s;
+	}
+
+private:
+	const uint8_t* take(size_t size) {
+		if (!mValid || size > mSize - mOffset) {
+			mValid = false;
+			return nullptr;
+		}
+		const uint8_t* src = mData + mOffset;
+		mOffset += size;
+		return src;
+	}
+
+	const uint8_t* mData;
+	const size_t mSize;
+	size_t mOffset = 0;
+	bool mValid = true;
+};
+
+/**
+ * Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+	explicit MappedFile(const std::filesystem::path& path) {
+		mFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+			return;
+
+		mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mMapping == nullptr)
+			return;
+
+		mView = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+		if (mView != nullptr)
+			mSize = static_cast<size_t>(fileSize.QuadPart);
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+		if (mView != nullptr)
+			UnmapViewOfFile(mView);
+		if (mMapping != nullptr)
+			CloseHandle(mMapping);
+		if (mFile != INVALID_HANDLE_VALUE)
+			CloseHandle(mFile);
+	}
+
+	const uint8_t* getData() const {
+		return static_cast<const uint8_t*>(mView);
+	}
+
+	size_t getSize() const {
+		return mSize;
+	}
+
+private:
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+	const void* mView = nullptr;
+	size_t mSize = 0;
+};
+
+void removeFile(const std::filesystem::path& path) {
+	std::error_code ec;
+	std::filesystem::remove(path, ec);
+}
+
+void writeModelPart(Writer& writer, const ModelPart& part) {
+	writer.writeArray(part.mVertices);
+	writer.writeArray(part.mNormals);
+	writer.writeArray(part.mLocalVertices);
+	writer.writeArray(part.mLocalNormals);
+	writer.writeArray(part.mIndices);
+	writer.writeArray(part.mFaces);
+	writer.writeArray(reinterpret_cast<const float*>(part.mUVs.Array()), 2 * static_cast<size_t>(part.mUVs.Count()));
+	writer.writeArray(part.mUVIndices);
+	writer.writeArray(part.mUVCounts);
+	writer.writeArray(part.mPolygonTriangles);
+	writer.write(static_cast<uint64_t>(part.mIndexed));
+	writer.write(static_cast<uint64_t>(part.mInstanceIndex));
+
+	// the levels of detail only consist of triangles indexing the vertices of the part
+	writer.write(static_cast<uint64_t>(part.mLevels.size()));
+	for (const ModelPart& level : part.mLevels) {
+		writer.writeArray(level.mIndices);
+		writer.writeArray(level.mFaces);
+	}
+}
+
+void readModelPart(Reader& reader, ModelPart& part) {
+	reader.readArray(part.mVertices);
+	reader.readArray(part.mNormals);
+	reader.readArray(part.mLocalVertices);
+	reader.readArray(part.mLocalNormals);
+	reader.readArray(part.mIndices);
+	reader.readArray(part.mFaces);
+
+	size_t uvCoordCount = 0;
+	const uint8_t* uvs = reader.readArray<float>(uvCoordCount);
+	const size_t uvCount = uvCoordCount / 2;
+	if (uvCount > 0 && uvs != nullptr) {
+		part.mUVs.SetCapacity(static_cast<int>(uvCount));
+		part.mUVs.SetCount(static_cast<int>(uvCount));
+		std::memcpy(part.mUVs.Array(), uvs, uvCount * sizeof(ON_2fPoint));
+	}
+
+	reader.readArray(part.mUVIndices);
+	reader.readArray(part.mUVCounts);
+	reader.readArray(part.mPolygonTriangles);
+	part.mIndexed = (reader.read<uint64_t>() != 0);
+	part.mInstanceIndex = static_cast<size_t>(reader.read<uint64_t>());
+
+	const uint64_t levelCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < levelCount && reader.isValid(); i++) {
+		ModelPart& level = part.mLevels.emplace_back();
+		reader.readArray(level.mIndices);
+		reader.readArray(level.mFaces);
+		level.mIndexed = true;
+	}
+}
+
+bool hasTextures(const GeneratedModel& model) {
+	const Materials::MaterialsMap& materials = model.getMaterials();
+	return std::any_of(materials.begin(), materials.end(),
+	                   [](const auto& material) { return !material.second.mTexturePaths.empty(); });
+}
+
+} // namespace
+
+GeneratedModelDiskCache::GeneratedModelDiskCache(const std::filesystem::path& cacheDir, uint64_t maxBytes)
+    : mCacheDir(cacheDir), mMaxBytes(maxBytes), mWriterThread([this]() { run(); }) {}
+
+GeneratedModelDiskCache::~GeneratedModelDiskCache() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWorkAvailable.notify_one();
+	mWriterThread.join();
+}
+
+std::filesystem::path GeneratedModelDiskCache::getDefaultCacheDir() {
+	return PRTContext::getGlobalTempDir() / CACHE_DIR_NAME;
+}
+
+GeneratedModelPtr GeneratedModelDiskCache::load(GeneratedModelCache::Key key) {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto pendingIt = std::find_if(mPendingWrites.rbegin(), mPendingWrites.rend(),
+		                                    [key](const PendingWrite& pw) { return pw.key == key; });
+		if (pendingIt != mPendingWrites.rend()) {
+			mHits++;
+			return pendingIt->model;
+		}
+		if (mScanned && mEntrySizes.count(key) == 0) {
+			mMisses++;
+			return {};
+		}
+	}
+
+	const std::filesystem::path entryPath = getEntryPath(key);
+
+	GeneratedModelPtr model;
+	{
+		const MappedFile file(entryPath);
+		if (file.getData() != nullptr)
+			model = deserialize(key, file.getData(), file.getSize());
+		else {
+			mMisses++;
+			return {};
+		}
+	}
+
+	if (!model) {
+		// stale or corrupt entry
+		if constexpr (DBG)
+			LOG_DBG << "discarding incompatible model cache entry " << entryPath;
+		removeFile(entryPath);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto entryIt = mEntrySizes.find(key);
+		if (entryIt != mEntrySizes.end()) {
+			mTotalBytes -= std::min<uint64_t>(mTotalBytes, entryIt->second);
+			mEntrySizes.erase(entryIt);
+		}
+		mMisses++;
+		return {};
+	}
+
+	// the modification time serves as last access time for the eviction, the writer thread updates it
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mAccessedKeys.push_back(key);
+		notify = (mAccessedKeys.size() >= ACCESS_BATCH_SIZE);
+	}
+	if (notify)
+		mWorkAvailable.notify_one();
+
+	mHits++;
+	return model;
+}
+
+void GeneratedModelDiskCache::store(GeneratedModelCache::Key key, const GeneratedModelPtr& model) {
+	// the textures live in the asset cache, which is cleared at startup, their paths would be stale next session
+	if (!model || hasTextures(*model))
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mPendingWrites.size() >= MAX_PENDING_WRITES) {
+			if constexpr (DBG)
+				LOG_DBG << "model cache writer is busy, not storing model " << pcu::toHexString(key);
+			return;
+		}
+		mPendingWrites.push_back({key, model});
+	}
+	mWorkAvailable.notify_one();
+}
+
+size_t GeneratedModelDiskCache::getHits() const {
+	return mHits;
+}
+
+size_t GeneratedModelDiskCache::getMisses() const {
+	return mMisses;
+}
+
+std::filesystem::path GeneratedModelDiskCache::getEntryPath(GeneratedModelCache::Key key) const {
+	return mCacheDir / (pcu::toHexString(key) + ENTRY_FILE_EXT);
+}
+
+void GeneratedModelDiskCache::run() {
+	scan();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true) {
+		mWorkAvailable.wait(lock, [this]() {
+			return mStop || !mPendingWrites.empty() || mAccessedKeys.size() >= ACCESS_BATCH_SIZE;
+		});
+
+		// the cache is only an optimization, closing Rhino does not wait for the pending writes
+		if (mStop)
+			break;
+
+		if (!mAccessedKeys.empty()) {
+			std::vector<GeneratedModelCache::Key> accessedKeys;
+			accessedKeys.swap(mAccessedKeys);
+			lock.unlock();
+			updateAccessTimes(accessedKeys);
+			lock.lock();
+		}
+
+		if (!mPendingWrites.empty()) {
+			// the entry stays in the queue while writing, so loading it in the meantime does not miss
+			const PendingWrite pendingWrite = mPendingWrites.front();
+			lock.unlock();
+			write(pendingWrite);
+			lock.lock();
+			mPendingWrites.pop_front();
+
+			if (mTotalBytes > mMaxBytes) {
+				lock.unlock();
+				evict();
+				lock.lock();
+			}
+		}
+	}
+}
+
+void GeneratedModelDiskCache::scan() {
+	std::unordered_map<GeneratedModelCache::Key, uint64_t> entrySizes;
+	uint64_t totalBytes = 0;
+
+	std::error_code ec;
+	for (const auto& dirEntry : std::filesystem::directory_iterator(mCacheDir, ec)) {
+		std::error_code entryEc;
+		if (dirEntry.path().extension() == TEMP_FILE_EXT) {
+			// left over from an interrupted write
+			removeFile(dirEntry.path());
+			continue;
+		}
+		if (dirEntry.path().extension() != ENTRY_FILE_EXT)
+			continue;
+
+		GeneratedModelCache::Key key = 0;
+		std::wistringstream keyStream(dirEntry.path().stem().wstring());
+		if (!(keyStream >> std::hex >> key))
+			continue;
+		const uintmax_t size = dirEntry.file_size(entryEc);
+		if (entryEc)
+			continue;
+		entrySizes[key] = size;
+		totalBytes += size;
+	}
+
+	// entries removed by loads during the scan are dropped from the index by the next eviction
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntrySizes = std::move(entrySizes);
+	mTotalBytes = totalBytes;
+	mScanned = true;
+}
+
+void GeneratedModelDiskCache::write(const PendingWrite& pendingWrite) {
+	const std::vector<uint8_t> buffer = serialize(pendingWrite.key, *pendingWrite.model);
+	if (buffer.size() > mMaxBytes)
+		return;
+
+	std::error_code ec;
+	std::filesystem::create_directories(mCacheDir, ec);
+	if (ec) {
+		LOG_WRN << "Failed to create model cache directory " << mCacheDir << ": " << ec.message();
+		return;
+	}
+
+	// write to a temporary file first, so readers never see a partially written entry
+	const std::filesystem::path entryPath = getEntryPath(pendingWrite.key);
+	std::filesystem::path tempPath = entryPath;
+	tempPath.replace_extension(TEMP_FILE_EXT);
+	{
+		std::ofstream stream(tempPath, std::ofstream::binary | std::ofstream::trunc);
+		stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		if (!stream) {
+			LOG_WRN << "Failed to write model cache entry " << tempPath;
+			stream.close();
+			removeFile(tempPath);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempPath, entryPath, ec);
+	if (ec) {
+		removeFile(tempPath);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	uint64_t& entrySize = mEntrySizes[pendingWrite.key];
+	mTotalBytes = mTotalBytes - std::min<uint64_t>(mTotalBytes, entrySize) + buffer.size();
+	entrySize = buffer.size();
+}
+
+void GeneratedModelDiskCache::updateAccessTimes(const std::vector<GeneratedModelCache::Key>& keys) const {
+	const std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+	for (GeneratedModelCache::Key key : keys) {
+		std::error_code ec;
+		std::filesystem::last_write_time(getEntryPath(key), now, ec);
+	}
+}
+
+void GeneratedModelDiskCache::evict() {
+	struct Entry {
+		GeneratedModelCache::Key key;
+		std::filesystem::file_time_type lastUsed;
+		uint64_t size;
+	};
+	std::vector<Entry> entries;
+	uint64_t totalBytes = 0;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		entries.reserve(mEntrySizes.size());
+		for (const auto& [key, size] : mEntrySizes)
+			entries.push_back({key, {}, size});
+		totalBytes = mTotalBytes;
+	}
+
+	// entries which are gone already (e.g. removed by hand) only need to be dropped from the index
+	std::vector<GeneratedModelCache::Key> removedKeys;
+	for (Entry& entry : entries) {
+		std::error_code ec;
+		entry.lastUsed = std::filesystem::last_write_time(getEntryPath(entry.key), ec);
+		if (ec) {
+			removedKeys.push_back(entry.key);
+			totalBytes -= std::min<uint64_t>(totalBytes, entry.size);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+
+	// the files are removed without holding the lock, the writer thread is the only one adding entries
+	const uint64_t targetBytes = static_cast<uint64_t>(static_cast<double>(mMaxBytes) * EVICTION_TARGET_RATIO);
+	const size_t missingCount = removedKeys.size();
+	for (const Entry& entry : entries) {
+		if (totalBytes <= targetBytes)
+			break;
+		std::error_code removeEc;
+		if (std::filesystem::remove(getEntryPath(entry.key), removeEc)) {
+			removedKeys.push_back(entry.key);
+			totalBytes -= std::min<uint64_t>(totalBytes, entry.size);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (GeneratedModelCache::Key key : removedKeys) {
+		const auto entryIt = mEntrySizes.find(key);
+		if (entryIt != mEntrySizes.end()) {
+			mTotalBytes -= std::min<uint64_t>(mTotalBytes, entryIt->second);
+			mEntrySizes.erase(entryIt);
+		}
+	}
+
+	LOG_DBG << "evicted " << removedKeys.size() - missingCount << " models from the model cache, "
+	        << mTotalBytes / (1024 * 1024) << " MB remaining";
+}
+
+std::vector<uint8_t> GeneratedModelDiskCache::serialize(GeneratedModelCache::Key key, const GeneratedModel& model) {
+	std::vector<uint8_t> buffer;
+	buffer.reserve(model.getMemoryUsage() + sizeof(FileHeader));
+	buffer.resize(sizeof(FileHeader));
+
+	Writer writer(buffer);
+
+	writer.writeArray(model.getLocalOrigin().data(), model.getLocalOrigin().size());
+	writer.write(static_cast<uint64_t>(model.getModelParts().size()));
+	for (const ModelPart& part : model.getModelParts())
+		writeModelPart(writer, part);
+
+	writer.write(static_cast<uint64_t>(model.getPrototypes().size()));
+	for (const auto& [prototypeIndex, prototype] : model.getPrototypes()) {
+		writer.write(static_cast<uint64_t>(prototypeIndex));
+		writeModelPart(writer, prototype);
+	}
+
+	writer.write(static_cast<uint64_t>(model.getInstances().size()));
+	for (const ModelInstance& instance : model.getInstances()) {
+		writer.write(static_cast<uint64_t>(instance.mPrototypeIndex));
+		writer.write(static_cast<uint64_t>(instance.mInstanceIndex));
+		writer.writeArray(instance.mTransformation.data(), instance.mTransformation.size());
+	}
+
+	writer.write(static_cast<uint64_t>(model.mMaterials.size()));
+	for (const auto& [matId, material] : model.mMaterials) {
+		writer.write(static_cast<uint64_t>(matId));
+		writer.write(static_cast<uint32_t>(static_cast<unsigned int>(material.mDiffuseCol)));
+		writer.write(static_cast<uint32_t>(static_cast<unsigned int>(material.mAmbientCol)));
+		writer.write(static_cast<uint32_t>(static_cast<unsigned int>(material.mSpecularCol)));
+		writer.write(material.mShininess);
+		writer.write(material.mOpacity);
+	}
+
+	writer.write(static_cast<uint64_t>(model.mReports.size()));
+	for (const auto& [reportName, report] : model.mReports) {
+		writer.writeString(reportName);
+		writer.write(static_cast<uint64_t>(report.mInitialShapeIndex));
+		writer.write(static_cast<int32_t>(report.mType));
+		writer.writeString(report.mStringReport);
+		writer.write(report.mDoubleReport);
+		writer.write(static_cast<uint8_t>(report.mBoolReport ? 1 : 0));
+		writer.write(static_cast<int32_t>(report.mIntReport));
+	}
+
+	writer.write(static_cast<uint64_t>(model.mPrints.size()));
+	for (const std::wstring& print : model.mPrints)
+		writer.writeString(print);
+
+	writer.write(static_cast<uint64_t>(model.mErrors.size()));
+	for (const std::wstring& error : model.mErrors)
+		writer.writeString(error);
+
+	FileHeader header{};
+	std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	header.formatVersion = FORMAT_VERSION;
+	header.headerSize = sizeof(FileHeader);
+	setPluginVersion(header);
+	header.key = key;
+	header.payloadSize = buffer.size() - sizeof(FileHeader);
+	std::memcpy(buffer.data(), &header, sizeof(FileHeader));
+
+	return buffer;
+}
+
+GeneratedModelPtr GeneratedModelDiskCache::deserialize(GeneratedModelCache::Key key, const uint8_t* data,
+                                                       size_t size) {
+	if (size < sizeof(FileHeader))
+		return {};
+
+	FileHeader header;
+	std::memcpy(&header, data, sizeof(FileHeader));
+	if (!isCompatible(header, key) || header.payloadSize != size - sizeof(FileHeader))
+		return {};
+
+	Reader reader(data + sizeof(FileHeader), size - sizeof(FileHeader));
+	auto model = std::make_shared<GeneratedModel>();
+
+	std::vector<double> localOrigin;
+	reader.readArray(localOrigin);
+	std::array<double, 3> origin;
+	if (localOrigin.size() != origin.size())
+		return {};
+	std::copy(localOrigin.begin(), localOrigin.end(), origin.begin());
+	model->setLocalOrigin(origin);
+
+	const uint64_t partCount = reader.read<uint64_t>();
+	for (uint64_t pi = 0; pi < partCount && reader.isValid(); pi++)
+		readModelPart(reader, model->addModelPart());
+
+	const uint64_t prototypeCount = reader.read<uint64_t>();
+	for (uint64_t pi = 0; pi < prototypeCount && reader.isValid(); pi++) {
+		const size_t prototypeIndex = static_cast<size_t>(reader.read<uint64_t>());
+		readModelPart(reader, model->addPrototype(prototypeIndex));
+	}
+
+	const uint64_t instanceCount = reader.read<uint64_t>();
+	for (uint64_t ii = 0; ii < instanceCount && reader.isValid(); ii++) {
+		ModelInstance instance;
+		instance.mPrototypeIndex = static_cast<size_t>(reader.read<uint64_t>());
+		instance.mInstanceIndex = static_cast<size_t>(reader.read<uint64_t>());
+		std::vector<double> transformation;
+		reader.readArray(transformation);
+		if (transformation.size() != instance.mTransformation.size())
+			return {};
+		std::copy(transformation.begin(), transformation.end(), instance.mTransformation.begin());
+		model->addInstance(instance);
+	}
+
+	const uint64_t materialCount = reader.read<uint64_t>();
+	for (uint64_t mi = 0; mi < materialCount && reader.isValid(); mi++) {
+		Materials::MaterialAttribute material;
+		material.mMatId = static_cast<size_t>(reader.read<uint64_t>());
+		material.mDiffuseCol = ON_Color(reader.read<uint32_t>());
+		material.mAmbientCol = ON_Color(reader.read<uint32_t>());
+		material.mSpecularCol = ON_Color(reader.read<uint32_t>());
+		material.mShininess = reader.read<double>();
+		material.mOpacity = reader.read<double>();
+		model->mMaterials.emplace(material.mMatId, std::move(material));
+	}
+
+	const uint64_t reportCount = reader.read<uint64_t>();
+	for (uint64_t ri = 0; ri < reportCount && reader.isValid(); ri++) {
+		Reporting::ReportAttribute report;
+		report.mReportName = reader.readString();
+		report.mInitialShapeIndex = static_cast<size_t>(reader.read<uint64_t>());
+		report.mType = static_cast<prt::AttributeMap::PrimitiveType>(reader.read<int32_t>());
+		report.mStringReport = reader.readString();
+		report.mDoubleReport = reader.read<double>();
+		report.mBoolReport = reader.read<uint8_t>() != 0;
+		report.mIntReport = reader.read<int32_t>();
+		model->mReports.emplace(report.mReportName, std::move(report));
+	}
+
+	const uint64_t printCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < printCount && reader.isValid(); i++)
+		model->mPrints.emplace_back(reader.readString());
+
+	const uint64_t errorCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < errorCount && reader.isValid(); i++)
+		model->mErrors.emplace_back(reader.readString());
+
+	if (!reader.isValid())
+		return {};
+
+	return model;
+}
@@ -0,0 +1,112 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "GeneratedModel.h"
+#include "GeneratedModelCache.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Persistent store of generated models below the global temp dir, so unchanged shapes do not need to be regenerated
+ * after reopening a Grasshopper definition. Uses the same content keys as GeneratedModelCache (which also cover the
+ * rule package modification time). Each model is written into its own file with a flat binary layout which is memory
+ * mapped and copied into the model buffers when loading. Files written by another format or plugin version are
+ * ignored and removed. When the store grows beyond its size cap, the least recently used files are deleted. Models
+ * with textures are not stored, their textures only live in the asset cache of the current session.
+ *
+ * Only loading a hit touches the disk on the calling thread. A background thread writes the stored models, updates
+ * the access times of the loaded entries in batches and evicts. It also scans the cache directory into an index of
+ * the present entries, so misses are answered without opening a file once the scan is done.
+ */
+class GeneratedModelDiskCache final {
+public:
+	static constexpr uint64_t DEFAULT_MAX_BYTES = 2ull * 1024 * 1024 * 1024;
+
+	// models beyond this many pending writes are not stored, generating never waits for the disk
+	static constexpr size_t MAX_PENDING_WRITES = 64;
+
+	// access times are updated once this many entries have been loaded, or along with the next write
+	static constexpr size_t ACCESS_BATCH_SIZE = 256;
+
+	explicit GeneratedModelDiskCache(const std::filesystem::path& cacheDir, uint64_t maxBytes = DEFAULT_MAX_BYTES);
+	GeneratedModelDiskCache(const GeneratedModelDiskCache&) = delete;
+	GeneratedModelDiskCache& operator=(const GeneratedModelDiskCache&) = delete;
+	~GeneratedModelDiskCache(); // discards the pending writes
+
+	/**
+	 * Returns an empty pointer if there is no valid entry for the key. Models which are still waiting to be written
+	 * are returned from memory.
+	 */
+	GeneratedModelPtr load(GeneratedModelCache::Key key);
+
+	/**
+	 * Queues the model for writing on the background thread. The model must not be modified afterwards.
+	 */
+	void store(GeneratedModelCache::Key key, const GeneratedModelPtr& model);
+
+	size_t getHits() const;
+	size_t getMisses() const;
+
+	static std::filesystem::path getDefaultCacheDir();
+
+private:
+	struct PendingWrite {
+		GeneratedModelCache::Key key;
+		GeneratedModelPtr model;
+	};
+
+	static std::vector<uint8_t> serialize(GeneratedModelCache::Key key, const GeneratedModel& model);
+	static GeneratedModelPtr deserialize(GeneratedModelCache::Key key, const uint8_t* data, size_t size);
+
+	std::filesystem::path getEntryPath(GeneratedModelCache::Key key) const;
+
+	// the following run on the writer thread only
+	void run();
+	void scan();
+	void write(const PendingWrite& pendingWrite);
+	void updateAccessTimes(const std::vector<GeneratedModelCache::Key>& keys) const;
+	void evict();
+
+	const std::filesystem::path mCacheDir;
+	const uint64_t mMaxBytes;
+
+	std::mutex mMutex; // guards the members below, up to the writer thread
+	std::condition_variable mWorkAvailable;
+	std::deque<PendingWrite> mPendingWrites;
+	std::vector<GeneratedModelCache::Key> mAccessedKeys;
+	std::unordered_map<GeneratedModelCache::Key, uint64_t> mEntrySizes; // index of the entries on disk
+	bool mScanned = false;
+	uint64_t mTotalBytes = 0;
+	bool mStop = false;
+
+	std::atomic<size_t> mHits = 0;
+	std::atomic<size_t> mMisses = 0;
+
+	std::thread mWriterThread; // last, starts after all other members have been initialized
+};
@@ -0,0 +1,62 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef _MSC_VER
+#	pragma warning(push)
+#	pragma warning(disable : 26451)
+#	pragma warning(disable : 26495)
+#endif
+#include "stdafx.h"
+#ifdef _MSC_VER
+#	pragma warning(pop)
+#endif
+
+#include "GenerationControl.h"
+
+GenerationControl::GenerationControl(ProgressCallback progressCallback)
+    : mProgressCallback(std::move(progressCallback)) {}
+
+void GenerationControl::cancel() {
+	mCanceled = true;
+}
+
+bool GenerationControl::isCanceled() const {
+	return mCanceled;
+}
+
+void GenerationControl::start(size_t shapesTotal) {
+	std::lock_guard<std::mutex> lock(mProgressMutex);
+	mShapesTotal = shapesTotal;
+	mShapesDone = 0;
+	if (mProgressCallback)
+		mProgressCallback(mShapesDone, mShapesTotal);
+}
+
+void GenerationControl::addDone(size_t shapes) {
+	std::lock_guard<std::mutex> lock(mProgressMutex);
+	mShapesDone += shapes;
+	if (mProgressCallback && !mCanceled)
+		mProgressCallback(mShapesDone, mShapesTotal);
+}
+
+void GenerationControl::getProgress(size_t& shapesDone, size_t& shapesTotal) const {
+	std::lock_guard<std::mutex> lock(mProgressMutex);
+	shapesDone = mShapesDone;
+	shapesTotal = mShapesTotal;
+}
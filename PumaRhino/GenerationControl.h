@@ -0,0 +1,56 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ * Shared state of a running generation: allows to cancel it from another thread and reports the number of finished
+ * initial shapes.
+ */
+class GenerationControl {
+public:
+	using ProgressCallback = std::function<void(size_t shapesDone, size_t shapesTotal)>;
+
+	GenerationControl() = default;
+	explicit GenerationControl(ProgressCallback progressCallback);
+	GenerationControl(const GenerationControl&) = delete;
+	GenerationControl& operator=(const GenerationControl&) = delete;
+
+	void cancel();
+	bool isCanceled() const;
+
+	void start(size_t shapesTotal);
+	void addDone(size_t shapes);
+	void getProgress(size_t& shapesDone, size_t& shapesTotal) const;
+
+private:
+	std::atomic<bool> mCanceled = false;
+	size_t mShapesTotal = 0;
+	size_t mShapesDone = 0;
+
+	mutable std::mutex mProgressMutex; // serializes the progress callback
+	ProgressCallback mProgressCallback;
+};
+
+using GenerationControlSPtr = std::shared_ptr<GenerationControl>;
@@ -0,0 +1,156 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GenerationHistory.h"
+#include "Logger.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+constexpr const char* HISTORY_FORMAT_VERSION = "cityengine_for_rhino_generation_history 1";
+
+// the history is only a scheduling hint, keep it from growing without bounds
+constexpr size_t MAX_SHAPE_ENTRIES_PER_RULE = 100000;
+
+constexpr char RECORD_CALIBRATION = 'C';
+constexpr char RECORD_SHAPE = 'S';
+
+} // namespace
+
+GenerationHistory::GenerationHistory(const std::filesystem::path& rulePkg, const std::filesystem::path& historyPath)
+    : mRulePackage(rulePkg), mHistoryPath(historyPath) {
+	load();
+}
+
+GenerationHistory::~GenerationHistory() {
+	try {
+		save();
+	}
+	catch (...) {
+		// the history is only a scheduling hint, losing the latest timings is fine
+	}
+}
+
+const std::filesystem::path& GenerationHistory::getRulePackage() const {
+	return mRulePackage;
+}
+
+std::optional<double> GenerationHistory::getShapeSeconds(const std::wstring& startRule, uint64_t shapeKey) const {
+	const auto ruleIt = mRules.find(startRule);
+	if (ruleIt == mRules.end())
+		return {};
+	const auto shapeIt = ruleIt->second.mShapeSeconds.find(shapeKey);
+	if (shapeIt == ruleIt->second.mShapeSeconds.end())
+		return {};
+	return shapeIt->second;
+}
+
+void GenerationHistory::setShapeSeconds(const std::wstring& startRule, uint64_t shapeKey, double seconds) {
+	RuleHistory& ruleHistory = mRules[startRule];
+	if (ruleHistory.mShapeSeconds.size() >= MAX_SHAPE_ENTRIES_PER_RULE &&
+	    ruleHistory.mShapeSeconds.count(shapeKey) == 0)
+		ruleHistory.mShapeSeconds.clear();
+	ruleHistory.mShapeSeconds[shapeKey] = seconds;
+	mDirty = true;
+}
+
+std::optional<double> GenerationHistory::getSecondsPerCost(const std::wstring& startRule) const {
+	const auto ruleIt = mRules.find(startRule);
+	if (ruleIt == mRules.end() || ruleIt->second.mSecondsPerCost <= 0.0)
+		return {};
+	return ruleIt->second.mSecondsPerCost;
+}
+
+void GenerationHistory::setSecondsPerCost(const std::wstring& startRule, double secondsPerCost) {
+	mRules[startRule].mSecondsPerCost = secondsPerCost;
+	mDirty = true;
+}
+
+void GenerationHistory::load() {
+	std::ifstream stream(mHistoryPath);
+	if (!stream)
+		return; // no history yet
+
+	std::string line;
+	if (!std::getline(stream, line) || line != HISTORY_FORMAT_VERSION) {
+		LOG_WRN << "Ignoring generation history with unknown format at " << mHistoryPath;
+		return;
+	}
+
+	// record layout (tab separated): C <start rule> <seconds per cost> | S <start rule> <shape key> <seconds>
+	while (std::getline(stream, line)) {
+		std::istringstream record(line);
+		std::string type, startRuleUTF8;
+		if (!std::getline(record, type, '\t') || type.size() != 1 || !std::getline(record, startRuleUTF8, '\t'))
+			continue;
+		const std::wstring startRule = std::filesystem::u8path(startRuleUTF8).wstring();
+
+		if (type[0] == RECORD_CALIBRATION) {
+			double secondsPerCost = 0.0;
+			if (record >> secondsPerCost)
+				mRules[startRule].mSecondsPerCost = secondsPerCost;
+		}
+		else if (type[0] == RECORD_SHAPE) {
+			uint64_t shapeKey = 0;
+			double seconds = 0.0;
+			if (record >> std::hex >> shapeKey >> std::dec >> seconds)
+				mRules[startRule].mShapeSeconds[shapeKey] = seconds;
+		}
+	}
+	mDirty = false;
+}
+
+void GenerationHistory::saveDeferred() {
+	if (mDirty && std::chrono::steady_clock::now() - mLastSave >= SAVE_INTERVAL)
+		save();
+}
+
+void GenerationHistory::save() {
+	if (!mDirty)
+		return;
+	mLastSave = std::chrono::steady_clock::now();
+
+	try {
+		std::filesystem::create_directories(mHistoryPath.parent_path());
+	}
+	catch (std::exception& e) {
+		LOG_WRN << "Failed to create generation history directory " << mHistoryPath.parent_path() << ": " << e.what();
+		return;
+	}
+
+	std::ofstream stream(mHistoryPath, std::ofstream::trunc);
+	if (!stream) {
+		LOG_WRN << "Failed to write generation history to " << mHistoryPath;
+		return;
+	}
+
+	stream << HISTORY_FORMAT_VERSION << '\n';
+	for (const auto& [startRule, ruleHistory] : mRules) {
+		const std::string startRuleUTF8 = std::filesystem::path(startRule).u8string();
+		if (ruleHistory.mSecondsPerCost > 0.0)
+			stream << RECORD_CALIBRATION << '\t' << startRuleUTF8 << '\t' << ruleHistory.mSecondsPerCost << '\n';
+		for (const auto& [shapeKey, seconds] : ruleHistory.mShapeSeconds)
+			stream << RECORD_SHAPE << '\t' << startRuleUTF8 << '\t' << std::hex << shapeKey << std::dec << ' '
+			       << seconds << '\n';
+	}
+
+	mDirty = false;
+}
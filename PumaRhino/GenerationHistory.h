@@ -0,0 +1,76 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Persistent per rule package store of generation timings. Keeps the measured generation time of individual initial
+ * shapes (keyed by geometry hash) and a calibration factor per start rule to convert feature based cost estimates into
+ * seconds. Each rule package gets its own history file, which is loaded on construction.
+ */
+class GenerationHistory {
+public:
+	GenerationHistory(const std::filesystem::path& rulePkg, const std::filesystem::path& historyPath);
+	GenerationHistory(const GenerationHistory&) = delete;
+	GenerationHistory& operator=(const GenerationHistory&) = delete;
+	~GenerationHistory(); // saves the pending changes
+
+	const std::filesystem::path& getRulePackage() const;
+
+	std::optional<double> getShapeSeconds(const std::wstring& startRule, uint64_t shapeKey) const;
+	void setShapeSeconds(const std::wstring& startRule, uint64_t shapeKey, double seconds);
+
+	std::optional<double> getSecondsPerCost(const std::wstring& startRule) const;
+	void setSecondsPerCost(const std::wstring& startRule, double secondsPerCost);
+
+	/**
+	 * Writes the history to disk if it has been modified since it was loaded or saved.
+	 */
+	void save();
+
+	/**
+	 * Saves at most once per SAVE_INTERVAL, so that interactive generate calls do not rewrite the file every time. The
+	 * later changes are written by save(), at the latest when the history is destroyed.
+	 */
+	void saveDeferred();
+
+private:
+	struct RuleHistory {
+		double mSecondsPerCost = 0.0;
+		std::unordered_map<uint64_t, double> mShapeSeconds;
+	};
+
+	void load();
+
+	const std::filesystem::path mRulePackage;
+	const std::filesystem::path mHistoryPath;
+	std::map<std::wstring, RuleHistory> mRules;
+	bool mDirty = false;
+
+	static constexpr std::chrono::seconds SAVE_INTERVAL{60};
+	std::chrono::steady_clock::time_point mLastSave = std::chrono::steady_clock::now();
+};
@@ -0,0 +1,179 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef _MSC_VER
+#	pragma warning(push)
+#	pragma warning(disable : 26451)
+#	pragma warning(disable : 26495)
+#endif
+#include "stdafx.h"
+#ifdef _MSC_VER
+#	pragma warning(pop)
+#endif
+
+#include "GenerationPool.h"
+#include "Logger.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cassert>
+
+size_t GenerationConcurrency::getAvailableCores() const {
+	const size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	return (reservedCores < cores) ? cores - reservedCores : 1;
+}
+
+size_t GenerationConcurrency::getWorkerCount() const {
+	const size_t availableCores = getAvailableCores();
+	return (maxWorkerThreads > 0) ? std::min(maxWorkerThreads, availableCores) : availableCores;
+}
+
+bool GenerationConcurrency::operator==(const GenerationConcurrency& other) const {
+	return maxWorkerThreads == other.maxWorkerThreads && reservedCores == other.reservedCores &&
+	       pinWorkers == other.pinWorkers;
+}
+
+bool GenerationConcurrency::operator!=(const GenerationConcurrency& other) const {
+	return !(*this == other);
+}
+
+RhinoCallbacks& GenerationPool::WorkerScratch::getCallbacks(size_t initialShapeCount) {
+	if (!callbacks)
+		callbacks = std::make_unique<RhinoCallbacks>(initialShapeCount);
+	else
+		callbacks->reset(initialShapeCount);
+	return *callbacks;
+}
+
+GenerationPool::GenerationPool(const GenerationConcurrency& concurrency)
+    : mConcurrency(concurrency), mScratch(concurrency.getWorkerCount()) {
+	const size_t threadCount = mScratch.size();
+	mThreads.reserve(threadCount);
+	for (size_t wi = 0; wi < threadCount; wi++)
+		mThreads.emplace_back(&GenerationPool::workerLoop, this, wi);
+	LOG_INF << "Started generation pool with " << threadCount << " workers (max threads: "
+	        << mConcurrency.maxWorkerThreads << ", reserved cores: " << mConcurrency.reservedCores
+	        << ", pinned: " << (mConcurrency.pinWorkers ? "yes" : "no") << ").";
+}
+
+GenerationPool::~GenerationPool() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWorkAvailable.notify_all();
+	for (std::thread& t : mThreads) {
+		if (t.joinable())
+			t.join();
+	}
+	LOG_INF << "Stopped generation pool.";
+}
+
+size_t GenerationPool::getWorkerCount() const {
+	return mThreads.size();
+}
+
+const GenerationConcurrency& GenerationPool::getConcurrency() const {
+	return mConcurrency;
+}
+
+void GenerationPool::run(size_t taskCount, const Task& task, const std::function<void()>& whileRunning) {
+	taskCount = std::min(taskCount, mThreads.size());
+	if (taskCount == 0)
+		return;
+
+	std::lock_guard<std::mutex> runLock(mRunMutex);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mTask = &task;
+	mTaskCount = taskCount;
+	mPendingCount = taskCount;
+	mException = nullptr;
+	mRunId++;
+	lock.unlock();
+	mWorkAvailable.notify_all();
+
+	// the workers still reference the task, always wait for them
+	std::exception_ptr callerException;
+	if (whileRunning) {
+		try {
+			whileRunning();
+		}
+		catch (...) {
+			callerException = std::current_exception();
+		}
+	}
+
+	lock.lock();
+	mWorkDone.wait(lock, [this] { return mPendingCount == 0; });
+	mTask = nullptr;
+	std::exception_ptr exception = mException ? mException : callerException;
+	mException = nullptr;
+	lock.unlock();
+
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+void GenerationPool::workerLoop(size_t workerIndex) {
+	if (mConcurrency.pinWorkers)
+		pinWorker(workerIndex);
+
+	uint64_t lastRunId = 0;
+	while (true) {
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWorkAvailable.wait(lock, [this, &lastRunId] { return mStop || mRunId != lastRunId; });
+		if (mStop)
+			return;
+
+		lastRunId = mRunId;
+		if (workerIndex >= mTaskCount)
+			continue; // not needed for this run
+
+		const Task* task = mTask;
+		lock.unlock();
+
+		std::exception_ptr exception;
+		try {
+			(*task)(workerIndex, mScratch[workerIndex]);
+		}
+		catch (...) {
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+		if (exception && !mException)
+			mException = exception;
+		assert(mPendingCount > 0);
+		if (--mPendingCount == 0)
+			mWorkDone.notify_all();
+	}
+}
+
+void GenerationPool::pinWorker(size_t workerIndex) const {
+	// the affinity mask covers the (up to 64) cores of the current processor group
+	constexpr size_t MAX_MASK_CORES = sizeof(DWORD_PTR) * 8;
+	const size_t cores = std::min<size_t>(std::max<size_t>(std::thread::hardware_concurrency(), 1), MAX_MASK_CORES);
+	const size_t core = (mConcurrency.reservedCores + workerIndex) % cores;
+
+	const DWORD_PTR mask = DWORD_PTR(1) << core;
+	if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+		LOG_WRN << "Failed to pin generation worker " << workerIndex << " to core " << core;
+}
@@ -0,0 +1,106 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "RhinoCallbacks.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * User settings for the number of generation workers, see SetGenerationConcurrency in the C API.
+ */
+struct GenerationConcurrency {
+	size_t maxWorkerThreads = 0; // 0: one worker per available core
+	size_t reservedCores = 0;    // cores left to Rhino and other processes
+	bool pinWorkers = false;     // bind each worker to its own core (the cores after the reserved ones)
+
+	/**
+	 * Number of cores generation may use: all hardware threads minus the reserved cores, but at least one.
+	 */
+	size_t getAvailableCores() const;
+	size_t getWorkerCount() const;
+
+	bool operator==(const GenerationConcurrency& other) const;
+	bool operator!=(const GenerationConcurrency& other) const;
+};
+
+/**
+ * Long-lived worker threads for generation. The pool is started together with PRT and owned by PRTContext, so
+ * consecutive solves (e.g. while dragging a Grasshopper slider) do not pay for thread creation and can reuse the
+ * per-worker scratch objects.
+ */
+class GenerationPool final {
+public:
+	/**
+	 * Objects owned by a single worker which survive across runs. Only ever touched by the owning worker.
+	 */
+	struct WorkerScratch {
+		RhinoCallbacksPtr callbacks;
+
+		RhinoCallbacks& getCallbacks(size_t initialShapeCount);
+	};
+
+	using Task = std::function<void(size_t workerIndex, WorkerScratch& scratch)>;
+
+	explicit GenerationPool(const GenerationConcurrency& concurrency);
+	GenerationPool(const GenerationPool&) = delete;
+	GenerationPool& operator=(const GenerationPool&) = delete;
+	~GenerationPool();
+
+	size_t getWorkerCount() const;
+	const GenerationConcurrency& getConcurrency() const;
+
+	/**
+	 * Runs the task once on each of the first taskCount workers and blocks until all of them are done. Concurrent
+	 * calls are serialized. An exception thrown by a task is rethrown on the calling thread.
+	 * @param whileRunning optional, runs on the calling thread once the workers have been started (e.g. to consume
+	 * their results), the call then waits for the workers as usual. Its exceptions are rethrown as well.
+	 */
+	void run(size_t taskCount, const Task& task, const std::function<void()>& whileRunning = {});
+
+private:
+	void workerLoop(size_t workerIndex);
+	void pinWorker(size_t workerIndex) const;
+
+	const GenerationConcurrency mConcurrency;
+	std::vector<std::thread> mThreads;
+	std::vector<WorkerScratch> mScratch;
+
+	std::mutex mRunMutex; // serializes run() calls
+
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+	const Task* mTask = nullptr;
+	size_t mTaskCount = 0;
+	size_t mPendingCount = 0;
+	uint64_t mRunId = 0;
+	bool mStop = false;
+	std::exception_ptr mException;
+};
+
+using GenerationPoolUPtr = std::unique_ptr<GenerationPool>;
@@ -31,13 +31,17 @@
 
 #include "AttrEvalCallbacks.h"
 #include "Logger.h"
+#include "ShapeCostEstimator.h"
+#include "ShapeScheduler.h"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <filesystem>
-#include <future>
-#include <numeric>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
 
 namespace {
 
@@ -45,15 +49,25 @@ constexpr const wchar_t* ENCODER_ID_RHINO = L"com.esri.rhinoprt.RhinoEncoder";
 constexpr const wchar_t* ENCODER_ID_CGA_ERROR = L"com.esri.prt.core.CGAErrorEncoder";
 constexpr const wchar_t* ENCODER_ID_CGA_PRINT = L"com.esri.prt.core.CGAPrintEncoder";
 
-constexpr std::array<const wchar_t*, 3> ALL_ENCODER_IDS = {ENCODER_ID_RHINO, ENCODER_ID_CGA_ERROR,
-                                                           ENCODER_ID_CGA_PRINT};
-
 constexpr const wchar_t* FILE_CGA_ERROR = L"CGAErrors.txt";
 constexpr const wchar_t* FILE_CGA_PRINT = L"CGAPrint.txt";
 
+// generate option to control how many threads PRT may use to generate a single call of prt::generate
+constexpr const wchar_t* GO_NUMBER_WORKER_THREADS = L"numberWorkerThreads";
+
 constexpr const wchar_t* RESOLVEMAP_EXTRACTION_PREFIX = L"rhino_prt";
 constexpr const wchar_t* ENCODER_ID_CGA_EVALATTR = L"com.esri.prt.core.AttributeEvalEncoder";
 
+// shapes per generate call of the attribute evaluation, bounds the delay of a cancellation
+constexpr size_t ATTRIBUTE_EVAL_CHUNK_SIZE = 256;
+
+constexpr const wchar_t* GENERATION_HISTORY_DIR_NAME = L"generation_history";
+constexpr const wchar_t* GENERATION_HISTORY_FILE_EXT = L".txt";
+
+// shapes estimated to cost this many times the average are generated in a call of their own, i.e. they are expensive
+// enough to amortize the call overhead and their generation time can be recorded per shape
+constexpr double SINGLE_SHAPE_COST_FACTOR = 8.0;
+
 pcu::AttributeMapPtr getAttrEvalEncoderInfo() {
 	const pcu::EncoderInfoPtr encInfo(prt::createEncoderInfo(ENCODER_ID_CGA_EVALATTR));
 	const prt::AttributeMap* encOpts = nullptr;
@@ -74,63 +88,190 @@ std::vector<const wchar_t*> toRawPtrs(const std::vector<std::wstring>& strings)
 	return rawPtrs;
 }
 
-std::vector<size_t> distribute(size_t tasks, size_t slots) {
-	const size_t base = tasks / slots;
-	const size_t extra = tasks % slots;
+// the timings of each rule package are kept below the global temp dir, so they survive Rhino sessions
+std::filesystem::path getGenerationHistoryPath(const std::filesystem::path& rulePkg) {
+	const uint64_t rulePkgHash = pcu::Hasher().add(rulePkg.generic_wstring()).get();
+	return PRTContext::getGlobalTempDir() / GENERATION_HISTORY_DIR_NAME /
+	       (pcu::toHexString(rulePkgHash) + GENERATION_HISTORY_FILE_EXT);
+}
 
-	std::vector<size_t> d(slots, base);
-	std::fill_n(d.begin(), extra, base + 1);
+struct WorkerStats {
+	size_t shapes = 0;
+	size_t chunks = 0;
+	size_t stolenChunks = 0;
+	std::chrono::steady_clock::duration busyTime{0};
+	std::vector<ShapeCostEstimator::ChunkTiming> chunkTimings;
+};
+
+void logWorkerStats(const std::vector<WorkerStats>& workerStats, const std::chrono::steady_clock::duration& batchTime) {
+	using ms = std::chrono::duration<double, std::milli>;
+	const double batchMs = ms(batchTime).count();
+	for (size_t wi = 0; wi < workerStats.size(); wi++) {
+		const WorkerStats& ws = workerStats[wi];
+		const double busyMs = ms(ws.busyTime).count();
+		const double utilization = (batchMs > 0.0) ? 100.0 * busyMs / batchMs : 0.0;
+		LOG_DBG << "worker " << wi << ": shapes = " << ws.shapes << ", chunks = " << ws.chunks
+		        << " (stolen: " << ws.stolenChunks << "), busy = " << busyMs << "ms (" << utilization << "%)";
+	}
+	LOG_DBG << "batch generation took " << batchMs << "ms";
+}
 
-	return d;
+/**
+ * If there are fewer shapes than usable cores (i.e. the thread budget of the generation pool settings), the spare cores
+ * are handed to the concurrent prt::generate calls to generate within a shape. Returns no options (i.e. single-threaded
+ * PRT generate) if every core already runs its own call.
+ */
+pcu::AttributeMapPtr createGenerateOptions(size_t concurrentCalls, size_t threadBudget) {
+	const size_t threadsPerCall = threadBudget / std::max<size_t>(concurrentCalls, 1);
+	if (threadsPerCall <= 1)
+		return {};
+
+	LOG_DBG << "using " << threadsPerCall << " threads within each of the " << concurrentCalls
+	        << " concurrent generate calls (thread budget: " << threadBudget << ")";
+
+	pcu::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
+	amb->setInt(GO_NUMBER_WORKER_THREADS, static_cast<int32_t>(threadsPerCall));
+	return pcu::AttributeMapPtr(amb->createAttributeMap());
+}
+
+/**
+ * Number of shapes at the front of the LPT order which get a chunk of their own: all shapes which are much more
+ * expensive than the average, but at least the first shape of each worker.
+ */
+size_t getSingleShapeCount(const std::vector<size_t>& order, const std::vector<double>& estimatedCosts,
+                           size_t workerCount) {
+	double totalCost = 0.0;
+	for (size_t shapeIndex : order)
+		totalCost += estimatedCosts[shapeIndex];
+	const double threshold = SINGLE_SHAPE_COST_FACTOR * totalCost / static_cast<double>(order.size());
+
+	size_t singleShapeCount = 0;
+	while (singleShapeCount < order.size() && estimatedCosts[order[singleShapeCount]] >= threshold)
+		singleShapeCount++;
+	return std::min(std::max(singleShapeCount, workerCount), order.size());
 }
 
+/**
+ * Generates the selected initial shapes in order of decreasing estimated cost (LPT) and reports the measured generation
+ * time of each chunk. The most expensive shapes are generated one per chunk, so their timings are per shape. The
+ * returned vector is indexed like initialShapes and only holds models for the selected shapes, or no models at all if
+ * the generation has been canceled. Finished models are also pushed to the optional result channel chunk by chunk.
+ * Progress is only reported for the generated shapes, starting the progress is up to the caller.
+ */
 std::vector<GeneratedModelPtr> batchGenerate(const std::vector<pcu::InitialShapePtr>& initialShapes,
+                                             const std::vector<size_t>& shapeIndices,
+                                             const std::vector<double>& estimatedCosts,
+                                             std::vector<ShapeCostEstimator::ChunkTiming>& chunkTimings,
+                                             const std::vector<const wchar_t*>& encoderIDs,
                                              const std::vector<const prt::AttributeMap*>& encoderOptions,
-                                             prt::Cache* prtCache) {
-	const size_t nThreads = std::min<size_t>(std::thread::hardware_concurrency(), initialShapes.size());
-	const std::vector<size_t> initialShapesPerThread = distribute(initialShapes.size(), nThreads);
-
-	std::vector<size_t> offsets(nThreads, 0);
-	std::partial_sum(initialShapesPerThread.begin(), std::prev(initialShapesPerThread.end()),
-	                 std::next(offsets.begin()));
+                                             prt::Cache* prtCache, GenerationControl* control,
+                                             ResultChannel* resultChannel) {
+	assert(estimatedCosts.size() == initialShapes.size());
+	chunkTimings.clear();
+	if (initialShapes.empty())
+		return {};
 
-	// TODO: if nThreads is smaller than cpu cores we can enable multi-threaded generation within a shape with the
-	// remaining cores
+	std::vector<GeneratedModelPtr> generatedModels(initialShapes.size());
+	if (shapeIndices.empty())
+		return generatedModels;
 
-	std::vector<prt::InitialShape const*> rawInitialShapes = toRawPtrs<const prt::InitialShape>(initialShapes);
-	std::vector<pcu::RhinoCallbacksPtr> callbacks(nThreads); // one callback per thread
-	std::vector<std::future<void>> futures;
-	futures.reserve(nThreads);
+	std::vector<size_t> order(shapeIndices);
+	std::stable_sort(order.begin(), order.end(),
+	                 [&estimatedCosts](size_t a, size_t b) { return estimatedCosts[a] > estimatedCosts[b]; });
+
+	GenerationPool& pool = PRTContext::get()->getGenerationPool();
+	const size_t nThreads = std::min<size_t>(pool.getWorkerCount(), order.size());
+	const size_t singleShapeCount = getSingleShapeCount(order, estimatedCosts, nThreads);
+	ShapeScheduler scheduler(order.size(), nThreads, ShapeScheduler::Distribution::ROUND_ROBIN, singleShapeCount);
+
+	const GenerationConcurrency& concurrency = pool.getConcurrency();
+	LOG_DBG << "generating " << order.size() << " shapes on " << nThreads << " of " << pool.getWorkerCount()
+	        << " workers (max threads: " << concurrency.maxWorkerThreads
+	        << ", reserved cores: " << concurrency.reservedCores
+	        << ", pinned: " << (concurrency.pinWorkers ? "yes" : "no")
+	        << "), single shape chunks = " << singleShapeCount << ", chunk size = " << scheduler.getChunkSize();
+
+	const pcu::AttributeMapPtr generateOptions = createGenerateOptions(nThreads, pool.getWorkerCount());
+
+	std::vector<prt::InitialShape const*> rawInitialShapes(order.size());
+	std::transform(order.begin(), order.end(), rawInitialShapes.begin(),
+	               [&initialShapes](size_t i) { return initialShapes[i].get(); });
+	std::vector<WorkerStats> workerStats(nThreads);
+
+	// the calling thread consumes the streamed models while the workers generate
+	std::function<void()> drainResults;
+	if (resultChannel != nullptr) {
+		resultChannel->addProducers(nThreads);
+		drainResults = [resultChannel]() { resultChannel->drain(); };
+	}
 
-	for (int8_t ti = 0; ti < nThreads; ti++) {
-		auto f = std::async(std::launch::async, [ti, &initialShapesPerThread, &offsets, &callbacks, &rawInitialShapes,
-		                                         &encoderOptions, &prtCache] {
-			LOG_DBG << "thread " << ti << ": shapes = " << initialShapesPerThread[ti] << ", offset = " << offsets[ti];
+	const auto batchStart = std::chrono::steady_clock::now();
+	pool.run(nThreads, [&](size_t ti, GenerationPool::WorkerScratch& scratch) {
+		const ResultChannel::ProducerScope producerScope(resultChannel);
+		WorkerStats& stats = workerStats[ti];
+		ShapeScheduler::Chunk chunk;
+		while (scheduler.next(ti, chunk)) {
+			if (control != nullptr && control->isCanceled())
+				break;
 
-			prt::InitialShape const* const* isRangeStart = &rawInitialShapes[offsets[ti]];
-			callbacks[ti] = std::make_unique<RhinoCallbacks>(initialShapesPerThread[ti]);
+			const auto chunkStart = std::chrono::steady_clock::now();
 
+			RhinoCallbacks& callbacks = scratch.getCallbacks(chunk.count);
+			callbacks.setGenerationControl(control);
 			const prt::Status generateStatus = prt::generate(
-			        isRangeStart, initialShapesPerThread[ti], nullptr, ALL_ENCODER_IDS.data(), ALL_ENCODER_IDS.size(),
-			        encoderOptions.data(), callbacks[ti].get(), prtCache, nullptr);
+			        &rawInitialShapes[chunk.offset], chunk.count, nullptr, encoderIDs.data(), encoderIDs.size(),
+			        encoderOptions.data(), &callbacks, prtCache, nullptr, generateOptions.get());
 
 			if (generateStatus != prt::STATUS_OK) {
-				LOG_WRN << "generation (batch " << ti << ") failed with status: '"
-				        << prt::getStatusDescription(generateStatus) << "' (" << generateStatus << ")";
+				LOG_WRN << "generation (shapes " << chunk.offset << " to " << chunk.offset + chunk.count - 1
+				        << ") failed with status: '" << prt::getStatusDescription(generateStatus) << "' ("
+				        << generateStatus << ")";
 			}
-		});
-		futures.emplace_back(std::move(f));
-	}
-	std::for_each(futures.begin(), futures.end(), [](std::future<void>& f) { f.wait(); });
 
-	std::vector<GeneratedModelPtr> generatedModels(initialShapes.size());
-	for (size_t ri = 0; ri < callbacks.size(); ri++) {
-		const std::vector<GeneratedModelPtr>& models = callbacks[ri]->getModels();
-		for (size_t mi = 0; mi < models.size(); mi++) {
-			generatedModels[offsets[ri] + mi] = models[mi];
+			// each chunk owns disjoint slots of the result vector, no need to synchronize
+			const std::chrono::steady_clock::duration chunkTime = std::chrono::steady_clock::now() - chunkStart;
+			const std::vector<GeneratedModelPtr>& models = callbacks.getModels();
+			for (size_t mi = 0; mi < models.size(); mi++)
+				generatedModels[order[chunk.offset + mi]] = models[mi];
+
+			if (generateStatus == prt::STATUS_OK) {
+				ShapeCostEstimator::ChunkTiming& chunkTiming = stats.chunkTimings.emplace_back();
+				chunkTiming.shapeIndices.assign(order.begin() + chunk.offset,
+				                                order.begin() + chunk.offset + chunk.count);
+				chunkTiming.seconds = std::chrono::duration<double>(chunkTime).count();
+			}
+
+			if (resultChannel != nullptr && (control == nullptr || !control->isCanceled())) {
+				for (size_t mi = 0; mi < models.size(); mi++)
+					resultChannel->push({order[chunk.offset + mi], models[mi]});
+			}
+
+			// the scratch callbacks would otherwise keep the models of their last chunk alive
+			callbacks.reset(0);
+
+			stats.busyTime += chunkTime;
+			stats.shapes += chunk.count;
+			stats.chunks++;
+			if (chunk.stolen)
+				stats.stolenChunks++;
+
+			if (control != nullptr)
+				control->addDone(chunk.count);
 		}
+		if (scratch.callbacks)
+			scratch.callbacks->setGenerationControl(nullptr);
+	}, drainResults);
+
+	logWorkerStats(workerStats, std::chrono::steady_clock::now() - batchStart);
+
+	if (control != nullptr && control->isCanceled()) {
+		LOG_INF << "Generation has been canceled, discarding partial results.";
+		return {};
 	}
 
+	for (WorkerStats& stats : workerStats)
+		std::move(stats.chunkTimings.begin(), stats.chunkTimings.end(), std::back_inserter(chunkTimings));
+
 	return generatedModels;
 }
 
@@ -166,7 +307,11 @@ std::tuple<std::wstring, pcu::RuleFileInfoPtr> getRuleFileAndInfo(const pcu::Res
 
 	// Create RuleFileInfo
 	prt::Status infoStatus = prt::STATUS_UNSPECIFIED_ERROR;
-	pcu::RuleFileInfoPtr ruleFileInfo(prt::createRuleFileInfo(ruleFileURI, PRTContext::get()->mPRTCache.get(), &infoStatus));
+	pcu::RuleFileInfoPtr ruleFileInfo;
+	{
+		const std::shared_lock<std::shared_mutex> cacheLock = PRTContext::get()->usePRTCache();
+		ruleFileInfo.reset(prt::createRuleFileInfo(ruleFileURI, PRTContext::get()->mPRTCache.get(), &infoStatus));
+	}
 
 	if (!ruleFileInfo || infoStatus != prt::STATUS_OK) {
 		LOG_ERR << "could not get rule file info from rule file " << ruleFile;
@@ -181,8 +326,6 @@ std::tuple<std::wstring, pcu::RuleFileInfoPtr> getRuleFileAndInfo(const pcu::Res
 ModelGenerator::ModelGenerator() {
 	pcu::AttributeMapBuilderPtr optionsBuilder(prt::AttributeMapBuilder::create());
 
-	mRhinoEncoderOptions = pcu::createValidatedOptions(ENCODER_ID_RHINO);
-
 	optionsBuilder->setString(L"name", FILE_CGA_ERROR);
 	const pcu::AttributeMapPtr errOptions(optionsBuilder->createAttributeMapAndReset());
 	mCGAErrorOptions = pcu::createValidatedOptions(ENCODER_ID_CGA_ERROR, errOptions.get());
@@ -190,6 +333,8 @@ ModelGenerator::ModelGenerator() {
 	optionsBuilder->setString(L"name", FILE_CGA_PRINT);
 	const pcu::AttributeMapPtr printOptions(optionsBuilder->createAttributeMapAndReset());
 	mCGAPrintOptions = pcu::createValidatedOptions(ENCODER_ID_CGA_PRINT, printOptions.get());
+
+	rebuildEncoderOptions();
 }
 
 pcu::ResolveMapSPtr ModelGenerator::getResolveMap(const std::wstring& rulePkg) {
@@ -213,10 +358,23 @@ pcu::ShapeAttributes ModelGenerator::getShapeAttributes(const std::wstring& rule
 }
 
 pcu::AttributeMapPtrVector ModelGenerator::evalDefaultAttributes(const std::wstring& rulePkg,
-										   const std::vector<RawInitialShape>& rawInitialShapes,
-                                           pcu::ShapeAttributes& shapeAttributes) {
+                                                                 const std::vector<RawInitialShape>& rawInitialShapes,
+                                                                 pcu::ShapeAttributes& shapeAttributes,
+                                                                 GenerationControl* control) {
 	pcu::ResolveMapSPtr resolveMap = getResolveMap(rulePkg);
 
+	// hand out the default values of a matching prefetch, they are only evaluated once
+	const uint64_t defaultAttributesKey = getDefaultAttributesKey(rulePkg, rawInitialShapes);
+	{
+		std::lock_guard<std::mutex> lock(mPrefetchedDefaultAttributesMutex);
+		if (!mPrefetchedDefaultAttributes.empty() && mPrefetchedDefaultAttributesKey == defaultAttributesKey) {
+			LOG_DBG << "using prefetched default attributes of " << rawInitialShapes.size() << " shapes";
+			pcu::AttributeMapPtrVector prefetchedDefaultAttributes;
+			std::swap(prefetchedDefaultAttributes, mPrefetchedDefaultAttributes);
+			return prefetchedDefaultAttributes;
+		}
+	}
+
 	// setup encoder options for attribute evaluation encoder
 	constexpr const wchar_t* encs[] = {ENCODER_ID_CGA_EVALATTR};
 	constexpr size_t encsCount = sizeof(encs) / sizeof(encs[0]);
@@ -238,16 +396,32 @@ pcu::AttributeMapPtrVector ModelGenerator::evalDefaultAttributes(const std::wstr
 	if (!createInitialShapes(resolveMap, rawInitialShapes, shapeAttributes, attribMapBuilders, initialShapes,
 	                         initialShapeAttributes))
 		return {};
+	if (initialShapes.empty())
+		return {};
 
-	// run generate
-	AttrEvalCallbacks aec(attribMapBuilders, shapeAttributes.ruleFileInfo); // TODO: What if rule file info is not the same for all shapes?
+	// run generate on the calling thread instead of the generation pool, which would wait for a running generation.
+	// PRT gets the threads of the pool settings to evaluate within a call, each chunk of shapes writes into its own
+	// range of attribMapBuilders.
 	const std::vector<prt::InitialShape const*> rawInitialShapePtrs = toRawPtrs<const prt::InitialShape>(initialShapes);
-	const prt::Status status = prt::generate(rawInitialShapePtrs.data(), rawInitialShapePtrs.size(), nullptr, encs,
-	                                         encsCount, encsOpts, &aec, PRTContext::get()->mPRTCache.get(), nullptr);
-	if (status != prt::STATUS_OK) {
-		LOG_ERR << "Failed to get default rule attributes: '" << prt::getStatusDescription(status) << "' (" << status
-		        << ")";
-		return {};
+	const pcu::AttributeMapPtr generateOptions =
+	        createGenerateOptions(1, PRTContext::get()->getGenerationThreadBudget());
+	const std::shared_lock<std::shared_mutex> cacheLock = PRTContext::get()->usePRTCache();
+
+	for (size_t first = 0; first < rawInitialShapePtrs.size(); first += ATTRIBUTE_EVAL_CHUNK_SIZE) {
+		if (control != nullptr && control->isCanceled())
+			return {};
+
+		// TODO: What if rule file info is not the same for all shapes?
+		const size_t count = std::min(ATTRIBUTE_EVAL_CHUNK_SIZE, rawInitialShapePtrs.size() - first);
+		AttrEvalCallbacks aec(attribMapBuilders, shapeAttributes.ruleFileInfo, first);
+		const prt::Status status =
+		        prt::generate(&rawInitialShapePtrs[first], count, nullptr, encs, encsCount, encsOpts, &aec,
+		                      PRTContext::get()->mPRTCache.get(), nullptr, generateOptions.get());
+		if (status != prt::STATUS_OK) {
+			LOG_ERR << "Failed to get default rule attributes: '" << prt::getStatusDescription(status) << "' ("
+			        << status << ")";
+			return {};
+		}
 	}
 
 	pcu::AttributeMapPtrVector defaultValuesMap = createAttributeMaps(attribMapBuilders);
@@ -255,29 +429,33 @@ pcu::AttributeMapPtrVector ModelGenerator::evalDefaultAttributes(const std::wstr
 	return defaultValuesMap;
 }
 
-bool ModelGenerator::createInitialShapes(
-	pcu::ResolveMapSPtr& resolveMap,
-	const std::vector<RawInitialShape>& rawInitialShapes,
-    const pcu::ShapeAttributes& shapeAttributes,
-    pcu::AttributeMapBuilderVector& aBuilders,
-    std::vector<pcu::InitialShapePtr>& initialShapes,
-    std::vector<pcu::AttributeMapPtr>& initialShapesAttributes) const {
+bool ModelGenerator::createInitialShapes(pcu::ResolveMapSPtr& resolveMap,
+                                         const std::vector<RawInitialShape>& rawInitialShapes,
+                                         const pcu::ShapeAttributes& shapeAttributes,
+                                         pcu::AttributeMapBuilderVector& aBuilders,
+                                         std::vector<pcu::InitialShapePtr>& initialShapes,
+                                         std::vector<pcu::AttributeMapPtr>& initialShapesAttributes,
+                                         std::vector<GeneratedModelCache::Key>* cacheKeys,
+                                         uint64_t rulePackageKey,
+                                         size_t first,
+                                         size_t last,
+                                         std::vector<size_t>* representatives,
+                                         bool localShapes) const {
+	assert(representatives == nullptr || cacheKeys != nullptr);
 
 	pcu::InitialShapeBuilderPtr isb(prt::InitialShapeBuilder::create());
-	initialShapes.reserve(rawInitialShapes.size());
-	initialShapesAttributes.reserve(rawInitialShapes.size());
-
-	for (size_t i = 0; i < rawInitialShapes.size(); ++i) {
+	last = std::min(last, rawInitialShapes.size());
+	initialShapes.resize(rawInitialShapes.size());
+	initialShapesAttributes.resize(rawInitialShapes.size());
+	if (cacheKeys != nullptr)
+		cacheKeys->resize(rawInitialShapes.size());
+	if (representatives != nullptr)
+		representatives->resize(rawInitialShapes.size());
+	std::unordered_map<GeneratedModelCache::Key, size_t> firstShapeOfKey;
+
+	for (size_t i = first; i < last; ++i) {
 		const RawInitialShape& ris = rawInitialShapes[i];
 
-		const prt::Status geometryStatus =
-		        isb->setGeometry(ris.getVertices(), ris.getVertexCount(), ris.getIndices(), ris.getIndexCount(),
-		                         ris.getFaceCounts(), ris.getFaceCountsCount());
-		if (geometryStatus != prt::STATUS_OK) {
-			LOG_ERR << "Encountered invalid initial shape geometry: " << prt::getStatusDescription(geometryStatus);
-			return false;
-		}
-
 		// Set to default values
 		std::wstring ruleF = shapeAttributes.ruleFile;
 		std::wstring startR = shapeAttributes.startRule;
@@ -287,6 +465,32 @@ bool ModelGenerator::createInitialShapes(
 		pcu::AttributeMapPtr initialShapeAttributes;
 		extractMainShapeAttributes(aBuilders[i], shapeAttributes, ruleF, startR, randomS, shapeN, initialShapeAttributes);
 
+		if (cacheKeys != nullptr)
+			(*cacheKeys)[i] = GeneratedModelCache::createKey(
+			        rulePackageKey, ruleF, startR, randomS, shapeN, initialShapeAttributes.get(),
+			        localShapes ? ris.getLocalGeometryHash() : ris.getGeometryHash());
+
+		// shapes with the same geometry and attributes share the initial shape of the first one
+		if (representatives != nullptr) {
+			const size_t representative = firstShapeOfKey.emplace((*cacheKeys)[i], i).first->second;
+			(*representatives)[i] = representative;
+			if (representative != i)
+				continue;
+		}
+
+		std::vector<double> localVertices;
+		if (localShapes)
+			localVertices = ris.getLocalVertices();
+		const double* vertices = localShapes ? localVertices.data() : ris.getVertices();
+
+		const prt::Status geometryStatus =
+		        isb->setGeometry(vertices, ris.getVertexCount(), ris.getIndices(), ris.getIndexCount(),
+		                         ris.getFaceCounts(), ris.getFaceCountsCount());
+		if (geometryStatus != prt::STATUS_OK) {
+			LOG_ERR << "Encountered invalid initial shape geometry: " << prt::getStatusDescription(geometryStatus);
+			return false;
+		}
+
 		const prt::Status attributeStatus = isb->setAttributes(ruleF.c_str(), startR.c_str(), randomS, shapeN.c_str(),
 		                                                       initialShapeAttributes.get(), resolveMap.get());
 		if (attributeStatus != prt::STATUS_OK) {
@@ -301,31 +505,282 @@ bool ModelGenerator::createInitialShapes(
 			return false;
 		}
 
-		initialShapes.emplace_back(std::move(initialShape));
-		initialShapesAttributes.emplace_back(std::move(initialShapeAttributes));
+		initialShapes[i] = std::move(initialShape);
+		initialShapesAttributes[i] = std::move(initialShapeAttributes);
 	}
 
 	return true;
 }
 
+void ModelGenerator::prefetch(const std::wstring& rulePkg, const std::vector<RawInitialShape>& rawInitialShapes,
+                              GenerationControl& control) {
+	try {
+		// taken before loading, a modification while prefetching leaves a key which no longer matches the file
+		const uint64_t defaultAttributesKey = getDefaultAttributesKey(rulePkg, rawInitialShapes);
+
+		// loads the rule package and puts its rule file info into the PRT cache
+		pcu::ShapeAttributes shapeAttributes = getShapeAttributes(rulePkg);
+		if (control.isCanceled() || rawInitialShapes.empty())
+			return;
+
+		pcu::AttributeMapPtrVector defaultAttributes =
+		        evalDefaultAttributes(rulePkg, rawInitialShapes, shapeAttributes, &control);
+		if (control.isCanceled() || defaultAttributes.empty())
+			return;
+
+		std::lock_guard<std::mutex> lock(mPrefetchedDefaultAttributesMutex);
+		mPrefetchedDefaultAttributesKey = defaultAttributesKey;
+		mPrefetchedDefaultAttributes = std::move(defaultAttributes);
+		LOG_DBG << "prefetched " << rulePkg << " for " << rawInitialShapes.size() << " shapes";
+	}
+	catch (const std::exception& e) {
+		LOG_WRN << "failed to prefetch rule package " << rulePkg << ": " << e.what();
+	}
+}
+
+uint64_t ModelGenerator::getDefaultAttributesKey(const std::wstring& rulePkg,
+                                                 const std::vector<RawInitialShape>& rawInitialShapes) {
+	// the file itself instead of the loaded resolve map, which is only updated once the modified file is loaded
+	pcu::Hasher hasher;
+	hasher.add(GeneratedModelCache::getRulePackageKey(rulePkg, ResolveMap::ResolveMapCache::getFileTimeStamp(rulePkg)));
+	hasher.add(rawInitialShapes.size());
+	for (const RawInitialShape& ris : rawInitialShapes)
+		hasher.add(ris.getGeometryHash());
+	return hasher.get();
+}
+
+void ModelGenerator::setMemoryBudget(size_t bytes) {
+	mMemoryBudget = bytes;
+}
+
+void ModelGenerator::setPositionIndependent(const std::wstring& rulePkg, bool positionIndependent) {
+	if (positionIndependent)
+		mPositionIndependentRulePackages.insert(rulePkg);
+	else
+		mPositionIndependentRulePackages.erase(rulePkg);
+}
+
+bool ModelGenerator::isPositionIndependent(const std::wstring& rulePkg) const {
+	return mPositionIndependentRulePackages.count(rulePkg) > 0;
+}
+
+size_t ModelGenerator::getChunkSize(size_t shapeCount) const {
+	if (mMemoryBudget == 0 || shapeCount == 0)
+		return std::max<size_t>(shapeCount, 1);
+
+	// keep enough shapes per chunk for all workers to balance their load
+	const size_t minChunkSize = PRTContext::get()->getGenerationPool().getWorkerCount() * 8;
+	const size_t budgetChunkSize =
+	        static_cast<size_t>(static_cast<double>(mMemoryBudget) / std::max(mAverageModelBytes, 1.0));
+	return std::min(std::max(budgetChunkSize, minChunkSize), shapeCount);
+}
+
 std::vector<GeneratedModelPtr> ModelGenerator::generateModel(const std::wstring& rulePkg,
-															 const std::vector<RawInitialShape>& rawInitialShapes,
+                                                             const std::vector<RawInitialShape>& rawInitialShapes,
                                                              const pcu::ShapeAttributes& shapeAttributes,
-                                                             pcu::AttributeMapBuilderVector& aBuilders) {
+                                                             pcu::AttributeMapBuilderVector& aBuilders,
+                                                             GenerationControl* control,
+                                                             ResultChannel* resultChannel,
+                                                             const GenerateOptions& options) {
+	return generate(rulePkg, rawInitialShapes, shapeAttributes, aBuilders, getEncoderSetup(options), control,
+	                resultChannel);
+}
+
+std::vector<GeneratedModelPtr> ModelGenerator::generateReports(const std::wstring& rulePkg,
+                                                               const std::vector<RawInitialShape>& rawInitialShapes,
+                                                               const pcu::ShapeAttributes& shapeAttributes,
+                                                               pcu::AttributeMapBuilderVector& aBuilders,
+                                                               GenerationControl* control) {
+	return generate(rulePkg, rawInitialShapes, shapeAttributes, aBuilders, mReportsEncoderSetup, control, nullptr);
+}
+
+std::vector<GeneratedModelPtr> ModelGenerator::generate(const std::wstring& rulePkg,
+                                                        const std::vector<RawInitialShape>& rawInitialShapes,
+                                                        const pcu::ShapeAttributes& shapeAttributes,
+                                                        pcu::AttributeMapBuilderVector& aBuilders,
+                                                        const EncoderSetup& encoderSetup, GenerationControl* control,
+                                                        ResultChannel* resultChannel) {
+	const auto generateStart = std::chrono::steady_clock::now();
+	const bool withGeometry = (encoderSetup.channels & OutputChannel::GEOMETRY) != 0;
+	const bool withProxies = encoderSetup.options.proxyMode != ProxyMode::NONE;
+	const bool withDecimation = !withProxies && !encoderSetup.options.isDefault();
+	const bool withLevels = !withProxies && !encoderSetup.options.lodRatios.empty();
 
 	pcu::ResolveMapSPtr resolveMap = getResolveMap(rulePkg);
 
+	// position independent rules are generated at the local origin of each shape, models in local coordinates can be
+	// reused for all translated copies of a shape
+	const bool localShapes = isPositionIndependent(rulePkg);
+
+	// the encoder options are part of the key as well, the persistent cache outlives any option change
+	const uint64_t rulePackageKey =
+	        pcu::Hasher()
+	                .add(GeneratedModelCache::getRulePackageKey(rulePkg,
+	                                                            PRTContext::get()->getResolveMapTimeStamp(rulePkg)))
+	                .add(encoderSetup.key)
+	                .add(localShapes)
+	                .get();
+
+	// a modified rule package loaded by an attribute query waits for the generation before flushing the PRT cache
+	const std::shared_lock<std::shared_mutex> cacheLock = PRTContext::get()->usePRTCache();
+
 	try {
+		const size_t shapeCount = rawInitialShapes.size();
+		if (shapeCount == 0)
+			return {};
+
+		// schedule the expensive shapes first, based on their geometry and on timings of previous runs
+		GenerationHistory& history = getGenerationHistory(rulePkg);
+		ShapeCostEstimator costEstimator(history, shapeAttributes.startRule);
+		std::vector<uint64_t> shapeKeys(shapeCount);
+		std::vector<double> featureCosts(shapeCount);
+		std::vector<double> estimatedCosts(shapeCount);
+		for (size_t i = 0; i < shapeCount; i++) {
+			const RawInitialShape& ris = rawInitialShapes[i];
+			shapeKeys[i] = ris.getGeometryHash();
+			featureCosts[i] = ShapeCostEstimator::getFeatureCost(ris.getVertices(), ris.getVertexCount(),
+			                                                     ris.getIndices(), ris.getFaceCounts(),
+			                                                     ris.getFaceCountsCount());
+			estimatedCosts[i] = costEstimator.estimate(shapeKeys[i], featureCosts[i]);
+		}
+
+		// the initial shapes only exist for the chunk being generated, the slots of the other chunks stay empty
 		std::vector<pcu::InitialShapePtr> initialShapes;
 		std::vector<pcu::AttributeMapPtr> initialShapeAttributes; // put here to ensure same life time as initialShapes
-		if (!createInitialShapes(resolveMap, rawInitialShapes, shapeAttributes, aBuilders, initialShapes, initialShapeAttributes))
-			return {};
+		std::vector<GeneratedModelCache::Key> cacheKeys;
+		std::vector<size_t> representatives; // index of the first shape with the same content
+		std::vector<GeneratedModelPtr> generatedModels(shapeCount);
+		size_t reusedCount = 0;
+		size_t duplicateCount = 0;
+
+		if (control != nullptr)
+			control->start(shapeCount);
+
+		const size_t chunkSize = getChunkSize(shapeCount);
+		if (chunkSize < shapeCount)
+			LOG_DBG << "generating " << shapeCount << " shapes in chunks of " << chunkSize << " shapes (memory budget: "
+			        << mMemoryBudget / (1024 * 1024) << " MB)";
+
+		for (size_t first = 0; first < shapeCount; first += chunkSize) {
+			const size_t last = std::min(first + chunkSize, shapeCount);
+			if (control != nullptr && control->isCanceled())
+				return {};
+
+			if (!createInitialShapes(resolveMap, rawInitialShapes, shapeAttributes, aBuilders, initialShapes,
+			                         initialShapeAttributes, &cacheKeys, rulePackageKey, first, last, &representatives,
+			                         localShapes))
+				return {};
+
+			const auto deliverModel = [&](size_t shapeIndex, const GeneratedModelPtr& localModel) {
+				const GeneratedModelPtr model =
+				        localShapes ? localModel->createTranslatedCopy(rawInitialShapes[shapeIndex].getLocalOrigin())
+				                    : localModel;
+				if (resultChannel != nullptr)
+					resultChannel->push({shapeIndex, model});
+				else
+					generatedModels[shapeIndex] = model;
+			};
+
+			// only generate the unique shapes whose content changed since they were last generated
+			std::vector<GeneratedModelPtr> uniqueModels(last - first);
+			std::vector<size_t> shapesToGenerate;
+			size_t chunkDuplicateCount = 0;
+			for (size_t i = first; i < last; i++) {
+				if (representatives[i] != i) {
+					chunkDuplicateCount++;
+					continue;
+				}
+
+				GeneratedModelPtr cachedModel = mModelCache.get(cacheKeys[i]);
+				if (!cachedModel) {
+					cachedModel = mDiskCache.load(cacheKeys[i]);
+					if (cachedModel)
+						mModelCache.put(cacheKeys[i], cachedModel);
+				}
+				if (!cachedModel) {
+					shapesToGenerate.push_back(i);
+					continue;
+				}
+
+				reusedCount++;
+				uniqueModels[i - first] = cachedModel;
+				deliverModel(i, cachedModel);
+			}
+			if (control != nullptr)
+				control->addDone(last - first - chunkDuplicateCount - shapesToGenerate.size());
+
+			// local models still need to be moved into place, they are delivered once the chunk is done
+			std::vector<ShapeCostEstimator::ChunkTiming> chunkTimings;
+			const std::vector<GeneratedModelPtr> chunkModels =
+			        batchGenerate(initialShapes, shapesToGenerate, estimatedCosts, chunkTimings,
+			                      encoderSetup.encoderIDs, encoderSetup.encoderOptions,
+			                      PRTContext::get()->mPRTCache.get(), control, localShapes ? nullptr : resultChannel);
+
+			if (chunkModels.empty())
+				return {}; // canceled
+
+			// the timings without geometry, of proxies or decimated meshes would skew the cost estimates of the full
+			// generation
+			if (withGeometry && encoderSetup.options.isDefault())
+				costEstimator.update(shapeKeys, featureCosts, chunkTimings);
+
+			for (size_t i : shapesToGenerate) {
+				const GeneratedModelPtr& model = chunkModels[i];
+				if (!model)
+					continue;
+				const size_t modelBytes = model->getMemoryUsage();
+				mAverageModelBytes = (1.0 - MODEL_BYTES_SMOOTHING) * mAverageModelBytes +
+				                     MODEL_BYTES_SMOOTHING * static_cast<double>(modelBytes);
+				mModelCache.put(cacheKeys[i], model);
+				mDiskCache.store(cacheKeys[i], model);
+				uniqueModels[i - first] = model;
+				if (localShapes || resultChannel == nullptr)
+					deliverModel(i, model); // otherwise the channel already got the model from batchGenerate
+			}
+
+			// fan the models of the unique shapes out to their duplicates
+			for (size_t i = first; i < last; i++) {
+				const size_t representative = representatives[i];
+				if (representative != i && uniqueModels[representative - first])
+					deliverModel(i, uniqueModels[representative - first]);
+			}
+			if (control != nullptr)
+				control->addDone(chunkDuplicateCount);
+			duplicateCount += chunkDuplicateCount;
+
+			// the chunk has been handed off, release its PRT inputs
+			for (size_t i = first; i < last; i++) {
+				initialShapes[i].reset();
+				initialShapeAttributes[i].reset();
+				aBuilders[i].reset();
+			}
+		}
 
-		const std::vector<const prt::AttributeMap*> encoderOptions = {mRhinoEncoderOptions.get(),
-		                                                              mCGAErrorOptions.get(), mCGAPrintOptions.get()};
+		history.saveDeferred();
 
-		const std::vector<GeneratedModelPtr> generatedModels =
-		        batchGenerate(initialShapes, encoderOptions, PRTContext::get()->mPRTCache.get());
+		LOG_DBG << "deduplication: " << shapeCount - duplicateCount << " unique of " << shapeCount
+		        << " shapes (dedup ratio: " << static_cast<double>(duplicateCount) / static_cast<double>(shapeCount)
+		        << ")";
+		LOG_DBG << "model cache: " << reusedCount << " of " << shapeCount - duplicateCount
+		        << " shapes reused (total hits: " << mModelCache.getHits()
+		        << ", misses: " << mModelCache.getMisses() << ", " << mModelCache.getEntryCount() << " models, "
+		        << mModelCache.getByteSize() / (1024 * 1024) << " MB, disk hits: " << mDiskCache.getHits()
+		        << ", disk misses: " << mDiskCache.getMisses() << ")";
+
+		// throughput, to compare the reports-only or proxy generation with the full generation of the same shapes
+		const double seconds =
+		        std::chrono::duration<double>(std::chrono::steady_clock::now() - generateStart).count();
+		const char* generationKind = "generation";
+		if (withProxies)
+			generationKind = "proxy generation";
+		else if (withLevels)
+			generationKind = "generation with levels of detail";
+		else if (withDecimation)
+			generationKind = "decimated generation";
+		else if (!withGeometry)
+			generationKind = "generation without geometry";
+		LOG_DBG << generationKind << ": " << shapeCount << " shapes in " << seconds * 1000.0 << "ms ("
+		        << static_cast<double>(shapeCount) / std::max(seconds, 1e-9) << " shapes/s)";
 
 		return generatedModels;
 	}
@@ -339,11 +794,147 @@ std::vector<GeneratedModelPtr> ModelGenerator::generateModel(const std::wstring&
 	return {};
 }
 
+void ModelGenerator::saveGenerationHistory() {
+	if (mGenerationHistory)
+		mGenerationHistory->save();
+}
+
+GenerationHistory& ModelGenerator::getGenerationHistory(const std::wstring& rulePkg) {
+	if (!mGenerationHistory || mGenerationHistory->getRulePackage() != rulePkg)
+		mGenerationHistory = std::make_unique<GenerationHistory>(rulePkg, getGenerationHistoryPath(rulePkg));
+	return *mGenerationHistory;
+}
+
 void ModelGenerator::updateEncoderOptions(bool emitMaterials) {
+	mEmitMaterials = emitMaterials;
+	rebuildEncoderOptions();
+}
+
+void ModelGenerator::setInstancing(bool instancing) {
+	if (mInstancing == instancing)
+		return;
+	mInstancing = instancing;
+	rebuildEncoderOptions();
+}
+
+void ModelGenerator::setSinglePrecision(bool singlePrecision) {
+	if (mSinglePrecision == singlePrecision)
+		return;
+	mSinglePrecision = singlePrecision;
+	rebuildEncoderOptions();
+}
+
+void ModelGenerator::setVertexWelding(bool enabled, double positionTolerance, double normalTolerance,
+                                      double uvTolerance) {
+	const std::array<double, 3> tolerances = {std::max(positionTolerance, 0.0), std::max(normalTolerance, 0.0),
+	                                          std::max(uvTolerance, 0.0)};
+	if (mWeldVertices == enabled && mWeldTolerances == tolerances)
+		return;
+	mWeldVertices = enabled;
+	mWeldTolerances = tolerances;
+	rebuildEncoderOptions();
+}
+
+void ModelGenerator::setOutputChannels(uint32_t channels) {
+	channels &= OutputChannel::ALL;
+	if (mOutputChannels == channels)
+		return;
+	mOutputChannels = channels;
+	rebuildEncoderOptions();
+}
+
+void ModelGenerator::rebuildEncoderOptions() {
+	mEncoderSetup = createEncoderSetup(mOutputChannels);
+	mReportsEncoderSetup = createEncoderSetup(OutputChannel::REPORTS);
+	mCallEncoderSetups.clear();
+
+	// the cached models stay valid, the encoder options are part of their keys
+}
+
+const ModelGenerator::EncoderSetup& ModelGenerator::getEncoderSetup(const GenerateOptions& options) {
+	if (options.isDefault())
+		return mEncoderSetup;
+
+	const auto key =
+	        std::make_tuple(options.proxyMode, options.decimationRatio, options.decimationError, options.lodRatios);
+	auto it = mCallEncoderSetups.find(key);
+	if (it == mCallEncoderSetups.end()) {
+		// e.g. a decimation slider creates a setup per value, all of them are dropped once there are too many
+		if (mCallEncoderSetups.size() >= MAX_CALL_ENCODER_SETUPS)
+			mCallEncoderSetups.clear();
+
+		// the boxes have neither normals nor texture coordinates, and no materials
+		uint32_t channels = mOutputChannels;
+		if (options.proxyMode != ProxyMode::NONE) {
+			channels = (channels & ~(OutputChannel::NORMALS | OutputChannel::UVS | OutputChannel::MATERIALS)) |
+			           OutputChannel::GEOMETRY;
+		}
+		it = mCallEncoderSetups.emplace(key, createEncoderSetup(channels, options)).first;
+	}
+	return it->second;
+}
+
+ModelGenerator::EncoderSetup ModelGenerator::createEncoderSetup(uint32_t channels,
+                                                                const GenerateOptions& options) const {
+	const bool emitGeometry = (channels & OutputChannel::GEOMETRY) != 0;
+	const bool emitMaterials = emitGeometry && mEmitMaterials && (channels & OutputChannel::MATERIALS) != 0;
+	const uint32_t proxyMode = options.proxyMode;
+
+	EncoderSetup setup;
+	setup.channels = channels;
+	setup.options = options;
+
+	// the encoder's proxyBoxes option: 0 none, 1 axis-aligned, 2 oriented
+	int32_t proxyBoxes = 0;
+	if ((proxyMode & ProxyMode::ORIENTED) != 0)
+		proxyBoxes = 2;
+	else if ((proxyMode & ProxyMode::AXIS_ALIGNED) != 0)
+		proxyBoxes = 1;
+
 	pcu::AttributeMapBuilderPtr optionsBuilder(prt::AttributeMapBuilder::create());
+	optionsBuilder->setBool(L"emitGeometry", emitGeometry);
+	optionsBuilder->setBool(L"emitNormals", emitGeometry && (channels & OutputChannel::NORMALS) != 0);
+	optionsBuilder->setBool(L"emitUVs", emitGeometry && (channels & OutputChannel::UVS) != 0);
+	optionsBuilder->setBool(L"emitReport", (channels & OutputChannel::REPORTS) != 0);
 	optionsBuilder->setBool(L"emitMaterials", emitMaterials);
+	optionsBuilder->setBool(L"instancing", mInstancing);
+	optionsBuilder->setBool(L"singlePrecision", mSinglePrecision);
+	optionsBuilder->setBool(L"weldVertices", mWeldVertices);
+	optionsBuilder->setFloat(L"weldTolerancePosition", mWeldTolerances[0]);
+	optionsBuilder->setFloat(L"weldToleranceNormal", mWeldTolerances[1]);
+	optionsBuilder->setFloat(L"weldToleranceUV", mWeldTolerances[2]);
+	optionsBuilder->setInt(L"proxyBoxes", proxyBoxes);
+	optionsBuilder->setBool(L"proxyPerLeaf", (proxyMode & ProxyMode::PER_LEAF_SHAPE) != 0);
+	optionsBuilder->setFloat(L"decimationRatio", options.decimationRatio);
+	optionsBuilder->setFloat(L"decimationError", options.decimationError);
+	optionsBuilder->setFloatArray(L"lodRatios", options.lodRatios.data(), options.lodRatios.size());
 	pcu::AttributeMapPtr rawOptions(optionsBuilder->createAttributeMap());
-	mRhinoEncoderOptions = pcu::createValidatedOptions(ENCODER_ID_RHINO, rawOptions.get());
+	setup.rhinoEncoderOptions = pcu::createValidatedOptions(ENCODER_ID_RHINO, rawOptions.get());
+	setup.key = pcu::Hasher()
+	                    .add(channels)
+	                    .add(proxyMode)
+	                    .add(options.decimationRatio)
+	                    .add(options.decimationError)
+	                    .add(options.lodRatios.data(), options.lodRatios.size())
+	                    .add(mEmitMaterials)
+	                    .add(mInstancing)
+	                    .add(mSinglePrecision)
+	                    .add(mWeldVertices)
+	                    .add(mWeldTolerances.data(), mWeldTolerances.size())
+	                    .get();
+
+	// the Rhino encoder also delivers the reports, prints and errors come from encoders of their own
+	setup.encoderIDs = {ENCODER_ID_RHINO};
+	setup.encoderOptions = {setup.rhinoEncoderOptions.get()};
+	if ((channels & OutputChannel::ERRORS) != 0) {
+		setup.encoderIDs.push_back(ENCODER_ID_CGA_ERROR);
+		setup.encoderOptions.push_back(mCGAErrorOptions.get());
+	}
+	if ((channels & OutputChannel::PRINTS) != 0) {
+		setup.encoderIDs.push_back(ENCODER_ID_CGA_PRINT);
+		setup.encoderOptions.push_back(mCGAPrintOptions.get());
+	}
+	return setup;
 }
 
 void ModelGenerator::extractMainShapeAttributes(pcu::AttributeMapBuilderPtr& aBuilder,
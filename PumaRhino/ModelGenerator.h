@@ -20,13 +20,73 @@
 #pragma once
 
 #include "GeneratedModel.h"
+#include "GeneratedModelCache.h"
+#include "GeneratedModelDiskCache.h"
+#include "GenerationControl.h"
+#include "GenerationHistory.h"
 #include "PRTContext.h"
 #include "RawInitialShape.h"
 #include "ResolveMapCache.h"
+#include "ResultChannel.h"
 #include "RhinoCallbacks.h"
 #include "RuleAttributes.h"
 #include "utils.h"
 
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+/**
+ * Bits of the output channel mask, see ModelGenerator::setOutputChannels. The values are part of the C API.
+ */
+namespace OutputChannel {
+constexpr uint32_t GEOMETRY = 1u << 0;
+constexpr uint32_t NORMALS = 1u << 1;   // requires GEOMETRY
+constexpr uint32_t UVS = 1u << 2;       // requires GEOMETRY
+constexpr uint32_t MATERIALS = 1u << 3; // requires GEOMETRY
+constexpr uint32_t REPORTS = 1u << 4;
+constexpr uint32_t PRINTS = 1u << 5;
+constexpr uint32_t ERRORS = 1u << 6;
+constexpr uint32_t ALL = (1u << 7) - 1;
+} // namespace OutputChannel
+
+/**
+ * Bounding box proxies which replace the geometry of a generate call, e.g. to show the massing before the detailed
+ * models. The values are part of the C API.
+ */
+namespace ProxyMode {
+constexpr uint32_t NONE = 0;
+constexpr uint32_t AXIS_ALIGNED = 1u << 0;
+constexpr uint32_t ORIENTED = 1u << 1;       // smallest footprint, rotated about the vertical axis
+constexpr uint32_t PER_LEAF_SHAPE = 1u << 2; // one box per leaf shape instead of one per initial shape
+} // namespace ProxyMode
+
+/**
+ * Output options of a single generate call, on top of the settings of the generator. Calls with other than the default
+ * options are cached apart from each other.
+ */
+struct GenerateOptions {
+	uint32_t proxyMode = ProxyMode::NONE; // see ProxyMode, replaces the geometry
+
+	// quadric error decimation of the meshes: the fraction of the triangles to keep (1 keeps all) and the maximum
+	// error of a collapse in model units (0 for no bound). Material boundaries and texture seams are preserved.
+	double decimationRatio = 1.0;
+	double decimationError = 0.0;
+
+	// coarser levels of detail derived from the (decimated) meshes: the fraction of their triangles to keep per level,
+	// in decreasing order. The levels share the vertices of the full detail, see ModelPart::mLevels.
+	std::vector<double> lodRatios;
+
+	bool isDefault() const {
+		return proxyMode == ProxyMode::NONE && decimationRatio >= 1.0 && decimationError <= 0.0 && lodRatios.empty();
+	}
+};
+
 /**
  * Entry point of the PRT. Is given an initial shape and rpk package, gives them to the PRT and gets the results.
  */
@@ -36,33 +96,183 @@ public:
 
 	pcu::ResolveMapSPtr getResolveMap(const std::wstring& rulePkg);
 
+	/**
+	 * @param control optional, allows to cancel the generation and receive progress updates. A canceled generation
+	 * returns no models.
+	 * @param resultChannel optional, receives each model as soon as its shape has been generated (in completion order).
+	 * Must have been created on the calling thread, which consumes the models while it waits for the generation
+	 * workers, see ResultChannel. The models are then only delivered through the channel and the returned vector holds
+	 * null entries, so that finished chunks can be released while the rest of the shapes are generated. A non-empty
+	 * vector still signals success.
+	 * The shapes are generated in chunks sized against the memory budget, the attribute map builders of a chunk are
+	 * consumed as soon as the chunk has been handed off.
+	 * @param options per call outputs like proxies, decimated meshes or levels of detail, the proxies are generated
+	 * without normals, texture coordinates and materials.
+	 */
 	std::vector<GeneratedModelPtr> generateModel(const std::wstring& rulePkg,
 	                                             const std::vector<RawInitialShape>& rawInitialShapes,
 	                                             const pcu::ShapeAttributes& shapeAttributes,
-	                                             pcu::AttributeMapBuilderVector& aBuilders);
+	                                             pcu::AttributeMapBuilderVector& aBuilders,
+	                                             GenerationControl* control = nullptr,
+	                                             ResultChannel* resultChannel = nullptr,
+	                                             const GenerateOptions& options = {});
+
+	/**
+	 * Reports-only generation for design-space exploration: the rules are run without visiting the leaf shapes for
+	 * their geometry, the models only hold the CGA reports. Independent of the output channels, the models are cached
+	 * apart from the fully generated ones.
+	 */
+	std::vector<GeneratedModelPtr> generateReports(const std::wstring& rulePkg,
+	                                               const std::vector<RawInitialShape>& rawInitialShapes,
+	                                               const pcu::ShapeAttributes& shapeAttributes,
+	                                               pcu::AttributeMapBuilderVector& aBuilders,
+	                                               GenerationControl* control = nullptr);
 
 	pcu::AttributeMapPtrVector evalDefaultAttributes(const std::wstring& rulePkg,
 	                                                 const std::vector<RawInitialShape>& rawInitialShapes,
-	                           pcu::ShapeAttributes& shapeAttributes);
+	                                                 pcu::ShapeAttributes& shapeAttributes,
+	                                                 GenerationControl* control = nullptr);
+
+	/**
+	 * Loads the rule package, creates its rule file info and evaluates the default attributes of the shapes ahead of
+	 * time. The default attributes are kept for the next evalDefaultAttributes call with the same rule package and
+	 * shapes.
+	 */
+	void prefetch(const std::wstring& rulePkg, const std::vector<RawInitialShape>& rawInitialShapes,
+	              GenerationControl& control);
+
+	/**
+	 * Identifies the default attributes of the shapes for the current version of the rule package file, i.e. whether
+	 * a prefetch is still valid.
+	 */
+	static uint64_t getDefaultAttributesKey(const std::wstring& rulePkg,
+	                                        const std::vector<RawInitialShape>& rawInitialShapes);
 
 	pcu::ShapeAttributes getShapeAttributes(const std::wstring& rulePkg);
 
 	void updateEncoderOptions(bool emitMaterials);
 
+	/**
+	 * Lets the encoder emit repeated geometry (e.g. inserted assets) as prototypes with instance transformations
+	 * instead of baking each occurrence into the mesh parts.
+	 */
+	void setInstancing(bool instancing);
+
+	/**
+	 * Display-oriented output: the model vertices are stored as floats relative to the centroid of each shape, with one
+	 * double precision origin per model. Halves the vertex memory, the position error is bounded by half a float ulp of
+	 * the distance to the centroid (about 15 micrometers at 500 meters) regardless of georeferenced coordinates.
+	 */
+	void setSinglePrecision(bool singlePrecision);
+
+	/**
+	 * Welds the face corners whose positions, normals and texture coordinates are equal within the tolerances into
+	 * shared vertices, the resulting meshes are indexed instead of having one vertex per face corner. A tolerance of 0
+	 * only welds identical values.
+	 */
+	void setVertexWelding(bool enabled, double positionTolerance, double normalTolerance, double uvTolerance);
+
+	/**
+	 * Selects the outputs to generate as a mask of OutputChannel bits. The work of the other channels is skipped: the
+	 * encoders of unselected prints and errors are not run, and the Rhino encoder neither prepares nor converts
+	 * unselected geometry attributes. Without GEOMETRY, the leaf shapes are not visited at all.
+	 */
+	void setOutputChannels(uint32_t channels);
+
+	/**
+	 * Bounds the memory held by a single generateModel call: the shapes are generated in chunks whose models are
+	 * estimated to fit into the given number of bytes. 0 generates all shapes at once.
+	 */
+	void setMemoryBudget(size_t bytes);
+
+	/**
+	 * Opt-in for rules which do not depend on the absolute position of the initial shapes: their shapes are generated
+	 * at a local origin and the models are reused for all shapes which only differ by a translation. Must not be enabled
+	 * for rules which read absolute coordinates.
+	 */
+	void setPositionIndependent(const std::wstring& rulePkg, bool positionIndependent);
+	bool isPositionIndependent(const std::wstring& rulePkg) const;
+
 	const RuleAttributes getRuleAttributes(const std::wstring& rulePkg);
 
+	/**
+	 * Writes the pending generation timings, the generate calls only save them periodically.
+	 */
+	void saveGenerationHistory();
+
 private:
 
-	pcu::AttributeMapPtr mRhinoEncoderOptions;
+	/**
+	 * The encoders of a generate call and their options, derived from the output channels.
+	 */
+	struct EncoderSetup {
+		uint32_t channels = 0;
+		GenerateOptions options;
+		pcu::AttributeMapPtr rhinoEncoderOptions;
+		std::vector<const wchar_t*> encoderIDs;
+		std::vector<const prt::AttributeMap*> encoderOptions;
+		uint64_t key = 0; // distinguishes models generated with different encoder options
+	};
+
 	pcu::AttributeMapPtr mCGAErrorOptions;
 	pcu::AttributeMapPtr mCGAPrintOptions;
+	EncoderSetup mEncoderSetup;
+	EncoderSetup mReportsEncoderSetup;
+	std::map<std::tuple<uint32_t, double, double, std::vector<double>>, EncoderSetup> mCallEncoderSetups; // by options
+
+	GeneratedModelCache mModelCache;
+	GeneratedModelDiskCache mDiskCache{GeneratedModelDiskCache::getDefaultCacheDir()};
+	bool mEmitMaterials = true;
+	bool mInstancing = false;
+	bool mSinglePrecision = false;
+	bool mWeldVertices = false;
+	std::array<double, 3> mWeldTolerances = {1e-4, 1e-3, 1e-5}; // position, normal, uv
+	uint32_t mOutputChannels = OutputChannel::ALL;
+	void rebuildEncoderOptions();
+	EncoderSetup createEncoderSetup(uint32_t channels, const GenerateOptions& options = {}) const;
+	const EncoderSetup& getEncoderSetup(const GenerateOptions& options);
+
+	std::vector<GeneratedModelPtr> generate(const std::wstring& rulePkg,
+	                                        const std::vector<RawInitialShape>& rawInitialShapes,
+	                                        const pcu::ShapeAttributes& shapeAttributes,
+	                                        pcu::AttributeMapBuilderVector& aBuilders, const EncoderSetup& encoderSetup,
+	                                        GenerationControl* control, ResultChannel* resultChannel);
+
+	static constexpr size_t DEFAULT_MEMORY_BUDGET = 1024ull * 1024 * 1024;
+	static constexpr size_t MAX_CALL_ENCODER_SETUPS = 16;
+	static constexpr double MODEL_BYTES_SMOOTHING = 0.05;
+	size_t mMemoryBudget = DEFAULT_MEMORY_BUDGET;
+	double mAverageModelBytes = 64.0 * 1024; // running average of the generated model sizes
+	size_t getChunkSize(size_t shapeCount) const;
+
+	std::set<std::wstring> mPositionIndependentRulePackages;
+
+	// the prefetch runs concurrently to the attribute queries
+	std::mutex mPrefetchedDefaultAttributesMutex;
+	uint64_t mPrefetchedDefaultAttributesKey = 0;
+	pcu::AttributeMapPtrVector mPrefetchedDefaultAttributes;
+
+	std::unique_ptr<GenerationHistory> mGenerationHistory;
+	GenerationHistory& getGenerationHistory(const std::wstring& rulePkg);
 
+	/**
+	 * Creates the initial shapes in [first, last).
+	 * @param representatives optional, receives for each shape the index of the first shape in the range with the same
+	 * cache key. Initial shapes are only created for these representatives. Requires cacheKeys.
+	 * @param localShapes if true, the shapes are moved to their local origin and keyed by their local geometry.
+	 */
 	bool createInitialShapes(pcu::ResolveMapSPtr& resolveMap,
-							 const std::vector<RawInitialShape>& rawInitialShapes,
+	                         const std::vector<RawInitialShape>& rawInitialShapes,
 	                         const pcu::ShapeAttributes& shapeAttributes,
 	                         pcu::AttributeMapBuilderVector& aBuilders,
 	                         std::vector<pcu::InitialShapePtr>& initialShapes,
-	                         std::vector<pcu::AttributeMapPtr>& initialShapeAttributes) const;
+	                         std::vector<pcu::AttributeMapPtr>& initialShapeAttributes,
+	                         std::vector<GeneratedModelCache::Key>* cacheKeys = nullptr,
+	                         uint64_t rulePackageKey = 0,
+	                         size_t first = 0,
+	                         size_t last = std::numeric_limits<size_t>::max(),
+	                         std::vector<size_t>* representatives = nullptr,
+	                         bool localShapes = false) const;
 
 	void extractMainShapeAttributes(pcu::AttributeMapBuilderPtr& aBuilder, const pcu::ShapeAttributes& shapeAttr,
 	                                std::wstring& ruleFile, std::wstring& startRule, int32_t& seed,
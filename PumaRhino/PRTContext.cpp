@@ -81,9 +81,15 @@ PRTContext::PRTContext(prt::LogLevel minimalLogLevel)
 	}
 
 	LOG_INF << "PRT has been initialized.";
+
+	mGenerationPool = std::make_unique<GenerationPool>(GenerationConcurrency());
+	mGenerationThreadBudget = mGenerationPool->getWorkerCount();
 }
 
 PRTContext::~PRTContext() {
+	// workers might still reference PRT objects, stop them first
+	mGenerationPool.reset();
+
 	mResolveMapCache.reset();
 	LOG_INF << "Released RPK Cache";
 
@@ -101,18 +107,47 @@ PRTContext::~PRTContext() {
 }
 
 ResolveMap::ResolveMapCache::LookupResult PRTContext::getResolveMap(const std::filesystem::path& rpk) {
+	std::lock_guard<std::mutex> lock(mResolveMapCacheMutex);
 	auto lookupResult = mResolveMapCache->get(rpk);
 	if (lookupResult.second == ResolveMap::ResolveMapCache::CacheStatus::MISS) {
+		// a running generation still reads the entries of the previous rule package
+		std::unique_lock<std::shared_mutex> cacheLock(mPRTCacheMutex);
 		mPRTCache->flushAll();
 	}
 
 	return lookupResult;
 }
 
+std::chrono::system_clock::time_point PRTContext::getResolveMapTimeStamp(const std::filesystem::path& rpk) const {
+	std::lock_guard<std::mutex> lock(mResolveMapCacheMutex);
+	return mResolveMapCache->getTimeStamp(rpk);
+}
+
+std::shared_lock<std::shared_mutex> PRTContext::usePRTCache() {
+	return std::shared_lock<std::shared_mutex>(mPRTCacheMutex);
+}
+
 bool PRTContext::isAlive() const {
 	return !!mPRTHandle;
 }
 
+GenerationPool& PRTContext::getGenerationPool() const {
+	return *mGenerationPool;
+}
+
+size_t PRTContext::getGenerationThreadBudget() const {
+	return mGenerationThreadBudget;
+}
+
+void PRTContext::setGenerationConcurrency(const GenerationConcurrency& concurrency) {
+	if (mGenerationPool && mGenerationPool->getConcurrency() == concurrency)
+		return;
+
+	mGenerationPool.reset(); // join the old workers first
+	mGenerationPool = std::make_unique<GenerationPool>(concurrency);
+	mGenerationThreadBudget = mGenerationPool->getWorkerCount();
+}
+
 AssetCache& PRTContext::getAssetCache() const {
 	static const std::filesystem::path assetCacheParentPath = [] {
 		const auto p = PRTContext::getGlobalTempDir() / "asset_cache";
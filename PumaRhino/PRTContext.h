@@ -20,12 +20,16 @@
 #pragma once
 
 #include "AssetCache.h"
+#include "GenerationPool.h"
 #include "ResolveMapCache.h"
 #include "utils.h"
 
 #include "prt/ContentType.h"
 #include "prt/LogLevel.h"
 
+#include <atomic>
+#include <shared_mutex>
+
 /**
  * Helper struct to manage PRT lifetime
  */
@@ -38,13 +42,41 @@ public:
 	explicit PRTContext(prt::LogLevel minimalLogLevel);
 	~PRTContext();
 
+	/**
+	 * Thread-safe, attribute queries look up rule packages while a generation is running. A new or modified rule
+	 * package flushes the PRT cache, which waits until the current users of the cache are done, see usePRTCache.
+	 */
 	ResolveMap::ResolveMapCache::LookupResult getResolveMap(const std::filesystem::path& rpk);
+	std::chrono::system_clock::time_point getResolveMapTimeStamp(const std::filesystem::path& rpk) const;
+
+	/**
+	 * Keeps the PRT cache from being flushed while it is in use, e.g. by a generation. Must be released before calling
+	 * getResolveMap or getResolveMapTimeStamp.
+	 */
+	std::shared_lock<std::shared_mutex> usePRTCache();
+
 	bool isAlive() const;
 	AssetCache& getAssetCache() const;
+	GenerationPool& getGenerationPool() const;
+
+	/**
+	 * Number of threads of the generation pool, thread-safe. Work outside of the pool (e.g. the attribute evaluation)
+	 * passes it to PRT.
+	 */
+	size_t getGenerationThreadBudget() const;
+
+	/**
+	 * Restarts the generation pool if the settings changed. Must not be called while a generation is running.
+	 */
+	void setGenerationConcurrency(const GenerationConcurrency& concurrency);
 
 	pcu::ConsoleLogHandlerPtr mLogHandler;
 	pcu::FileLogHandlerPtr mFileLogHandler;
 	pcu::ObjectPtr mPRTHandle;
 	pcu::CachePtr mPRTCache;
 	ResolveMap::ResolveMapCacheUPtr mResolveMapCache;
+	mutable std::mutex mResolveMapCacheMutex;
+	std::shared_mutex mPRTCacheMutex; // shared by the users of mPRTCache, exclusive for flushing it
+	GenerationPoolUPtr mGenerationPool;
+	std::atomic<size_t> mGenerationThreadBudget = 1;
 };
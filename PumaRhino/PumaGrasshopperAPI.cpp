@@ -28,9 +28,11 @@
 #endif
 
 #include "RhinoPRT.h"
+#include "ResultChannel.h"
 #include "version.h"
 #include "utils.h"
 
+
 #define RHINOPRT_API __declspec(dllexport)
 
 constexpr bool DBG = false;
@@ -42,25 +44,16 @@ T static_cast_fct(const T1& x) {
 	return static_cast<T>(x);
 }
 
-} // namespace
-
-extern "C" {
-
-RHINOPRT_API void GetProductVersion(ON_wString* version_str) {
-	*version_str = VER_FILE_VERSION_STR;
-}
-
-RHINOPRT_API bool InitializeRhinoPRT() {
-	return RhinoPRT::get().InitializeRhinoPRT();
-}
-
-RHINOPRT_API void ShutdownRhinoPRT() {
-	RhinoPRT::get().ShutdownRhinoPRT();
+std::vector<RawInitialShape> unpackInitialShapes(ON_SimpleArray<const ON_Mesh*>* pMesh) {
+	std::vector<RawInitialShape> rawInitialShapes;
+	rawInitialShapes.reserve(pMesh->Count());
+	for (int i = 0; i < pMesh->Count(); ++i) {
+		rawInitialShapes.emplace_back(**pMesh->At(i));
+	}
+	return rawInitialShapes;
 }
 
-RHINOPRT_API bool Generate(const wchar_t* rpk_path,
-						   // rule attributes
-						   const int shapeCount,
+pcu::AttributeMapBuilderVector unpackAttributeMaps(const int shapeCount,
 						   ON_SimpleArray<int>* pBoolStarts, const int boolCount,
 						   ON_ClassArray<ON_wString>* pBoolKeys, ON_SimpleArray<int>* pBoolVals,
 
@@ -83,39 +76,7 @@ RHINOPRT_API bool Generate(const wchar_t* rpk_path,
                            ON_ClassArray<ON_wString>* pDoubleArrayKeys, ON_ClassArray<ON_wString>* pDoubleArrayVals,
 
 						   ON_SimpleArray<int>* pStringArrayStarts, const int stringArrayCount,
-                           ON_ClassArray<ON_wString>* pStringArrayKeys, ON_ClassArray<ON_wString>* pStringArrayVals,
-
-						   // Initial geometry
-                           ON_SimpleArray<const ON_Mesh*>* pMesh,
-
-						   // Resulting geometry
-						   ON_SimpleArray<int>* pMeshCounts,
-                           ON_SimpleArray<ON_Mesh*>* pMeshArray,
-							
-						   // Materials,
-                           ON_SimpleArray<double>* pColorsArray, ON_SimpleArray<int>* pMatIndices,
-                           ON_ClassArray<ON_wString>* pTexKeys, ON_ClassArray<ON_wString>* pTexPaths,
-	
-						   // Reports
-						   ON_SimpleArray<int>* pReportsCountArray,
-                           ON_ClassArray<ON_wString>* pKeysArray, ON_SimpleArray<double>* pDoubleReports,
-                           ON_SimpleArray<bool>* pBoolReports, ON_ClassArray<ON_wString>* pStringReports,
-	
-						   // Prints
-                           ON_SimpleArray<int>* pPrintCountsArray, ON_ClassArray<ON_wString>* pPrintValuesArray,
-	
-						   // Errors
-                           ON_SimpleArray<int>* pErrorCountsArray, ON_ClassArray<ON_wString>* pErrorValuesArray)
-{
-	if (pMesh == nullptr)
-		return false;
-
-	std::vector<RawInitialShape> rawInitialShapes;
-	rawInitialShapes.reserve(pMesh->Count());
-	for (int i = 0; i < pMesh->Count(); ++i) {
-		rawInitialShapes.emplace_back(**pMesh->At(i));
-	}
-
+                           ON_ClassArray<ON_wString>* pStringArrayKeys, ON_ClassArray<ON_wString>* pStringArrayVals) {
 	// Initialise the attribute map builders for each initial shape.
 	pcu::AttributeMapBuilderVector aBuilders(shapeCount);
 	for (auto& it : aBuilders) {
@@ -175,21 +136,161 @@ RHINOPRT_API bool Generate(const wchar_t* rpk_path,
 		indexStartStringArray += stringAttrArrayCount;
 	}
 
-	const auto& models = RhinoPRT::get().GenerateGeometry(std::wstring(rpk_path), rawInitialShapes, aBuilders);
+	return aBuilders;
+}
+
+/**
+ * Everything the interop layer needs from a generated model. Converting a model as soon as it arrives allows to release
+ * its buffers while the remaining shapes are still generated.
+ */
+struct PackedModel {
+	bool valid = false;
+	GeneratedModel::InstancedMeshBundle meshes; // level 0 is the full detail
+	Materials::MaterialsMap materials;
+	Reporting::ReportMap reports;
+	std::vector<std::wstring> prints;
+	std::vector<std::wstring> errors;
+};
+
+PackedModel packModel(const GeneratedModel& model, size_t initialShapeIndex, size_t levelCount = 0) {
+	PackedModel packedModel;
+	packedModel.valid = true;
+	packedModel.meshes = model.createRhinoInstancedMeshes(initialShapeIndex, levelCount);
+	packedModel.materials = model.getMaterials();
+	packedModel.reports = model.getReports();
+	packedModel.prints = model.getPrints();
+	packedModel.errors = model.getErrors();
+	return packedModel;
+}
 
+/**
+ * Appends the reports of a model sorted by type, with their double, bool and string counts.
+ */
+void packReports(const Reporting::ReportMap& reportMap, ON_SimpleArray<int>* pReportsCountArray,
+                 ON_ClassArray<ON_wString>* pKeysArray, ON_SimpleArray<double>* pDoubleReports,
+                 ON_SimpleArray<bool>* pBoolReports, ON_ClassArray<ON_wString>* pStringReports) {
+	auto reports = Reporting::ToReportsVector(reportMap);
+
+	/*
+	left.float	-> right.all OK
+	left.bool	-> right.float OK
+				-> right.bool OK
+				-> right.string OK
+	left.string -> right.all OK
+	*/
+	// Sort the reports by Type. The order is Double -> Bool -> String
+	std::sort(reports.begin(), reports.end(),
+	          [](Reporting::ReportAttribute left, Reporting::ReportAttribute right) -> bool {
+		          if (left.mType == right.mType)
+			          return left.mReportName.compare(right.mReportName) <
+			                 0; // assuming case sensitivity. assuming two reports can't have the same name.
+		          if (left.mType == prt::AttributeMap::PrimitiveType::PT_FLOAT)
+			          return true;
+		          if (right.mType == prt::AttributeMap::PrimitiveType::PT_FLOAT)
+			          return false;
+		          if (left.mType == prt::AttributeMap::PrimitiveType::PT_STRING)
+			          return false;
+		          if (left.mType == prt::AttributeMap::PrimitiveType::PT_BOOL &&
+		              right.mType == prt::AttributeMap::PrimitiveType::PT_STRING)
+			          return true;
+		          return false;
+	          });
+
+	int doubleReportsCount = 0;
+	int boolReportsCount = 0;
+	int stringReportsCount = 0;
+
+	for (const auto& report : reports) {
+		pKeysArray->Append(ON_wString(report.mReportName.c_str()));
+
+		switch (report.mType) {
+			case prt::AttributeMap::PrimitiveType::PT_FLOAT:
+				pDoubleReports->Append(report.mDoubleReport);
+				doubleReportsCount++;
+				break;
+			case prt::AttributeMap::PrimitiveType::PT_BOOL:
+				pBoolReports->Append(report.mBoolReport);
+				boolReportsCount++;
+				break;
+			case prt::AttributeMap::PrimitiveType::PT_STRING:
+				pStringReports->Append(ON_wString(report.mStringReport.c_str()));
+				stringReportsCount++;
+				break;
+			default:
+				// REMOVE LAST KEY
+				pKeysArray->Remove(pKeysArray->Count() - 1);
+		}
+	}
+
+	pReportsCountArray->Append(doubleReportsCount);
+	pReportsCountArray->Append(boolReportsCount);
+	pReportsCountArray->Append(stringReportsCount);
+}
+
+/**
+ * Moves the packed models (one per initial shape) into the output arrays.
+ *
+ * pMeshCounts receives the number of meshes per shape, i.e. its parts and instances in the order of their materials.
+ * pMeshArray only receives the meshes of the parts. For each mesh of a shape, pInstancePrototypes receives -1 for a
+ * part or the index of the prototype among the shape's prototypes, and pInstanceTransforms receives the 16 values
+ * (row by row) of the transformation of each instance. pPrototypeCounts receives the number of prototypes per shape and
+ * pPrototypeArray their meshes, level by level starting with the full detail.
+ *
+ * @param pLodMeshArray optional, receives the part meshes of the coarser levels of detail of each shape: level by
+ * level, each with as many meshes as the shape has in pMeshArray, in the same order.
+ */
+void packGeneratedModels(std::vector<PackedModel>& models,
+						 // Resulting geometry
+						   ON_SimpleArray<int>* pMeshCounts,
+                           ON_SimpleArray<ON_Mesh*>* pMeshArray, ON_SimpleArray<ON_Mesh*>* pLodMeshArray,
+
+						   // Instances
+						   ON_SimpleArray<int>* pPrototypeCounts, ON_SimpleArray<ON_Mesh*>* pPrototypeArray,
+						   ON_SimpleArray<int>* pInstancePrototypes, ON_SimpleArray<double>* pInstanceTransforms,
+							
+						   // Materials,
+                           ON_SimpleArray<double>* pColorsArray, ON_SimpleArray<int>* pMatIndices,
+                           ON_ClassArray<ON_wString>* pTexKeys, ON_ClassArray<ON_wString>* pTexPaths,
+	
+						   // Reports
+						   ON_SimpleArray<int>* pReportsCountArray,
+                           ON_ClassArray<ON_wString>* pKeysArray, ON_SimpleArray<double>* pDoubleReports,
+                           ON_SimpleArray<bool>* pBoolReports, ON_ClassArray<ON_wString>* pStringReports,
+	
+						   // Prints
+                           ON_SimpleArray<int>* pPrintCountsArray, ON_ClassArray<ON_wString>* pPrintValuesArray,
+	
+						   // Errors
+                           ON_SimpleArray<int>* pErrorCountsArray, ON_ClassArray<ON_wString>* pErrorValuesArray) {
 	for (size_t i = 0; i < models.size(); i++) {
-		if (models[i]) {
-			const GeneratedModel::MeshBundle meshBundle =
-			        models[i]->createRhinoMeshes(i);
-			pMeshCounts->Append(static_cast<int>(meshBundle.size()));
-			for (const auto& meshPart : meshBundle) {
-				pMeshArray->Append(new ON_Mesh(meshPart));
+		if (models[i].valid) {
+			GeneratedModel::InstancedMeshBundle& meshes = models[i].meshes;
+			const int meshCount = static_cast<int>(meshes.meshPrototypes.size());
+			pMeshCounts->Append(meshCount);
+			for (auto& meshPart : meshes.partLevels.front()) {
+				pMeshArray->Append(new ON_Mesh(std::move(meshPart)));
+			}
+			if (pLodMeshArray != nullptr) {
+				for (size_t level = 1; level < meshes.partLevels.size(); level++) {
+					for (auto& meshPart : meshes.partLevels[level])
+						pLodMeshArray->Append(new ON_Mesh(std::move(meshPart)));
+				}
+			}
+
+			// Instances
+			pPrototypeCounts->Append(static_cast<int>(meshes.prototypeLevels.front().size()));
+			for (auto& prototypeLevel : meshes.prototypeLevels) {
+				for (auto& prototype : prototypeLevel)
+					pPrototypeArray->Append(new ON_Mesh(std::move(prototype)));
 			}
+			pInstancePrototypes->Append(meshCount, meshes.meshPrototypes.data());
+			for (const ON_Xform& transform : meshes.instanceTransforms)
+				pInstanceTransforms->Append(16, &transform.m_xform[0][0]);
 
 			// Materials
-			pMatIndices->Append(static_cast<int>(meshBundle.size()));
+			pMatIndices->Append(meshCount);
 
-			const auto& materials = models[i]->getMaterials();
+			const auto& materials = models[i].materials;
 			for (const auto& material : materials) {
 				const auto& matAttributes = material.second;
 				pcu::appendColor(matAttributes.mDiffuseCol, pColorsArray);
@@ -212,66 +313,12 @@ RHINOPRT_API bool Generate(const wchar_t* rpk_path,
 			}
 
 			// Reports
-			auto reports = Reporting::ToReportsVector(models[i]->getReports());
-
-			/*
-			left.float	-> right.all OK
-			left.bool	-> right.float OK
-						-> right.bool OK
-						-> right.string OK
-			left.string -> right.all OK
-			*/
-			// Sort the reports by Type. The order is Double -> Bool -> String
-			std::sort(reports.begin(), reports.end(),
-			          [](Reporting::ReportAttribute left, Reporting::ReportAttribute right) -> bool {
-				          if (left.mType == right.mType)
-					          return left.mReportName.compare(right.mReportName) <
-					                 0; // assuming case sensitivity. assuming two reports can't have the same name.
-				          if (left.mType == prt::AttributeMap::PrimitiveType::PT_FLOAT)
-					          return true;
-				          if (right.mType == prt::AttributeMap::PrimitiveType::PT_FLOAT)
-					          return false;
-				          if (left.mType == prt::AttributeMap::PrimitiveType::PT_STRING)
-					          return false;
-				          if (left.mType == prt::AttributeMap::PrimitiveType::PT_BOOL &&
-				              right.mType == prt::AttributeMap::PrimitiveType::PT_STRING)
-					          return true;
-				          return false;
-			          });
-
-			int doubleReportsCount = 0;
-			int boolReportsCount = 0;
-			int stringReportsCount = 0;
-
-			for (const auto& report : reports) {
-				pKeysArray->Append(ON_wString(report.mReportName.c_str()));
-
-				switch (report.mType) {
-					case prt::AttributeMap::PrimitiveType::PT_FLOAT:
-						pDoubleReports->Append(report.mDoubleReport);
-						doubleReportsCount++;
-						break;
-					case prt::AttributeMap::PrimitiveType::PT_BOOL:
-						pBoolReports->Append(report.mBoolReport);
-						boolReportsCount++;
-						break;
-					case prt::AttributeMap::PrimitiveType::PT_STRING:
-						pStringReports->Append(ON_wString(report.mStringReport.c_str()));
-						stringReportsCount++;
-						break;
-					default:
-						// REMOVE LAST KEY
-						pKeysArray->Remove(pKeysArray->Count() - 1);
-				}
-			}
-
-			pReportsCountArray->Append(doubleReportsCount);
-			pReportsCountArray->Append(boolReportsCount);
-			pReportsCountArray->Append(stringReportsCount);
+			packReports(models[i].reports, pReportsCountArray, pKeysArray, pDoubleReports, pBoolReports,
+			            pStringReports);
 
 			// CGA Prints
 			{
-				const auto& prints = models[i]->getPrints();
+				const auto& prints = models[i].prints;
 				pPrintCountsArray->Append(static_cast<int>(prints.size()));
 				for (const auto& p : prints)
 					pPrintValuesArray->Append(ON_wString(p.c_str()));
@@ -279,7 +326,7 @@ RHINOPRT_API bool Generate(const wchar_t* rpk_path,
 
 			// CGA Errors
 			{
-				const auto& errors = models[i]->getErrors();
+				const auto& errors = models[i].errors;
 				pErrorCountsArray->Append(static_cast<int>(errors.size()));
 				for (const auto& p : errors)
 					pErrorValuesArray->Append(ON_wString(p.c_str()));
@@ -287,12 +334,329 @@ RHINOPRT_API bool Generate(const wchar_t* rpk_path,
 		}
 		else {
 			pMeshCounts->Append(0);
+			pPrototypeCounts->Append(0);
 		}
 	}
+}
+
+} // namespace
+
+extern "C" {
+
+RHINOPRT_API void GetProductVersion(ON_wString* version_str) {
+	*version_str = VER_FILE_VERSION_STR;
+}
+
+RHINOPRT_API bool InitializeRhinoPRT() {
+	return RhinoPRT::get().InitializeRhinoPRT();
+}
+
+RHINOPRT_API void ShutdownRhinoPRT() {
+	RhinoPRT::get().ShutdownRhinoPRT();
+}
+
+RHINOPRT_API bool Generate(const wchar_t* rpk_path,
+						   // rule attributes
+						   const int shapeCount,
+						   ON_SimpleArray<int>* pBoolStarts, const int boolCount,
+						   ON_ClassArray<ON_wString>* pBoolKeys, ON_SimpleArray<int>* pBoolVals,
+
+						   ON_SimpleArray<int>* pIntegerStarts, const int integerCount,
+						   ON_ClassArray<ON_wString>* pIntegerKeys, ON_SimpleArray<int32_t>* pIntegerVals,
+
+						   ON_SimpleArray<int>* pDoubleStarts, const int doubleCount,
+						   ON_ClassArray<ON_wString>* pDoubleKeys, ON_SimpleArray<double>* pDoubleVals,
+
+						   ON_SimpleArray<int>* pStringStarts, const int stringCount, 
+						   ON_ClassArray<ON_wString>* pStringKeys, ON_ClassArray<ON_wString>* pStringVals,
+
+						   ON_SimpleArray<int>* pBoolArrayStarts, const int boolArrayCount,
+                           ON_ClassArray<ON_wString>* pBoolArrayKeys, ON_ClassArray<ON_wString>* pBoolArrayVals,
+
+						   ON_SimpleArray<int>* pIntegerArrayStarts, const int integerArrayCount,
+						   ON_ClassArray<ON_wString>* pIntegerArrayKeys, ON_ClassArray<ON_wString>* pIntegerArrayVals,
+
+						   ON_SimpleArray<int>* pDoubleArrayStarts, const int doubleArrayCount,
+                           ON_ClassArray<ON_wString>* pDoubleArrayKeys, ON_ClassArray<ON_wString>* pDoubleArrayVals,
+
+						   ON_SimpleArray<int>* pStringArrayStarts, const int stringArrayCount,
+                           ON_ClassArray<ON_wString>* pStringArrayKeys, ON_ClassArray<ON_wString>* pStringArrayVals,
+
+						   // Initial geometry
+                           ON_SimpleArray<const ON_Mesh*>* pMesh,
+
+						   // Output options, see GenerateOptions
+						   const uint32_t proxyMode, const double decimationRatio, const double decimationError,
+						   const double* lodRatios, const int lodRatioCount,
+
+						   // Resulting geometry, the levels of detail are laid out as in packGeneratedModels
+						   ON_SimpleArray<int>* pMeshCounts,
+                           ON_SimpleArray<ON_Mesh*>* pMeshArray, ON_SimpleArray<ON_Mesh*>* pLodMeshArray,
+
+						   // Instances, laid out as in packGeneratedModels
+						   ON_SimpleArray<int>* pPrototypeCounts, ON_SimpleArray<ON_Mesh*>* pPrototypeArray,
+						   ON_SimpleArray<int>* pInstancePrototypes, ON_SimpleArray<double>* pInstanceTransforms,
+							
+						   // Materials,
+                           ON_SimpleArray<double>* pColorsArray, ON_SimpleArray<int>* pMatIndices,
+                           ON_ClassArray<ON_wString>* pTexKeys, ON_ClassArray<ON_wString>* pTexPaths,
+	
+						   // Reports
+						   ON_SimpleArray<int>* pReportsCountArray,
+                           ON_ClassArray<ON_wString>* pKeysArray, ON_SimpleArray<double>* pDoubleReports,
+                           ON_SimpleArray<bool>* pBoolReports, ON_ClassArray<ON_wString>* pStringReports,
+	
+						   // Prints
+                           ON_SimpleArray<int>* pPrintCountsArray, ON_ClassArray<ON_wString>* pPrintValuesArray,
+	
+						   // Errors
+                           ON_SimpleArray<int>* pErrorCountsArray, ON_ClassArray<ON_wString>* pErrorValuesArray)
+{
+	if (pMesh == nullptr)
+		return false;
+
+	std::vector<RawInitialShape> rawInitialShapes = unpackInitialShapes(pMesh);
+	pcu::AttributeMapBuilderVector aBuilders =
+	        unpackAttributeMaps(shapeCount, pBoolStarts, boolCount, pBoolKeys, pBoolVals, pIntegerStarts, integerCount,
+	                            pIntegerKeys, pIntegerVals, pDoubleStarts, doubleCount, pDoubleKeys, pDoubleVals,
+	                            pStringStarts, stringCount, pStringKeys, pStringVals, pBoolArrayStarts, boolArrayCount,
+	                            pBoolArrayKeys, pBoolArrayVals, pIntegerArrayStarts, integerArrayCount,
+	                            pIntegerArrayKeys, pIntegerArrayVals, pDoubleArrayStarts, doubleArrayCount,
+	                            pDoubleArrayKeys, pDoubleArrayVals, pStringArrayStarts, stringArrayCount,
+	                            pStringArrayKeys, pStringArrayVals);
+
+	GenerateOptions options;
+	options.proxyMode = proxyMode;
+	options.decimationRatio = decimationRatio;
+	options.decimationError = decimationError;
+	if (lodRatios != nullptr && lodRatioCount > 0)
+		options.lodRatios.assign(lodRatios, lodRatios + lodRatioCount);
+
+	// the models are converted to Rhino meshes on this thread while the workers generate the remaining shapes
+	std::vector<PackedModel> packedModels(rawInitialShapes.size());
+	ResultChannel resultChannel([&packedModels, &options](ResultChannel::Result&& result) {
+		if (result.model && result.shapeIndex < packedModels.size())
+			packedModels[result.shapeIndex] = packModel(*result.model, result.shapeIndex, options.lodRatios.size());
+	});
+
+	// the generator does not keep the streamed models, they are released once they have been packed
+	const std::vector<GeneratedModelPtr> models = RhinoPRT::get().GenerateGeometry(
+	        std::wstring(rpk_path), rawInitialShapes, aBuilders, &resultChannel, options);
+	const bool success = !models.empty();
+	if (!success)
+		packedModels.clear();
+
+	packGeneratedModels(packedModels, pMeshCounts, pMeshArray, pLodMeshArray, pPrototypeCounts, pPrototypeArray,
+	                    pInstancePrototypes, pInstanceTransforms, pColorsArray, pMatIndices, pTexKeys, pTexPaths,
+	                    pReportsCountArray, pKeysArray, pDoubleReports, pBoolReports, pStringReports,
+	                    pPrintCountsArray, pPrintValuesArray, pErrorCountsArray, pErrorValuesArray);
+
+	return success;
+}
+
+/**
+ * Reports-only variant of Generate for design-space exploration: the rules are run without encoding their geometry,
+ * materials, prints or errors. Returns the reports in the layout of Generate, with zero counts for the shapes which
+ * failed to generate.
+ */
+RHINOPRT_API bool GenerateReports(const wchar_t* rpk_path,
+						   // rule attributes
+						   const int shapeCount,
+						   ON_SimpleArray<int>* pBoolStarts, const int boolCount,
+						   ON_ClassArray<ON_wString>* pBoolKeys, ON_SimpleArray<int>* pBoolVals,
+
+						   ON_SimpleArray<int>* pIntegerStarts, const int integerCount,
+						   ON_ClassArray<ON_wString>* pIntegerKeys, ON_SimpleArray<int32_t>* pIntegerVals,
+
+						   ON_SimpleArray<int>* pDoubleStarts, const int doubleCount,
+						   ON_ClassArray<ON_wString>* pDoubleKeys, ON_SimpleArray<double>* pDoubleVals,
+
+						   ON_SimpleArray<int>* pStringStarts, const int stringCount, 
+						   ON_ClassArray<ON_wString>* pStringKeys, ON_ClassArray<ON_wString>* pStringVals,
+
+						   ON_SimpleArray<int>* pBoolArrayStarts, const int boolArrayCount,
+                           ON_ClassArray<ON_wString>* pBoolArrayKeys, ON_ClassArray<ON_wString>* pBoolArrayVals,
+
+						   ON_SimpleArray<int>* pIntegerArrayStarts, const int integerArrayCount,
+						   ON_ClassArray<ON_wString>* pIntegerArrayKeys, ON_ClassArray<ON_wString>* pIntegerArrayVals,
+
+						   ON_SimpleArray<int>* pDoubleArrayStarts, const int doubleArrayCount,
+                           ON_ClassArray<ON_wString>* pDoubleArrayKeys, ON_ClassArray<ON_wString>* pDoubleArrayVals,
+
+						   ON_SimpleArray<int>* pStringArrayStarts, const int stringArrayCount,
+                           ON_ClassArray<ON_wString>* pStringArrayKeys, ON_ClassArray<ON_wString>* pStringArrayVals,
+
+						   // Initial geometry
+                           ON_SimpleArray<const ON_Mesh*>* pMesh,
+
+						   // Reports
+						   ON_SimpleArray<int>* pReportsCountArray,
+                           ON_ClassArray<ON_wString>* pKeysArray, ON_SimpleArray<double>* pDoubleReports,
+                           ON_SimpleArray<bool>* pBoolReports, ON_ClassArray<ON_wString>* pStringReports) {
+	if (rpk_path == nullptr || pMesh == nullptr)
+		return false;
+
+	std::vector<RawInitialShape> rawInitialShapes = unpackInitialShapes(pMesh);
+	pcu::AttributeMapBuilderVector aBuilders =
+	        unpackAttributeMaps(shapeCount, pBoolStarts, boolCount, pBoolKeys, pBoolVals, pIntegerStarts, integerCount,
+	                            pIntegerKeys, pIntegerVals, pDoubleStarts, doubleCount, pDoubleKeys, pDoubleVals,
+	                            pStringStarts, stringCount, pStringKeys, pStringVals, pBoolArrayStarts, boolArrayCount,
+	                            pBoolArrayKeys, pBoolArrayVals, pIntegerArrayStarts, integerArrayCount,
+	                            pIntegerArrayKeys, pIntegerArrayVals, pDoubleArrayStarts, doubleArrayCount,
+	                            pDoubleArrayKeys, pDoubleArrayVals, pStringArrayStarts, stringArrayCount,
+	                            pStringArrayKeys, pStringArrayVals);
+
+	const std::vector<GeneratedModelPtr> models =
+	        RhinoPRT::get().GenerateReports(std::wstring(rpk_path), rawInitialShapes, aBuilders);
+	if (models.empty())
+		return false;
+
+	// shapes which failed to generate get empty reports to keep the report counts aligned with the input shapes
+	const Reporting::ReportMap noReports;
+	for (const GeneratedModelPtr& model : models) {
+		packReports(model ? model->getReports() : noReports, pReportsCountArray, pKeysArray, pDoubleReports,
+		            pBoolReports, pStringReports);
+	}
+	return true;
+}
+
+/**
+ * Starts an asynchronous Generate with the same inputs and output options, see RhinoPRTAPI::submitGenerate. The
+ * generations run one at a time: a synchronous Generate waits for the running job, discard stale jobs to cancel them.
+ * Returns the job id or -1 for invalid inputs.
+ */
+RHINOPRT_API int SubmitGenerate(const wchar_t* rpk_path,
+						   // rule attributes
+						   const int shapeCount,
+						   ON_SimpleArray<int>* pBoolStarts, const int boolCount,
+						   ON_ClassArray<ON_wString>* pBoolKeys, ON_SimpleArray<int>* pBoolVals,
+
+						   ON_SimpleArray<int>* pIntegerStarts, const int integerCount,
+						   ON_ClassArray<ON_wString>* pIntegerKeys, ON_SimpleArray<int32_t>* pIntegerVals,
+
+						   ON_SimpleArray<int>* pDoubleStarts, const int doubleCount,
+						   ON_ClassArray<ON_wString>* pDoubleKeys, ON_SimpleArray<double>* pDoubleVals,
+
+						   ON_SimpleArray<int>* pStringStarts, const int stringCount, 
+						   ON_ClassArray<ON_wString>* pStringKeys, ON_ClassArray<ON_wString>* pStringVals,
+
+						   ON_SimpleArray<int>* pBoolArrayStarts, const int boolArrayCount,
+                           ON_ClassArray<ON_wString>* pBoolArrayKeys, ON_ClassArray<ON_wString>* pBoolArrayVals,
+
+						   ON_SimpleArray<int>* pIntegerArrayStarts, const int integerArrayCount,
+						   ON_ClassArray<ON_wString>* pIntegerArrayKeys, ON_ClassArray<ON_wString>* pIntegerArrayVals,
+
+						   ON_SimpleArray<int>* pDoubleArrayStarts, const int doubleArrayCount,
+                           ON_ClassArray<ON_wString>* pDoubleArrayKeys, ON_ClassArray<ON_wString>* pDoubleArrayVals,
+
+						   ON_SimpleArray<int>* pStringArrayStarts, const int stringArrayCount,
+                           ON_ClassArray<ON_wString>* pStringArrayKeys, ON_ClassArray<ON_wString>* pStringArrayVals,
+
+						   // Initial geometry
+                           ON_SimpleArray<const ON_Mesh*>* pMesh,
+
+						   // Output options, see GenerateOptions
+						   const uint32_t proxyMode, const double decimationRatio, const double decimationError,
+						   const double* lodRatios, const int lodRatioCount) {
+	if (rpk_path == nullptr || pMesh == nullptr)
+		return -1;
+
+	std::vector<RawInitialShape> rawInitialShapes = unpackInitialShapes(pMesh);
+	pcu::AttributeMapBuilderVector aBuilders =
+	        unpackAttributeMaps(shapeCount, pBoolStarts, boolCount, pBoolKeys, pBoolVals, pIntegerStarts, integerCount,
+	                            pIntegerKeys, pIntegerVals, pDoubleStarts, doubleCount, pDoubleKeys, pDoubleVals,
+	                            pStringStarts, stringCount, pStringKeys, pStringVals, pBoolArrayStarts, boolArrayCount,
+	                            pBoolArrayKeys, pBoolArrayVals, pIntegerArrayStarts, integerArrayCount,
+	                            pIntegerArrayKeys, pIntegerArrayVals, pDoubleArrayStarts, doubleArrayCount,
+	                            pDoubleArrayKeys, pDoubleArrayVals, pStringArrayStarts, stringArrayCount,
+	                            pStringArrayKeys, pStringArrayVals);
+
+	GenerateOptions options;
+	options.proxyMode = proxyMode;
+	options.decimationRatio = decimationRatio;
+	options.decimationError = decimationError;
+	if (lodRatios != nullptr && lodRatioCount > 0)
+		options.lodRatios.assign(lodRatios, lodRatios + lodRatioCount);
+
+	return RhinoPRT::get().submitGenerate(std::wstring(rpk_path), std::move(rawInitialShapes), std::move(aBuilders),
+	                                      options);
+}
+
+/**
+ * Returns -1 for unknown jobs, 0 while the job is running and 1 once its results can be fetched.
+ */
+RHINOPRT_API int PollGenerate(int jobId, int* pShapesDone, int* pShapesTotal) {
+	size_t shapesDone = 0;
+	size_t shapesTotal = 0;
+	const RhinoPRT::GenerateJobStatus status = RhinoPRT::get().pollGenerate(jobId, shapesDone, shapesTotal);
+	if (pShapesDone != nullptr)
+		*pShapesDone = static_cast<int>(shapesDone);
+	if (pShapesTotal != nullptr)
+		*pShapesTotal = static_cast<int>(shapesTotal);
+	return static_cast<int>(status);
+}
+
+RHINOPRT_API bool FetchGenerateResults(int jobId,
+						   // Resulting geometry, the levels of detail are laid out as in packGeneratedModels
+						   ON_SimpleArray<int>* pMeshCounts,
+                           ON_SimpleArray<ON_Mesh*>* pMeshArray, ON_SimpleArray<ON_Mesh*>* pLodMeshArray,
+
+						   // Instances, laid out as in packGeneratedModels
+						   ON_SimpleArray<int>* pPrototypeCounts, ON_SimpleArray<ON_Mesh*>* pPrototypeArray,
+						   ON_SimpleArray<int>* pInstancePrototypes, ON_SimpleArray<double>* pInstanceTransforms,
+							
+						   // Materials,
+                           ON_SimpleArray<double>* pColorsArray, ON_SimpleArray<int>* pMatIndices,
+                           ON_ClassArray<ON_wString>* pTexKeys, ON_ClassArray<ON_wString>* pTexPaths,
+	
+						   // Reports
+						   ON_SimpleArray<int>* pReportsCountArray,
+                           ON_ClassArray<ON_wString>* pKeysArray, ON_SimpleArray<double>* pDoubleReports,
+                           ON_SimpleArray<bool>* pBoolReports, ON_ClassArray<ON_wString>* pStringReports,
+	
+						   // Prints
+                           ON_SimpleArray<int>* pPrintCountsArray, ON_ClassArray<ON_wString>* pPrintValuesArray,
+	
+						   // Errors
+                           ON_SimpleArray<int>* pErrorCountsArray, ON_ClassArray<ON_wString>* pErrorValuesArray) {
+	std::vector<GeneratedModelPtr> models;
+	size_t levelCount = 0;
+	if (!RhinoPRT::get().fetchGenerateResults(jobId, models, levelCount))
+		return false;
+
+	std::vector<PackedModel> packedModels(models.size());
+	for (size_t i = 0; i < models.size(); i++) {
+		if (models[i])
+			packedModels[i] = packModel(*models[i], i, levelCount);
+	}
+
+	packGeneratedModels(packedModels, pMeshCounts, pMeshArray, pLodMeshArray, pPrototypeCounts, pPrototypeArray,
+	                    pInstancePrototypes, pInstanceTransforms, pColorsArray, pMatIndices, pTexKeys, pTexPaths,
+	                    pReportsCountArray, pKeysArray, pDoubleReports, pBoolReports, pStringReports,
+	                    pPrintCountsArray, pPrintValuesArray, pErrorCountsArray, pErrorValuesArray);
 
 	return !models.empty();
 }
 
+RHINOPRT_API void DiscardGenerateJob(int jobId) {
+	RhinoPRT::get().discardGenerateJob(jobId);
+}
+
+/**
+ * Starts loading the rule package in the background. If initial meshes are given, their default attribute values are
+ * evaluated as well. Returns immediately, later calls for this rule package wait for the prefetch instead of repeating
+ * it.
+ */
+RHINOPRT_API void PrefetchRulePackage(const wchar_t* rpk_path, ON_SimpleArray<const ON_Mesh*>* pMesh) {
+	if (rpk_path == nullptr)
+		return;
+
+	std::vector<RawInitialShape> rawInitialShapes;
+	if (pMesh != nullptr)
+		rawInitialShapes = unpackInitialShapes(pMesh);
+	RhinoPRT::get().prefetchRulePackage(std::wstring(rpk_path), std::move(rawInitialShapes));
+}
+
 RHINOPRT_API int GetRuleAttributes(const wchar_t* rpk_path, ON_ClassArray<ON_wString>* pAttributesBuffer, 
 	ON_SimpleArray<int>* pAttributesTypes, ON_SimpleArray<int>* pBaseAnnotations, ON_SimpleArray<double>* pDoubleAnnotations,
 	ON_ClassArray<ON_wString>* pStringAnnotations) {
@@ -494,4 +858,78 @@ RHINOPRT_API bool GetDefaultAttributes(	const wchar_t* rpk_path, ON_SimpleArray<
 RHINOPRT_API void SetMaterialGenerationOption(bool doGenerate) {
 	RhinoPRT::get().setMaterialGeneration(doGenerate);
 }
+
+RHINOPRT_API void SetGenerateProgressCallback(RhinoPRT::GenerateProgressCallback progressCallback) {
+	RhinoPRT::get().setGenerateProgressCallback(progressCallback);
+}
+
+/**
+ * Cancels the running Generate and all jobs started with SubmitGenerate.
+ */
+RHINOPRT_API void CancelGenerate() {
+	RhinoPRT::get().cancelGenerate();
+}
+
+/**
+ * maxWorkerThreads <= 0 uses all available cores. reservedCores are kept free for Rhino and other processes. With
+ * pinWorkers, each worker thread is bound to one of the cores after the reserved ones.
+ */
+RHINOPRT_API void SetGenerationConcurrency(int maxWorkerThreads, int reservedCores, bool pinWorkers) {
+	GenerationConcurrency concurrency;
+	concurrency.maxWorkerThreads = static_cast<size_t>(std::max(maxWorkerThreads, 0));
+	concurrency.reservedCores = static_cast<size_t>(std::max(reservedCores, 0));
+	concurrency.pinWorkers = pinWorkers;
+	RhinoPRT::get().setGenerationConcurrency(concurrency);
+}
+
+/**
+ * Large batches are generated in chunks whose models fit into the given number of megabytes, 0 disables chunking.
+ */
+RHINOPRT_API void SetGenerationMemoryBudget(int megabytes) {
+	RhinoPRT::get().setGenerationMemoryBudget(static_cast<size_t>(std::max(megabytes, 0)) * 1024 * 1024);
+}
+
+/**
+ * Marks the rules of the rule package as independent of the absolute shape position. Shapes which only differ by a
+ * translation are then generated once and the model is moved to the other shapes. Off by default, the results are wrong
+ * for rules which read absolute coordinates.
+ */
+RHINOPRT_API void SetRulePackagePositionIndependent(const wchar_t* rpk_path, bool positionIndependent) {
+	if (rpk_path == nullptr)
+		return;
+	RhinoPRT::get().setPositionIndependent(std::wstring(rpk_path), positionIndependent);
+}
+
+/**
+ * Encodes repeated geometry as prototypes and instance transformations. The generate functions then return each
+ * prototype mesh once per shape, with the transformations of its instances, see packGeneratedModels.
+ */
+RHINOPRT_API void SetInstancing(bool instancing) {
+	RhinoPRT::get().setInstancing(instancing);
+}
+
+/**
+ * Stores the generated vertices as floats relative to the centroid of each shape. Halves the memory of the models, the
+ * meshes returned to Rhino are restored in double precision.
+ */
+RHINOPRT_API void SetSinglePrecision(bool singlePrecision) {
+	RhinoPRT::get().setSinglePrecision(singlePrecision);
+}
+
+/**
+ * Welds face corners with equal position, normal and texture coordinates into shared vertices, within the given
+ * tolerances. The returned meshes are then indexed and have far fewer vertices.
+ */
+RHINOPRT_API void SetVertexWelding(bool enabled, double positionTolerance, double normalTolerance, double uvTolerance) {
+	RhinoPRT::get().setVertexWelding(enabled, positionTolerance, normalTolerance, uvTolerance);
+}
+
+/**
+ * Selects the outputs of the generate functions as a mask of OutputChannel bits (geometry = 1, normals = 2, uvs = 4,
+ * materials = 8, reports = 16, prints = 32, errors = 64). The work of unselected outputs is skipped during generation,
+ * their results stay empty.
+ */
+RHINOPRT_API void SetOutputChannels(uint32_t channels) {
+	RhinoPRT::get().setOutputChannels(channels);
+}
 }
\ No newline at end of file
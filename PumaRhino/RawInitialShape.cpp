@@ -19,6 +19,7 @@
 
 #include "RawInitialShape.h"
 #include "Logger.h"
+#include "utils.h"
 
 #ifdef _MSC_VER
 #	pragma warning(push)
@@ -31,9 +32,16 @@
 #endif
 
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <vector>
 
+namespace {
+
+constexpr double LOCAL_HASH_RESOLUTION = 1e-6;
+
+} // namespace
+
 RawInitialShape::RawInitialShape(const ON_Mesh& mesh) {
 	ON_wString shapeIdxStr;
 	if (!mesh.GetUserString(INIT_SHAPE_ID_KEY.c_str(), shapeIdxStr)) {
@@ -126,6 +134,25 @@ RawInitialShape::RawInitialShape(const ON_Mesh& mesh) {
 			}
 		}
 	}
+
+	mGeometryHash = pcu::Hasher()
+	                        .add(mVertices.data(), mVertices.size())
+	                        .add(mIndices.data(), mIndices.size())
+	                        .add(mFaceCounts.data(), mFaceCounts.size())
+	                        .get();
+
+	if (!mVertices.empty())
+		mLocalOrigin = {mVertices[0], mVertices[1], mVertices[2]};
+	for (size_t i = 0; i < mVertices.size(); i++)
+		mLocalOrigin[i % 3] = std::min(mLocalOrigin[i % 3], mVertices[i]);
+
+	pcu::Hasher localHasher;
+	localHasher.add(mVertices.size());
+	for (size_t i = 0; i < mVertices.size(); i++)
+		localHasher.add(std::llround((mVertices[i] - mLocalOrigin[i % 3]) / LOCAL_HASH_RESOLUTION));
+	mLocalGeometryHash = localHasher.add(mIndices.data(), mIndices.size())
+	                             .add(mFaceCounts.data(), mFaceCounts.size())
+	                             .get();
 }
 
 int RawInitialShape::getID() const {
@@ -155,3 +182,22 @@ const uint32_t* RawInitialShape::getFaceCounts() const {
 size_t RawInitialShape::getFaceCountsCount() const {
 	return mFaceCounts.size();
 }
+
+uint64_t RawInitialShape::getGeometryHash() const {
+	return mGeometryHash;
+}
+
+const std::array<double, 3>& RawInitialShape::getLocalOrigin() const {
+	return mLocalOrigin;
+}
+
+std::vector<double> RawInitialShape::getLocalVertices() const {
+	std::vector<double> localVertices(mVertices);
+	const std::array<double, 3> toLocal = {-mLocalOrigin[0], -mLocalOrigin[1], -mLocalOrigin[2]};
+	pcu::translateVertices(localVertices.data(), localVertices.size() / 3, toLocal);
+	return localVertices;
+}
+
+uint64_t RawInitialShape::getLocalGeometryHash() const {
+	return mLocalGeometryHash;
+}
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -40,8 +42,32 @@ public:
 	const uint32_t* getFaceCounts() const;
 	size_t getFaceCountsCount() const;
 
+	/**
+	 * Content hash of the vertex, index and face count buffers.
+	 */
+	uint64_t getGeometryHash() const;
+
+	/**
+	 * Minimum corner of the bounding box, the origin of the local (position independent) geometry.
+	 */
+	const std::array<double, 3>& getLocalOrigin() const;
+
+	/**
+	 * Vertices relative to the local origin.
+	 */
+	std::vector<double> getLocalVertices() const;
+
+	/**
+	 * Content hash of the local geometry, equal for shapes which only differ by a translation. The local coordinates are
+	 * quantized to 1e-6 units to absorb rounding errors of the translation.
+	 */
+	uint64_t getLocalGeometryHash() const;
+
 private:
 	int mID;
+	uint64_t mGeometryHash = 0;
+	uint64_t mLocalGeometryHash = 0;
+	std::array<double, 3> mLocalOrigin = {0.0, 0.0, 0.0};
 	std::vector<double> mVertices;
 	std::vector<uint32_t> mIndices;
 	std::vector<uint32_t> mFaceCounts;
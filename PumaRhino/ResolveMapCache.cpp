@@ -114,4 +114,13 @@ ResolveMapCache::LookupResult ResolveMapCache::get(const std::filesystem::path&
 	return {it->second.mResolveMap, cs};
 }
 
+std::chrono::system_clock::time_point ResolveMapCache::getTimeStamp(const std::filesystem::path& rpk) const {
+	const auto it = mCache.find(createCacheKey(rpk));
+	return (it != mCache.end()) ? it->second.mTimeStamp : INVALID_TIMESTAMP;
+}
+
+std::chrono::system_clock::time_point ResolveMapCache::getFileTimeStamp(const std::filesystem::path& rpk) {
+	return getFileModificationTime(rpk);
+}
+
 } // namespace ResolveMap
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include "Logger.h"
 #include "utils.h"
 
+#include <chrono>
 #include <filesystem>
 #include <map>
 
@@ -42,6 +43,17 @@ public:
 	using LookupResult = std::pair<pcu::ResolveMapSPtr, CacheStatus>;
 	LookupResult get(const std::filesystem::path& rpk);
 
+	/**
+	 * Modification time of the rule package when it was last loaded, or a default time point if it is not cached.
+	 */
+	std::chrono::system_clock::time_point getTimeStamp(const std::filesystem::path& rpk) const;
+
+	/**
+	 * Current modification time of the rule package file, which get compares against the cached one to reload a
+	 * modified rule package. A default time point if the file does not exist.
+	 */
+	static std::chrono::system_clock::time_point getFileTimeStamp(const std::filesystem::path& rpk);
+
 private:
 	struct ResolveMapCacheEntry {
 		pcu::ResolveMapSPtr mResolveMap;
@@ -0,0 +1,103 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef _MSC_VER
+#	pragma warning(push)
+#	pragma warning(disable : 26451)
+#	pragma warning(disable : 26495)
+#endif
+#include "stdafx.h"
+#ifdef _MSC_VER
+#	pragma warning(pop)
+#endif
+
+#include "ResultChannel.h"
+
+#include <algorithm>
+
+ResultChannel::ResultChannel(Consumer consumer, size_t capacity)
+    : mConsumer(std::move(consumer)), mCapacity(std::max<size_t>(capacity, 1)),
+      mConsumerThread(std::this_thread::get_id()) {}
+
+void ResultChannel::push(Result&& result) {
+	if (std::this_thread::get_id() == mConsumerThread) {
+		mConsumer(std::move(result));
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mNotFull.wait(lock, [this]() { return mDiscarding || mResults.size() < mCapacity; });
+	if (mDiscarding)
+		return;
+
+	mResults.emplace_back(std::move(result));
+	lock.unlock();
+	mNotEmpty.notify_one();
+}
+
+void ResultChannel::addProducers(size_t count) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mProducerCount += count;
+}
+
+void ResultChannel::producerDone() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mProducerCount > 0)
+		mProducerCount--;
+	const bool lastProducer = (mProducerCount == 0);
+	lock.unlock();
+	if (lastProducer)
+		mNotEmpty.notify_all();
+}
+
+void ResultChannel::drain() {
+	std::exception_ptr consumerException;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true) {
+		mNotEmpty.wait(lock, [this]() { return !mResults.empty() || mProducerCount == 0; });
+		if (mResults.empty())
+			break; // all producers are done
+
+		Result result = std::move(mResults.front());
+		mResults.pop_front();
+		lock.unlock();
+		mNotFull.notify_one();
+
+		try {
+			mConsumer(std::move(result));
+		}
+		catch (...) {
+			// the producers must not block on a queue which is no longer drained
+			consumerException = std::current_exception();
+			lock.lock();
+			mDiscarding = true;
+			mResults.clear();
+			lock.unlock();
+			mNotFull.notify_all();
+		}
+
+		lock.lock();
+	}
+	mDiscarding = false;
+	lock.unlock();
+
+	if (consumerException)
+		std::rethrow_exception(consumerException);
+}
@@ -0,0 +1,102 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "GeneratedModel.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Bounded queue which hands finished models from the generation workers to the consumer (i.e. the Rhino interop
+ * layer), so their conversion overlaps with the generation of the remaining shapes. The consumer runs on the thread
+ * which created the channel, while that thread waits for the generation workers (see drain). Workers block while the
+ * queue is full.
+ */
+class ResultChannel final {
+public:
+	struct Result {
+		size_t shapeIndex = 0;
+		GeneratedModelPtr model;
+	};
+
+	/**
+	 * Called on the thread which created the channel, one result at a time and never twice for the same shape index.
+	 */
+	using Consumer = std::function<void(Result&& result)>;
+
+	static constexpr size_t DEFAULT_CAPACITY = 256;
+
+	explicit ResultChannel(Consumer consumer, size_t capacity = DEFAULT_CAPACITY);
+	ResultChannel(const ResultChannel&) = delete;
+	ResultChannel& operator=(const ResultChannel&) = delete;
+
+	/**
+	 * On the thread which created the channel, runs the consumer right away. On other threads, queues the result and
+	 * blocks while the queue is full. The pushing threads must be announced with addProducers.
+	 */
+	void push(Result&& result);
+
+	/**
+	 * Announces threads which are about to push results, each of them has to call producerDone once it is finished.
+	 */
+	void addProducers(size_t count);
+	void producerDone();
+
+	/**
+	 * Runs the consumer for the queued results on the calling thread until all announced producers are done and the
+	 * queue is empty. If the consumer throws, the remaining results are dropped and the exception is rethrown once the
+	 * producers are done.
+	 */
+	void drain();
+
+	/**
+	 * Calls producerDone when leaving the scope of a producer, also on cancellation or exceptions.
+	 */
+	class ProducerScope final {
+	public:
+		explicit ProducerScope(ResultChannel* channel) : mChannel(channel) {}
+		ProducerScope(const ProducerScope&) = delete;
+		ProducerScope& operator=(const ProducerScope&) = delete;
+		~ProducerScope() {
+			if (mChannel != nullptr)
+				mChannel->producerDone();
+		}
+
+	private:
+		ResultChannel* const mChannel;
+	};
+
+private:
+	const Consumer mConsumer;
+	const size_t mCapacity;
+	const std::thread::id mConsumerThread;
+
+	std::mutex mMutex;
+	std::condition_variable mNotFull;
+	std::condition_variable mNotEmpty; // also signaled when the last producer is done
+	std::deque<Result> mResults;
+	size_t mProducerCount = 0;
+	bool mDiscarding = false; // the consumer failed, results are dropped until the producers are done
+};
@@ -31,7 +31,9 @@
 #include "AssetCache.h"
 #include "PRTContext.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <numeric>
 #include <wchar.h>
 
 namespace {
@@ -46,82 +48,120 @@ RhinoCallbacks::RhinoCallbacks(const size_t initialShapeCount) {
 	mModels.resize(initialShapeCount);
 }
 
-bool RhinoCallbacks::addGeometry(const size_t initialShapeIndex, const double* vertexCoords,
-                                 const size_t vertexCoordsCount, const double* normals, const size_t normalsCount,
-                                 const uint32_t* faceIndices, const size_t faceIndicesCount, const uint32_t* faceCounts,
-                                 const size_t faceCountsCount) {
-	if (vertexCoords == nullptr || normals == nullptr || faceIndices == nullptr || faceCounts == nullptr)
-		return false;
-
-	GeneratedModel& currentModel = *mModels[initialShapeIndex];
-	ModelPart& modelPart = currentModel.addModelPart();
-
-	modelPart.mVertices.assign(vertexCoords, vertexCoords + vertexCoordsCount);
-	modelPart.mNormals.assign(normals, normals + normalsCount);
-	modelPart.mIndices.assign(faceIndices, faceIndices + faceIndicesCount);
-	modelPart.mFaces.assign(faceCounts, faceCounts + faceCountsCount);
-
-	return true;
-}
-
-void RhinoCallbacks::addUVCoordinates(const size_t initialShapeIndex, double const* const* uvs, size_t const* uvsSizes,
-                                      uint32_t const* const* uvCounts, size_t const* uvCountsSizes,
-                                      uint32_t const* const* uvIndices, size_t const* uvIndicesSizes, uint32_t uvSets) {
-	GeneratedModel& currentModel = *mModels[initialShapeIndex];
-	ModelPart& modelPart = currentModel.getCurrentModelPart();
-
-	// Add texture coordinates
-	for (size_t uvSet = 0; uvSet < uvSets; ++uvSet) {
-		size_t const psUVSSize = uvsSizes[uvSet];
-		size_t const psUVCountsSize = uvCountsSizes[uvSet];
-		size_t const psUVIndicesSize = uvIndicesSizes[uvSet];
-
-		if (psUVSSize > 0 && psUVIndicesSize > 0 && psUVCountsSize > 0) {
-			if (uvSet == 0) {
-				if constexpr (DBG)
-					LOG_DBG << " -- uvset " << uvSet << ": psUVCountsSize = " << psUVCountsSize
-					        << ", psUVIndicesSize = " << psUVIndicesSize;
-
-				double const* const psUVS = uvs[uvSet];
-				uint32_t const* const psUVCounts = uvCounts[uvSet];
-				uint32_t const* const psUVIndices = uvIndices[uvSet];
-
-				modelPart.mUVIndices.reserve(psUVIndicesSize);
-				modelPart.mUVs.Reserve(psUVIndicesSize);
-				modelPart.mUVCounts.reserve(psUVCountsSize);
-
-				modelPart.mUVCounts.insert(modelPart.mUVCounts.end(), psUVCounts + 0, psUVCounts + psUVCountsSize);
-
-				for (size_t uvi = 0; uvi < psUVIndicesSize; ++uvi) {
-					const uint32_t uvIdx = psUVIndices[uvi];
-					const auto du = psUVS[uvIdx * 2 + 0];
-					const auto dv = psUVS[uvIdx * 2 + 1];
-					modelPart.mUVs.Append(ON_2fPoint(static_cast<float>(du), static_cast<float>(dv)));
-					modelPart.mUVIndices.push_back(static_cast<uint32_t>(uvi));
-				}
-			}
-			else {
-				LOG_INF << "IGNORED UV SET " << uvSet << ": Rhino does not support multiple uv sets.";
-			}
-		}
+RhinoCallbacks::MeshBuffers RhinoCallbacks::resizeModelPart(ModelPart& modelPart, const MeshBufferSizes& sizes) {
+	MeshBuffers buffers;
+	if (sizes.singlePrecision) {
+		modelPart.mLocalVertices.resize(sizes.vertexCoordsCount);
+		modelPart.mLocalNormals.resize(sizes.normalsCount);
+		buffers.localVertexCoords = modelPart.mLocalVertices.data();
+		buffers.localNormals = modelPart.mLocalNormals.data();
+	}
+	else {
+		modelPart.mVertices.resize(sizes.vertexCoordsCount);
+		modelPart.mNormals.resize(sizes.normalsCount);
+		buffers.vertexCoords = modelPart.mVertices.data();
+		buffers.normals = modelPart.mNormals.data();
 	}
+
+	modelPart.mIndices.resize(sizes.faceIndicesCount);
+	modelPart.mFaces.resize(sizes.faceCountsCount);
+
+	// the encoder writes the texture coordinates per face vertex, or per vertex in indexed meshes; the uv indices are
+	// the identity
+	modelPart.mIndexed = sizes.indexed;
+	const int uvCount = static_cast<int>(sizes.uvsCount / 2);
+	modelPart.mUVs.SetCapacity(uvCount);
+	modelPart.mUVs.SetCount(uvCount);
+	modelPart.mUVIndices.resize(static_cast<size_t>(uvCount));
+	std::iota(modelPart.mUVIndices.begin(), modelPart.mUVIndices.end(), 0u);
+	modelPart.mUVCounts.resize(sizes.uvCountsCount);
+	modelPart.mPolygonTriangles.resize(sizes.polygonTrianglesCount);
+
+	buffers.faceIndices = modelPart.mIndices.data();
+	buffers.faceCounts = modelPart.mFaces.data();
+	buffers.uvs = reinterpret_cast<float*>(modelPart.mUVs.Array());
+	buffers.uvCounts = modelPart.mUVCounts.data();
+	buffers.polygonTriangles = modelPart.mPolygonTriangles.data();
+	return buffers;
+}
+
+RhinoCallbacks::MeshBuffers RhinoCallbacks::addLevel(ModelPart& modelPart, const size_t level,
+                                                     const MeshBufferSizes& sizes) {
+	// the levels are added in order, a skipped level would repeat the previous one
+	if (level == 0 || level > modelPart.mLevels.size() + 1) {
+		LOG_WRN << "Ignoring level of detail " << level << " of a part with " << modelPart.mLevels.size() << " levels";
+		return {};
+	}
+	modelPart.mLevels.resize(level);
+	return resizeModelPart(modelPart.mLevels.back(), sizes);
+}
+
+void RhinoCallbacks::setLocalOrigin(const size_t initialShapeIndex, const double* origin) {
+	if (origin == nullptr)
+		return;
+	getOrCreateModel(initialShapeIndex).setLocalOrigin({origin[0], origin[1], origin[2]});
 }
 
-void RhinoCallbacks::add(const size_t initialShapeIndex, const size_t instanceIndex, const double* vertexCoords,
-                         const size_t vertexCoordsCount, const double* normals, const size_t normalsCount,
-                         const uint32_t* faceIndices, const size_t faceIndicesCount, const uint32_t* faceCounts,
-                         const size_t faceCountsCount, double const* const* uvs, size_t const* uvsSizes,
-                         uint32_t const* const* uvCounts, size_t const* uvCountsSizes, uint32_t const* const* uvIndices,
-                         size_t const* uvIndicesSizes, uint32_t uvSets, const uint32_t* /*faceRanges*/,
-                         size_t /*faceRangesSize*/, prt::AttributeMap const* const* materials, const size_t matCount) {
+RhinoCallbacks::MeshBuffers RhinoCallbacks::acquireMeshBuffers(const size_t initialShapeIndex,
+                                                               const MeshBufferSizes& sizes) {
+	GeneratedModel& currentModel = getOrCreateModel(initialShapeIndex);
+	return resizeModelPart(currentModel.addModelPart(), sizes);
+}
+
+void RhinoCallbacks::addMaterials(const size_t initialShapeIndex, const size_t instanceIndex,
+                                  const uint32_t* /*faceRanges*/, size_t /*faceRangesSize*/,
+                                  prt::AttributeMap const* const* materials, size_t matCount) {
+	// follows the mesh buffers of the instance
+	GeneratedModel& currentModel = getOrCreateModel(initialShapeIndex);
+	if (currentModel.getMeshPartCount() > 0)
+		currentModel.getCurrentModelPart().mInstanceIndex = instanceIndex;
+	addMaterialAttributes(currentModel, instanceIndex, materials, matCount);
+}
 
+RhinoCallbacks::MeshBuffers RhinoCallbacks::acquirePrototypeBuffers(const size_t initialShapeIndex,
+                                                                    const size_t prototypeIndex,
+                                                                    const MeshBufferSizes& sizes) {
 	GeneratedModel& currentModel = getOrCreateModel(initialShapeIndex);
+	return resizeModelPart(currentModel.addPrototype(prototypeIndex), sizes);
+}
+
+RhinoCallbacks::MeshBuffers RhinoCallbacks::acquireMeshLevelBuffers(const size_t initialShapeIndex, const size_t level,
+                                                                    const MeshBufferSizes& sizes) {
+	GeneratedModel& currentModel = getOrCreateModel(initialShapeIndex);
+	if (currentModel.getMeshPartCount() == 0)
+		return {};
+	return addLevel(currentModel.getCurrentModelPart(), level, sizes);
+}
 
-	if (!addGeometry(initialShapeIndex, vertexCoords, vertexCoordsCount, normals, normalsCount, faceIndices,
-	                 faceIndicesCount, faceCounts, faceCountsCount))
+RhinoCallbacks::MeshBuffers RhinoCallbacks::acquirePrototypeLevelBuffers(const size_t initialShapeIndex,
+                                                                         const size_t prototypeIndex,
+                                                                         const size_t level,
+                                                                         const MeshBufferSizes& sizes) {
+	GeneratedModel& currentModel = getOrCreateModel(initialShapeIndex);
+	if (currentModel.getPrototypes().count(prototypeIndex) == 0)
+		return {};
+	return addLevel(currentModel.getPrototype(prototypeIndex), level, sizes);
+}
+
+void RhinoCallbacks::addInstance(const size_t initialShapeIndex, const size_t instanceIndex,
+                                 const size_t prototypeIndex, const double* transformation,
+                                 prt::AttributeMap const* const* materials, size_t matCount) {
+	if (transformation == nullptr)
 		return;
-	addUVCoordinates(initialShapeIndex, uvs, uvsSizes, uvCounts, uvCountsSizes, uvIndices, uvIndicesSizes, uvSets);
 
+	GeneratedModel& currentModel = getOrCreateModel(initialShapeIndex);
+
+	ModelInstance instance;
+	instance.mPrototypeIndex = prototypeIndex;
+	instance.mInstanceIndex = instanceIndex;
+	std::copy(transformation, transformation + instance.mTransformation.size(), instance.mTransformation.begin());
+	currentModel.addInstance(instance);
+
+	addMaterialAttributes(currentModel, instanceIndex, materials, matCount);
+}
+
+void RhinoCallbacks::addMaterialAttributes(GeneratedModel& model, const size_t instanceIndex,
+                                           prt::AttributeMap const* const* materials, size_t matCount) {
 	// -- convert materials into material attributes
 	if constexpr (DBG)
 		LOG_DBG << "got " << matCount << " materials";
@@ -134,7 +174,7 @@ void RhinoCallbacks::add(const size_t initialShapeIndex, const size_t instanceIn
 
 		const prt::AttributeMap* attrMap = materials[0];
 		auto ma = Materials::extractMaterials(instanceIndex, attrMap);
-		currentModel.addMaterial(ma);
+		model.addMaterial(ma);
 	}
 }
 
@@ -152,10 +192,8 @@ void RhinoCallbacks::addReport(const size_t initialShapeIndex, const prtx::PRTUt
 		return;
 	}
 
-	if (!mModels[initialShapeIndex])
-		return;
-
-	GeneratedModel& model = *mModels[initialShapeIndex];
+	// without the geometry channel the reports are the first output of the shape
+	GeneratedModel& model = getOrCreateModel(initialShapeIndex);
 
 	Reporting::extractReports(initialShapeIndex, model, reports);
 
@@ -190,6 +228,18 @@ void RhinoCallbacks::addAsset(const wchar_t* uri, const wchar_t* fileName, const
 	resultSize = pathStr.length() + 1;
 }
 
+void RhinoCallbacks::reset(const size_t initialShapeCount) {
+	mModels.assign(initialShapeCount, {});
+}
+
+void RhinoCallbacks::setGenerationControl(const GenerationControl* control) {
+	mGenerationControl = control;
+}
+
+bool RhinoCallbacks::isCanceled() const {
+	return (mGenerationControl != nullptr) && mGenerationControl->isCanceled();
+}
+
 const std::vector<GeneratedModelPtr>& RhinoCallbacks::getModels() const {
 	return mModels;
 }
@@ -22,6 +22,7 @@
 #include "IRhinoCallbacks.h"
 
 #include "GeneratedModel.h"
+#include "GenerationControl.h"
 #include "Logger.h"
 #include "MaterialAttribute.h"
 #include "ReportAttribute.h"
@@ -40,21 +41,37 @@ public:
 
 	// functions from IRhinoCallbacks
 
-	void add(const size_t initialShapeIndex, const size_t instanceIndex, const double* vertexCoords,
-	         const size_t vertexCoordsCount, const double* normals, const size_t normalsCount,
-	         const uint32_t* faceIndices, const size_t faceIndicesCount, const uint32_t* faceCounts,
-	         const size_t faceCountsCount, double const* const* uvs, size_t const* uvsSizes,
-	         uint32_t const* const* uvCounts, size_t const* uvCountsSizes, uint32_t const* const* uvIndices,
-	         size_t const* uvIndicesSizes, uint32_t uvSets, const uint32_t* faceRanges, size_t faceRangesSize,
-	         prt::AttributeMap const* const* materials, size_t matCount) override;
+	void setLocalOrigin(const size_t initialShapeIndex, const double* origin) override;
+
+	MeshBuffers acquireMeshBuffers(const size_t initialShapeIndex, const MeshBufferSizes& sizes) override;
+
+	void addMaterials(const size_t initialShapeIndex, const size_t instanceIndex, const uint32_t* faceRanges,
+	                  size_t faceRangesSize, prt::AttributeMap const* const* materials, size_t matCount) override;
+
+	MeshBuffers acquirePrototypeBuffers(const size_t initialShapeIndex, const size_t prototypeIndex,
+	                                    const MeshBufferSizes& sizes) override;
+
+	MeshBuffers acquireMeshLevelBuffers(const size_t initialShapeIndex, const size_t level,
+	                                    const MeshBufferSizes& sizes) override;
+
+	MeshBuffers acquirePrototypeLevelBuffers(const size_t initialShapeIndex, const size_t prototypeIndex,
+	                                         const size_t level, const MeshBufferSizes& sizes) override;
+
+	void addInstance(const size_t initialShapeIndex, const size_t instanceIndex, const size_t prototypeIndex,
+	                 const double* transformation, prt::AttributeMap const* const* materials,
+	                 size_t matCount) override;
 
 	void addReport(const size_t initialShapeIndex, const prtx::PRTUtils::AttributeMapPtr reports) override;
 
 	void addAsset(const wchar_t* uri, const wchar_t* fileName, const uint8_t* buffer, size_t size, wchar_t* result,
 	              size_t& resultSize) override;
 
+	bool isCanceled() const override;
+
 	// local helper functions
 
+	void reset(const size_t initialShapeCount);
+	void setGenerationControl(const GenerationControl* control);
 	const std::vector<GeneratedModelPtr>& getModels() const;
 	const Reporting::ReportMap& getReport(const size_t initialShapeIdx) const;
 
@@ -97,14 +114,13 @@ public:
 private:
 	GeneratedModel& getOrCreateModel(size_t initialShapeIndex);
 
-	bool addGeometry(const size_t initialShapeIndex, const double* vertexCoords, const size_t vertexCoordsCount,
-	                 const double* normals, const size_t normalsCount, const uint32_t* faceIndices,
-	                 const size_t faceIndicesCount, const uint32_t* faceCounts, const size_t faceCountsCount);
+	static MeshBuffers resizeModelPart(ModelPart& modelPart, const MeshBufferSizes& sizes);
+	static MeshBuffers addLevel(ModelPart& modelPart, const size_t level, const MeshBufferSizes& sizes);
 
-	void addUVCoordinates(const size_t initialShapeIndex, double const* const* uvs, size_t const* uvsSizes,
-	                      uint32_t const* const* uvCounts, size_t const* uvCountsSizes,
-	                      uint32_t const* const* uvIndices, size_t const* uvIndicesSizes, uint32_t uvSets);
+	void addMaterialAttributes(GeneratedModel& model, const size_t instanceIndex,
+	                           prt::AttributeMap const* const* materials, size_t matCount);
 
 private:
 	std::vector<GeneratedModelPtr> mModels;
+	const GenerationControl* mGenerationControl = nullptr;
 };
@@ -42,6 +42,12 @@ bool RhinoPRTAPI::InitializeRhinoPRT() {
 }
 
 void RhinoPRTAPI::ShutdownRhinoPRT() {
+	shutdownJobs();
+	{
+		std::lock_guard<std::mutex> lock(mGenerateMutex);
+		if (mModelGenerator)
+			mModelGenerator->saveGenerationHistory();
+	}
 	PRTContext::get().reset();
 }
 
@@ -50,35 +56,307 @@ bool RhinoPRTAPI::IsPRTInitialized() {
 }
 
 const RuleAttributes RhinoPRTAPI::GetRuleAttributes(const std::wstring& rulePkg) {
-	if (!mModelGenerator)
-		mModelGenerator = std::unique_ptr<ModelGenerator>(new ModelGenerator());
-	return mModelGenerator->getRuleAttributes(rulePkg);
+	return getModelGenerator().getRuleAttributes(rulePkg);
 }
 
-const pcu::AttributeMapPtrVector RhinoPRTAPI::getDefaultAttributes(const std::wstring& rpk_path, 
-																   std::vector<RawInitialShape>& rawInitialShapes) {
-	if (!mModelGenerator)
-		mModelGenerator = std::unique_ptr<ModelGenerator>(new ModelGenerator());
+const pcu::AttributeMapPtrVector RhinoPRTAPI::getDefaultAttributes(const std::wstring& rpk_path,
+                                                                   std::vector<RawInitialShape>& rawInitialShapes) {
+	// a running prefetch of the same rule package and shapes is about to hand out the default values, wait for it
+	// instead of evaluating them twice
+	std::shared_future<void> runningPrefetch;
+	{
+		const uint64_t prefetchKey = ModelGenerator::getDefaultAttributesKey(rpk_path, rawInitialShapes);
+		std::lock_guard<std::mutex> lock(mPrefetchMutex);
+		if (mPrefetchControl && !mPrefetchControl->isCanceled() && mPrefetchKey == prefetchKey &&
+		    !mPrefetchJobs.empty())
+			runningPrefetch = mPrefetchJobs.back();
+	}
+	if (runningPrefetch.valid())
+		runningPrefetch.wait();
 
-	pcu::ShapeAttributes attributes = mModelGenerator->getShapeAttributes(rpk_path);
-	return mModelGenerator->evalDefaultAttributes(rpk_path, rawInitialShapes, attributes);
+	ModelGenerator& modelGenerator = getModelGenerator();
+	pcu::ShapeAttributes attributes = modelGenerator.getShapeAttributes(rpk_path);
+	return modelGenerator.evalDefaultAttributes(rpk_path, rawInitialShapes, attributes);
+}
+
+void RhinoPRTAPI::prefetchRulePackage(const std::wstring& rpk_path, std::vector<RawInitialShape>&& rawInitialShapes) {
+	// the key of the prefetched default values, a modified rule package on the same path needs a new prefetch as well
+	const uint64_t prefetchKey = ModelGenerator::getDefaultAttributesKey(rpk_path, rawInitialShapes);
+
+	std::lock_guard<std::mutex> lock(mPrefetchMutex);
+	reapPrefetchJobs();
+	if (mPrefetchControl && !mPrefetchControl->isCanceled() && mPrefetchKey == prefetchKey)
+		return;
+
+	if (mPrefetchControl)
+		mPrefetchControl->cancel();
+	mPrefetchKey = prefetchKey;
+	mPrefetchControl = std::make_shared<GenerationControl>();
+
+	auto shapes = std::make_shared<std::vector<RawInitialShape>>(std::move(rawInitialShapes));
+	mPrefetchJobs.emplace_back(std::async(std::launch::async, [this, rpk_path, shapes, control = mPrefetchControl]() {
+		// runs next to the attribute queries and generations, a stale prefetch gives up between its chunks of shapes
+		getModelGenerator().prefetch(rpk_path, *shapes, *control);
+	}).share());
 }
 
 std::vector<GeneratedModelPtr> RhinoPRTAPI::GenerateGeometry(const std::wstring& rpk_path,
                                                              std::vector<RawInitialShape>& rawInitialShapes,
-                                                             pcu::AttributeMapBuilderVector& aBuilders) {
-	if (!mModelGenerator)
-		mModelGenerator = std::unique_ptr<ModelGenerator>(new ModelGenerator());
+                                                             pcu::AttributeMapBuilderVector& aBuilders,
+                                                             ResultChannel* resultChannel,
+                                                             const GenerateOptions& options) {
+	return generateInteractively(rpk_path, rawInitialShapes, aBuilders, resultChannel, false, options);
+}
+
+std::vector<GeneratedModelPtr> RhinoPRTAPI::GenerateReports(const std::wstring& rpk_path,
+                                                            std::vector<RawInitialShape>& rawInitialShapes,
+                                                            pcu::AttributeMapBuilderVector& aBuilders) {
+	return generateInteractively(rpk_path, rawInitialShapes, aBuilders, nullptr, true);
+}
+
+std::vector<GeneratedModelPtr> RhinoPRTAPI::generateInteractively(const std::wstring& rpk_path,
+                                                                  std::vector<RawInitialShape>& rawInitialShapes,
+                                                                  pcu::AttributeMapBuilderVector& aBuilders,
+                                                                  ResultChannel* resultChannel, bool reportsOnly,
+                                                                  const GenerateOptions& options) {
+	const GenerateProgressCallback progressCallback = mProgressCallback;
+	auto control = std::make_shared<GenerationControl>([progressCallback](size_t shapesDone, size_t shapesTotal) {
+		if (progressCallback != nullptr)
+			progressCallback(static_cast<int>(shapesDone), static_cast<int>(shapesTotal));
+	});
+	{
+		std::lock_guard<std::mutex> lock(mGenerationControlMutex);
+		mGenerationControl = control;
+	}
+
+	std::vector<GeneratedModelPtr> generatedModels =
+	        generate(rpk_path, rawInitialShapes, aBuilders, *control, resultChannel, reportsOnly, options);
+
+	{
+		std::lock_guard<std::mutex> lock(mGenerationControlMutex);
+		if (mGenerationControl == control)
+			mGenerationControl.reset();
+	}
+
+	return generatedModels;
+}
+
+std::vector<GeneratedModelPtr> RhinoPRTAPI::generate(const std::wstring& rpk_path,
+                                                     std::vector<RawInitialShape>& rawInitialShapes,
+                                                     pcu::AttributeMapBuilderVector& aBuilders,
+                                                     GenerationControl& control, ResultChannel* resultChannel,
+                                                     bool reportsOnly, const GenerateOptions& options) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	if (control.isCanceled())
+		return {};
+
+	ModelGenerator& modelGenerator = getModelGenerator();
 
 	//Build ShapeAttributes
-	pcu::ShapeAttributes attributes = mModelGenerator->getShapeAttributes(rpk_path);
-	
-	std::vector<GeneratedModelPtr> generatedModels = mModelGenerator->generateModel(rpk_path, rawInitialShapes, attributes, aBuilders);
-	assert(generatedModels.size() == rawInitialShapes.size());
+	pcu::ShapeAttributes attributes = modelGenerator.getShapeAttributes(rpk_path);
+
+	std::vector<GeneratedModelPtr> generatedModels =
+	        reportsOnly ? modelGenerator.generateReports(rpk_path, rawInitialShapes, attributes, aBuilders, &control)
+	                    : modelGenerator.generateModel(rpk_path, rawInitialShapes, attributes, aBuilders, &control,
+	                                                   resultChannel, options);
+	assert(generatedModels.empty() || generatedModels.size() == rawInitialShapes.size());
 	return generatedModels;
 }
 
+ModelGenerator& RhinoPRTAPI::getModelGenerator() {
+	// created on first use by whichever of the generation and attribute paths comes first
+	std::call_once(mModelGeneratorCreated,
+	               [this]() { mModelGenerator = std::unique_ptr<ModelGenerator>(new ModelGenerator()); });
+	return *mModelGenerator;
+}
+
 void RhinoPRTAPI::setMaterialGeneration(bool emitMaterial) {
-	mModelGenerator->updateEncoderOptions(emitMaterial);
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().updateEncoderOptions(emitMaterial);
+}
+
+void RhinoPRTAPI::setGenerateProgressCallback(GenerateProgressCallback progressCallback) {
+	mProgressCallback = progressCallback;
+}
+
+void RhinoPRTAPI::cancelGenerate() {
+	{
+		std::lock_guard<std::mutex> lock(mGenerationControlMutex);
+		if (mGenerationControl)
+			mGenerationControl->cancel();
+	}
+
+	std::lock_guard<std::mutex> lock(mJobsMutex);
+	for (auto& job : mJobs)
+		job.second.control->cancel();
+}
+
+void RhinoPRTAPI::setGenerationConcurrency(const GenerationConcurrency& concurrency) {
+	// the attribute evaluation only reads the thread budget of the pool, it does not wait for the restart
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	if (PRTContext::get())
+		PRTContext::get()->setGenerationConcurrency(concurrency);
+}
+
+void RhinoPRTAPI::setGenerationMemoryBudget(size_t bytes) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().setMemoryBudget(bytes);
+}
+
+void RhinoPRTAPI::setPositionIndependent(const std::wstring& rpk_path, bool positionIndependent) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().setPositionIndependent(rpk_path, positionIndependent);
+}
+
+void RhinoPRTAPI::setInstancing(bool instancing) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().setInstancing(instancing);
+}
+
+void RhinoPRTAPI::setSinglePrecision(bool singlePrecision) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().setSinglePrecision(singlePrecision);
+}
+
+void RhinoPRTAPI::setVertexWelding(bool enabled, double positionTolerance, double normalTolerance, double uvTolerance) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().setVertexWelding(enabled, positionTolerance, normalTolerance, uvTolerance);
+}
+
+void RhinoPRTAPI::setOutputChannels(uint32_t channels) {
+	std::lock_guard<std::mutex> lock(mGenerateMutex);
+	getModelGenerator().setOutputChannels(channels);
+}
+
+int RhinoPRTAPI::submitGenerate(const std::wstring& rpk_path, std::vector<RawInitialShape>&& rawInitialShapes,
+                                pcu::AttributeMapBuilderVector&& aBuilders, const GenerateOptions& options) {
+	auto control = std::make_shared<GenerationControl>();
+
+	// the job owns its inputs, the caller's buffers may be gone by the time it runs
+	auto shapes = std::make_shared<std::vector<RawInitialShape>>(std::move(rawInitialShapes));
+	auto builders = std::make_shared<pcu::AttributeMapBuilderVector>(std::move(aBuilders));
+	auto result = std::async(std::launch::async, [this, rpk_path, shapes, builders, control, options]() {
+		try {
+			return generate(rpk_path, *shapes, *builders, *control, nullptr, false, options);
+		}
+		catch (std::exception& e) {
+			LOG_ERR << "generate job failed: " << e.what();
+		}
+		catch (...) {
+			LOG_ERR << "generate job failed: unknown exception";
+		}
+		return std::vector<GeneratedModelPtr>();
+	});
+
+	std::lock_guard<std::mutex> lock(mJobsMutex);
+	reapAbandonedJobs();
+	reapUnfetchedJobs();
+	const int jobId = mNextJobId++;
+	mJobs.emplace(jobId, GenerateJob{control, std::move(result), options.lodRatios.size()});
+	return jobId;
+}
+
+GenerateJobStatus RhinoPRTAPI::pollGenerate(int jobId, size_t& shapesDone, size_t& shapesTotal) {
+	std::lock_guard<std::mutex> lock(mJobsMutex);
+	const auto it = mJobs.find(jobId);
+	if (it == mJobs.end())
+		return GenerateJobStatus::UNKNOWN;
+
+	it->second.control->getProgress(shapesDone, shapesTotal);
+	const bool ready = it->second.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	return ready ? GenerateJobStatus::READY : GenerateJobStatus::RUNNING;
+}
+
+bool RhinoPRTAPI::fetchGenerateResults(int jobId, std::vector<GeneratedModelPtr>& models, size_t& levelCount) {
+	std::lock_guard<std::mutex> lock(mJobsMutex);
+	const auto it = mJobs.find(jobId);
+	if (it == mJobs.end())
+		return false;
+	if (it->second.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return false;
+
+	models = it->second.result.get();
+	levelCount = it->second.levelCount;
+	mJobs.erase(it);
+	return true;
+}
+
+void RhinoPRTAPI::discardGenerateJob(int jobId) {
+	std::lock_guard<std::mutex> lock(mJobsMutex);
+	const auto it = mJobs.find(jobId);
+	if (it == mJobs.end())
+		return;
+
+	// destroying the future of a running std::async job would block until it has finished, let it wind down instead
+	it->second.control->cancel();
+	mAbandonedJobs.emplace_back(std::move(it->second));
+	mJobs.erase(it);
+	reapAbandonedJobs();
+}
+
+void RhinoPRTAPI::reapAbandonedJobs() {
+	mAbandonedJobs.erase(std::remove_if(mAbandonedJobs.begin(), mAbandonedJobs.end(),
+	                                    [](const GenerateJob& job) {
+		                                    return job.result.wait_for(std::chrono::seconds(0)) ==
+		                                           std::future_status::ready;
+	                                    }),
+	                     mAbandonedJobs.end());
+}
+
+void RhinoPRTAPI::reapUnfetchedJobs() {
+	// job ids grow monotonically, the map iterates from the oldest job on
+	size_t unfetchedCount = 0;
+	for (const auto& job : mJobs) {
+		if (job.second.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			unfetchedCount++;
+	}
+
+	for (auto it = mJobs.begin(); it != mJobs.end() && unfetchedCount > MAX_UNFETCHED_JOBS;) {
+		if (it->second.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++it;
+			continue;
+		}
+		LOG_WRN << "discarding the results of generate job " << it->first << ", they were never fetched";
+		it = mJobs.erase(it);
+		unfetchedCount--;
+	}
+}
+
+void RhinoPRTAPI::reapPrefetchJobs() {
+	mPrefetchJobs.erase(std::remove_if(mPrefetchJobs.begin(), mPrefetchJobs.end(),
+	                                   [](const std::shared_future<void>& job) {
+		                                   return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	                                   }),
+	                    mPrefetchJobs.end());
+}
+
+void RhinoPRTAPI::shutdownJobs() {
+	std::vector<std::shared_future<void>> prefetchJobs;
+	{
+		std::lock_guard<std::mutex> lock(mPrefetchMutex);
+		if (mPrefetchControl)
+			mPrefetchControl->cancel();
+		mPrefetchControl.reset();
+		mPrefetchKey = 0;
+		std::swap(prefetchJobs, mPrefetchJobs);
+	}
+	prefetchJobs.clear();
+
+	std::map<int, GenerateJob> jobs;
+	std::vector<GenerateJob> abandonedJobs;
+	{
+		std::lock_guard<std::mutex> lock(mJobsMutex);
+		std::swap(jobs, mJobs);
+		std::swap(abandonedJobs, mAbandonedJobs);
+	}
+
+	for (auto& job : jobs)
+		job.second.control->cancel();
+	for (auto& job : abandonedJobs)
+		job.control->cancel();
+
+	// the futures wait for their jobs on destruction, which must happen before the PRT context goes away
+	jobs.clear();
+	abandonedJobs.clear();
 }
 } // namespace RhinoPRT
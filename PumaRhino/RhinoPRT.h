@@ -28,16 +28,26 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #pragma comment(lib, "ole32.lib") // Workaround for "combaseapi.h(229): error C2187: syntax error: 'identifier' was
                                   // unexpected here" when using /permissive-
 
 namespace RhinoPRT {
 
+using GenerateProgressCallback = void (*)(int shapesDone, int shapesTotal);
+
+enum class GenerateJobStatus { UNKNOWN = -1, RUNNING = 0, READY = 1 };
+
 class RhinoPRTAPI {
 public:
 	const RuleAttributeUPtr RULE_NOT_FOUND{};
@@ -49,21 +59,139 @@ public:
 	const RuleAttributes GetRuleAttributes(const std::wstring& rulePkg);
 
 	const pcu::AttributeMapPtrVector getDefaultAttributes(const std::wstring& rpk_path,
-	                                                  std::vector<RawInitialShape>& rawInitialShapes);
-
+	                                                      std::vector<RawInitialShape>& rawInitialShapes);
+
+	/**
+	 * Loads the rule package and evaluates the default attributes of the shapes on a background thread, so that the
+	 * following calls for this rule package and shapes find everything ready. A prefetch for another rule package or
+	 * other shapes cancels the previous one, repeating the latest prefetch has no effect. getDefaultAttributes waits for
+	 * a running prefetch of the same rule package and shapes instead of repeating its evaluation.
+	 */
+	void prefetchRulePackage(const std::wstring& rpk_path, std::vector<RawInitialShape>&& rawInitialShapes);
+
+	/**
+	 * @param resultChannel optional, receives the models on the calling thread while the generation is still running.
+	 * @param options per call outputs like bounding box proxies, decimated meshes or levels of detail, see
+	 * GenerateOptions.
+	 */
 	std::vector<GeneratedModelPtr> GenerateGeometry(const std::wstring& rpk_path,
 	                                                std::vector<RawInitialShape>& rawInitialShapes,
-	                                                pcu::AttributeMapBuilderVector& aBuilders);
+	                                                pcu::AttributeMapBuilderVector& aBuilders,
+	                                                ResultChannel* resultChannel = nullptr,
+	                                                const GenerateOptions& options = {});
+
+	/**
+	 * Reports-only generation, see ModelGenerator::generateReports. Can be canceled like GenerateGeometry.
+	 */
+	std::vector<GeneratedModelPtr> GenerateReports(const std::wstring& rpk_path,
+	                                               std::vector<RawInitialShape>& rawInitialShapes,
+	                                               pcu::AttributeMapBuilderVector& aBuilders);
 
 	void setMaterialGeneration(bool emitMaterial);
 
+	/**
+	 * The callback is called on the generation threads of the synchronous GenerateGeometry and GenerateReports calls.
+	 */
+	void setGenerateProgressCallback(GenerateProgressCallback progressCallback);
+
+	/**
+	 * Cancels the running synchronous generation and all asynchronous jobs, the canceled jobs have no results.
+	 */
+	void cancelGenerate();
+
+	/**
+	 * Waits for a running generation to finish before the generation workers are restarted with the new settings.
+	 */
+	void setGenerationConcurrency(const GenerationConcurrency& concurrency);
+
+	void setGenerationMemoryBudget(size_t bytes);
+
+	void setPositionIndependent(const std::wstring& rpk_path, bool positionIndependent);
+
+	void setInstancing(bool instancing);
+
+	void setSinglePrecision(bool singlePrecision);
+
+	void setVertexWelding(bool enabled, double positionTolerance, double normalTolerance, double uvTolerance);
+
+	void setOutputChannels(uint32_t channels);
+
+	/**
+	 * Asynchronous generation: the job takes ownership of the initial shapes and attribute builders and runs on a
+	 * background thread. Its results are kept until they are fetched or the job is discarded; both free the job. Of
+	 * the finished jobs which were never fetched, only the latest MAX_UNFETCHED_JOBS are kept. Returns the job id.
+	 *
+	 * The generations run one at a time, jobs and synchronous calls alike: a GenerateGeometry call waits for the
+	 * running job (and possibly for queued ones) to finish. Discard the jobs whose results are no longer needed, they
+	 * stop at their next chunk of shapes.
+	 */
+	int submitGenerate(const std::wstring& rpk_path, std::vector<RawInitialShape>&& rawInitialShapes,
+	                   pcu::AttributeMapBuilderVector&& aBuilders, const GenerateOptions& options = {});
+	GenerateJobStatus pollGenerate(int jobId, size_t& shapesDone, size_t& shapesTotal);
+	/**
+	 * Moves the results of a finished job into models and frees the job. Returns false if the job is unknown or
+	 * still running.
+	 * @param levelCount receives the number of coarser levels of detail the job was submitted with.
+	 */
+	bool fetchGenerateResults(int jobId, std::vector<GeneratedModelPtr>& models, size_t& levelCount);
+	/**
+	 * Cancels the job and frees it (and its results) as soon as it has stopped.
+	 */
+	void discardGenerateJob(int jobId);
+
 private:
+	struct GenerateJob {
+		GenerationControlSPtr control;
+		std::future<std::vector<GeneratedModelPtr>> result;
+		size_t levelCount = 0; // see GenerateOptions::lodRatios
+	};
+
+	/**
+	 * Runs a generation which can be canceled with cancelGenerate and reports its progress to the progress callback.
+	 */
+	std::vector<GeneratedModelPtr> generateInteractively(const std::wstring& rpk_path,
+	                                                     std::vector<RawInitialShape>& rawInitialShapes,
+	                                                     pcu::AttributeMapBuilderVector& aBuilders,
+	                                                     ResultChannel* resultChannel, bool reportsOnly,
+	                                                     const GenerateOptions& options = {});
+	std::vector<GeneratedModelPtr> generate(const std::wstring& rpk_path,
+	                                        std::vector<RawInitialShape>& rawInitialShapes,
+	                                        pcu::AttributeMapBuilderVector& aBuilders, GenerationControl& control,
+	                                        ResultChannel* resultChannel, bool reportsOnly = false,
+	                                        const GenerateOptions& options = {});
+	ModelGenerator& getModelGenerator();
+	void reapAbandonedJobs();
+	void reapUnfetchedJobs();
+	void reapPrefetchJobs();
+	void shutdownJobs();
+
 	std::vector<RawInitialShape> mShapes;
 	std::vector<pcu::ShapeAttributes> mAttributes;
 
 	pcu::AttributeMapBuilderVector mAttrBuilders;
 
 	std::unique_ptr<ModelGenerator> mModelGenerator;
+	std::once_flag mModelGeneratorCreated;
+
+	std::mutex mGenerationControlMutex;
+	GenerationControlSPtr mGenerationControl; // control of the currently running generation, if any
+	std::atomic<GenerateProgressCallback> mProgressCallback{nullptr};
+
+	// serializes the generations and the changes of their settings between sync calls and async jobs. The attribute
+	// queries and prefetches run concurrently to them, outside of the generation pool.
+	std::mutex mGenerateMutex;
+
+	static constexpr size_t MAX_UNFETCHED_JOBS = 16;
+	std::mutex mJobsMutex;
+	int mNextJobId = 1;
+	std::map<int, GenerateJob> mJobs;
+	std::vector<GenerateJob> mAbandonedJobs; // discarded but still running, waiting for their cancellation to finish
+
+	std::mutex mPrefetchMutex;
+	uint64_t mPrefetchKey = 0; // rule package and shapes of the latest prefetch
+	GenerationControlSPtr mPrefetchControl;
+	// stale prefetches which are still winding down and the latest one (at the back), attribute queries wait for it
+	std::vector<std::shared_future<void>> mPrefetchJobs;
 };
 
 // Global PRT handle
@@ -0,0 +1,143 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ShapeCostEstimator.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// weights of the geometric features, a base cost accounts for the fixed per shape overhead
+constexpr double COST_BASE = 1.0;
+constexpr double COST_PER_FACE = 1.0;
+constexpr double COST_PER_VERTEX = 0.25;
+constexpr double COST_PER_AREA = 0.01; // per square unit of footprint area
+
+// weight of the newest batch in the exponential moving average of the calibration factor
+constexpr double CALIBRATION_SMOOTHING = 0.3;
+
+// a chunk taking this much longer than expected contains at least one shape which is much more expensive than estimated
+constexpr double OUTLIER_CHUNK_FACTOR = 4.0;
+
+} // namespace
+
+ShapeCostEstimator::ShapeCostEstimator(GenerationHistory& history, const std::wstring& startRule)
+    : mHistory(history), mStartRule(startRule) {}
+
+double ShapeCostEstimator::getFeatureCost(const double* vertices, size_t vertexCoordCount, const uint32_t* indices,
+                                          const uint32_t* faceCounts, size_t faceCountsCount) {
+	return COST_BASE + COST_PER_FACE * static_cast<double>(faceCountsCount) +
+	       COST_PER_VERTEX * static_cast<double>(vertexCoordCount / 3) +
+	       COST_PER_AREA * getArea(vertices, vertexCoordCount, indices, faceCounts, faceCountsCount);
+}
+
+double ShapeCostEstimator::getArea(const double* vertices, size_t vertexCoordCount, const uint32_t* indices,
+                                   const uint32_t* faceCounts, size_t faceCountsCount) {
+	const size_t vertexCount = vertexCoordCount / 3;
+
+	double area = 0.0;
+	size_t indexBase = 0;
+	for (size_t fi = 0; fi < faceCountsCount; fi++) {
+		const uint32_t faceVertexCount = faceCounts[fi];
+
+		// Newell's method, works for non-planar and concave polygons
+		double nx = 0.0, ny = 0.0, nz = 0.0;
+		for (uint32_t vi = 0; vi < faceVertexCount; vi++) {
+			const uint32_t i0 = indices[indexBase + vi];
+			const uint32_t i1 = indices[indexBase + (vi + 1) % faceVertexCount];
+			if (i0 >= vertexCount || i1 >= vertexCount)
+				continue;
+			const double* a = &vertices[i0 * 3];
+			const double* b = &vertices[i1 * 3];
+			nx += (a[1] - b[1]) * (a[2] + b[2]);
+			ny += (a[2] - b[2]) * (a[0] + b[0]);
+			nz += (a[0] - b[0]) * (a[1] + b[1]);
+		}
+		area += 0.5 * std::sqrt(nx * nx + ny * ny + nz * nz);
+		indexBase += faceVertexCount;
+	}
+	return area;
+}
+
+double ShapeCostEstimator::estimate(uint64_t shapeKey, double featureCost) const {
+	const std::optional<double> secondsPerCost = mHistory.getSecondsPerCost(mStartRule);
+	if (secondsPerCost) {
+		const std::optional<double> measuredSeconds = mHistory.getShapeSeconds(mStartRule, shapeKey);
+		if (measuredSeconds)
+			return *measuredSeconds;
+		return featureCost * (*secondsPerCost);
+	}
+	return featureCost;
+}
+
+void ShapeCostEstimator::update(const std::vector<uint64_t>& shapeKeys, const std::vector<double>& featureCosts,
+                                const std::vector<ChunkTiming>& chunkTimings) {
+	assert(shapeKeys.size() == featureCosts.size());
+
+	const auto getChunkFeatureCost = [&featureCosts](const ChunkTiming& chunk) {
+		double chunkFeatureCost = 0.0;
+		for (size_t shapeIndex : chunk.shapeIndices)
+			chunkFeatureCost += featureCosts[shapeIndex];
+		return chunkFeatureCost;
+	};
+
+	double totalSeconds = 0.0;
+	double totalFeatureCost = 0.0;
+	for (const ChunkTiming& chunk : chunkTimings) {
+		if (chunk.seconds <= 0.0 || chunk.shapeIndices.empty())
+			continue; // not generated, e.g. failed chunks
+		totalSeconds += chunk.seconds;
+		totalFeatureCost += getChunkFeatureCost(chunk);
+	}
+
+	if (totalSeconds <= 0.0 || totalFeatureCost <= 0.0)
+		return;
+
+	// the outliers are detected relative to this batch, the calibration of previous batches may be off
+	const double batchSecondsPerCost = totalSeconds / totalFeatureCost;
+	for (const ChunkTiming& chunk : chunkTimings) {
+		if (chunk.seconds <= 0.0 || chunk.shapeIndices.empty())
+			continue;
+
+		if (chunk.shapeIndices.size() == 1) {
+			mHistory.setShapeSeconds(mStartRule, shapeKeys[chunk.shapeIndices.front()], chunk.seconds);
+			continue;
+		}
+
+		double expectedSeconds = 0.0;
+		for (size_t shapeIndex : chunk.shapeIndices) {
+			const std::optional<double> measuredSeconds = mHistory.getShapeSeconds(mStartRule, shapeKeys[shapeIndex]);
+			expectedSeconds += measuredSeconds ? *measuredSeconds : featureCosts[shapeIndex] * batchSecondsPerCost;
+		}
+		if (chunk.seconds <= OUTLIER_CHUNK_FACTOR * expectedSeconds)
+			continue;
+
+		for (size_t shapeIndex : chunk.shapeIndices) {
+			if (!mHistory.getShapeSeconds(mStartRule, shapeKeys[shapeIndex]))
+				mHistory.setShapeSeconds(mStartRule, shapeKeys[shapeIndex], chunk.seconds);
+		}
+	}
+
+	const std::optional<double> previous = mHistory.getSecondsPerCost(mStartRule);
+	const double secondsPerCost = previous ? (1.0 - CALIBRATION_SMOOTHING) * (*previous) +
+	                                                 CALIBRATION_SMOOTHING * batchSecondsPerCost
+	                                       : batchSecondsPerCost;
+	mHistory.setSecondsPerCost(mStartRule, secondsPerCost);
+}
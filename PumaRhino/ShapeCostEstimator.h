@@ -0,0 +1,78 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "GenerationHistory.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Estimates how long an initial shape takes to generate, used to schedule the most expensive shapes first (longest
+ * processing time first). The estimate is based on cheap geometric features of the initial shape and refined with the
+ * timings recorded in the generation history of previous runs. Shapes are identified by their geometry hash.
+ */
+class ShapeCostEstimator {
+public:
+	/**
+	 * Measured wall time of one prt::generate call and the indices of the shapes it generated.
+	 */
+	struct ChunkTiming {
+		std::vector<size_t> shapeIndices;
+		double seconds = 0.0;
+	};
+
+	ShapeCostEstimator(GenerationHistory& history, const std::wstring& startRule);
+
+	/**
+	 * Unitless cost derived from face count, vertex count and footprint area of the initial shape geometry (same
+	 * buffer layout as RawInitialShape, i.e. vertexCoordCount is three times the number of vertices).
+	 */
+	static double getFeatureCost(const double* vertices, size_t vertexCoordCount, const uint32_t* indices,
+	                             const uint32_t* faceCounts, size_t faceCountsCount);
+
+	/**
+	 * Sum of the face areas, works for non-planar and concave faces.
+	 */
+	static double getArea(const double* vertices, size_t vertexCoordCount, const uint32_t* indices,
+	                      const uint32_t* faceCounts, size_t faceCountsCount);
+
+	/**
+	 * Estimated generation time in seconds, or the relative feature cost if there is no history for the start rule yet.
+	 * Either way the estimates of one batch are comparable with each other.
+	 */
+	double estimate(uint64_t shapeKey, double featureCost) const;
+
+	/**
+	 * Updates the calibration of the feature cost with the chunk timings of a batch. Only chunks with a single shape
+	 * are recorded as per shape timings, the time of a larger chunk cannot be attributed to its shapes. If a larger
+	 * chunk took much longer than expected, its unmeasured shapes get the chunk time as an upper bound though, which
+	 * moves them to the single shape head of the next batch where they are measured individually.
+	 * @param shapeKeys geometry hash of each shape of the batch
+	 * @param featureCosts feature cost of each shape of the batch
+	 */
+	void update(const std::vector<uint64_t>& shapeKeys, const std::vector<double>& featureCosts,
+	            const std::vector<ChunkTiming>& chunkTimings);
+
+private:
+	GenerationHistory& mHistory;
+	const std::wstring mStartRule;
+};
@@ -0,0 +1,116 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ShapeScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+// aim for a couple of chunks per worker so there is something left to steal towards the end of a batch
+constexpr size_t CHUNKS_PER_WORKER = 8;
+
+// upper bound to keep the per-call overhead of prt::generate amortized without creating long tails
+constexpr size_t MAX_CHUNK_SIZE = 64;
+
+size_t computeChunkSize(size_t shapeCount, size_t workerCount) {
+	const size_t targetChunkCount = workerCount * CHUNKS_PER_WORKER;
+	const size_t chunkSize = (shapeCount + targetChunkCount - 1) / targetChunkCount;
+	return std::clamp<size_t>(chunkSize, 1, MAX_CHUNK_SIZE);
+}
+
+} // namespace
+
+ShapeScheduler::ShapeScheduler(size_t shapeCount, size_t workerCount, Distribution distribution,
+                               size_t singleShapeCount)
+    : mChunkSize(computeChunkSize(shapeCount - std::min(singleShapeCount, shapeCount),
+                                  std::max<size_t>(workerCount, 1))) {
+	assert(workerCount > 0);
+
+	mQueues.reserve(workerCount);
+	for (size_t wi = 0; wi < workerCount; wi++)
+		mQueues.emplace_back(std::make_unique<WorkerQueue>());
+
+	std::vector<Chunk> chunks;
+	const size_t singleShapeEnd = std::min(singleShapeCount, shapeCount);
+	for (size_t offset = 0; offset < singleShapeEnd; offset++)
+		chunks.push_back({offset, 1, false});
+	for (size_t offset = singleShapeEnd; offset < shapeCount; offset += mChunkSize)
+		chunks.push_back({offset, std::min(mChunkSize, shapeCount - offset), false});
+	const size_t chunkCount = chunks.size();
+
+	if (distribution == Distribution::ROUND_ROBIN) {
+		for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+			mQueues[chunkIndex % workerCount]->mChunks.push_back(chunks[chunkIndex]);
+		return;
+	}
+
+	// deal out contiguous blocks of chunks, i.e. without stealing we end up with the previous static split
+	const size_t chunksPerWorker = chunkCount / workerCount;
+	const size_t extraChunks = chunkCount % workerCount;
+
+	size_t chunkIndex = 0;
+	for (size_t wi = 0; wi < workerCount; wi++) {
+		const size_t workerChunkCount = chunksPerWorker + (wi < extraChunks ? 1 : 0);
+		for (size_t ci = 0; ci < workerChunkCount; ci++, chunkIndex++)
+			mQueues[wi]->mChunks.push_back(chunks[chunkIndex]);
+	}
+	assert(chunkIndex == chunkCount);
+}
+
+size_t ShapeScheduler::getWorkerCount() const {
+	return mQueues.size();
+}
+
+size_t ShapeScheduler::getChunkSize() const {
+	return mChunkSize;
+}
+
+bool ShapeScheduler::next(size_t workerIndex, Chunk& chunk) {
+	assert(workerIndex < mQueues.size());
+	return popOwn(workerIndex, chunk) || steal(workerIndex, chunk);
+}
+
+bool ShapeScheduler::popOwn(size_t workerIndex, Chunk& chunk) {
+	WorkerQueue& queue = *mQueues[workerIndex];
+	std::lock_guard<std::mutex> lock(queue.mMutex);
+	if (queue.mChunks.empty())
+		return false;
+	chunk = queue.mChunks.front();
+	queue.mChunks.pop_front();
+	return true;
+}
+
+bool ShapeScheduler::steal(size_t thiefIndex, Chunk& chunk) {
+	const size_t workerCount = mQueues.size();
+	for (size_t i = 1; i < workerCount; i++) {
+		WorkerQueue& victim = *mQueues[(thiefIndex + i) % workerCount];
+		std::lock_guard<std::mutex> lock(victim.mMutex);
+		if (victim.mChunks.empty())
+			continue;
+
+		// take from the back, i.e. the work the victim would get to last
+		chunk = victim.mChunks.back();
+		chunk.stolen = true;
+		victim.mChunks.pop_back();
+		return true;
+	}
+	return false;
+}
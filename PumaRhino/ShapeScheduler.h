@@ -0,0 +1,73 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Work-stealing distribution of initial shapes onto generation workers. The shapes are cut into small contiguous
+ * chunks which are initially dealt to the workers in contiguous blocks. A worker takes chunks from the front of its own
+ * queue and, once that is empty, steals from the back of the other queues. This keeps all workers busy even if a few
+ * shapes take much longer to generate than their neighbours. Optionally, the first shapes get a chunk of their own,
+ * e.g. to measure the generation time of the most expensive shapes individually.
+ */
+class ShapeScheduler {
+public:
+	enum class Distribution {
+		BLOCKS,     // contiguous blocks of chunks per worker, keeps neighbouring shapes on the same worker
+		ROUND_ROBIN // chunk i goes to worker i % workerCount, keeps the order of the shapes across all workers
+	};
+
+	struct Chunk {
+		size_t offset = 0; // index of the first shape of the chunk
+		size_t count = 0;  // number of shapes in the chunk
+		bool stolen = false;
+	};
+
+	ShapeScheduler(size_t shapeCount, size_t workerCount, Distribution distribution = Distribution::BLOCKS,
+	               size_t singleShapeCount = 0);
+	ShapeScheduler(const ShapeScheduler&) = delete;
+	ShapeScheduler& operator=(const ShapeScheduler&) = delete;
+
+	size_t getWorkerCount() const;
+	size_t getChunkSize() const; // of the chunks after the single shape chunks
+
+	/**
+	 * Fetches the next chunk for the given worker, steals from other workers if necessary.
+	 * @return false if there is no work left at all
+	 */
+	bool next(size_t workerIndex, Chunk& chunk);
+
+private:
+	struct WorkerQueue {
+		std::mutex mMutex;
+		std::deque<Chunk> mChunks;
+	};
+
+	bool popOwn(size_t workerIndex, Chunk& chunk);
+	bool steal(size_t thiefIndex, Chunk& chunk);
+
+	size_t mChunkSize;
+	std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+};
@@ -34,10 +34,12 @@
 
 #include <Windows.h>
 #include <conio.h>
+#include <emmintrin.h>
 #include <rpc.h>
 
 #include <cwchar>
 #include <filesystem>
+#include <iomanip>
 #include <sstream>
 #include <string>
 
@@ -143,6 +145,33 @@ std::wstring getUUID() {
 	throw std::runtime_error("Failed to create UUID");
 }
 
+std::wstring toHexString(uint64_t value) {
+	std::wostringstream wss;
+	wss << std::hex << std::setw(16) << std::setfill(L'0') << value;
+	return wss.str();
+}
+
+void translateVertices(double* coords, size_t vertexCount, const std::array<double, 3>& offset) {
+	// two vertices are six doubles, i.e. three SSE2 registers with the offset rotated through them
+	const __m128d xy = _mm_set_pd(offset[1], offset[0]);
+	const __m128d zx = _mm_set_pd(offset[0], offset[2]);
+	const __m128d yz = _mm_set_pd(offset[2], offset[1]);
+
+	size_t vi = 0;
+	for (; vi + 1 < vertexCount; vi += 2) {
+		double* c = coords + vi * 3;
+		_mm_storeu_pd(c, _mm_add_pd(_mm_loadu_pd(c), xy));
+		_mm_storeu_pd(c + 2, _mm_add_pd(_mm_loadu_pd(c + 2), zx));
+		_mm_storeu_pd(c + 4, _mm_add_pd(_mm_loadu_pd(c + 4), yz));
+	}
+	if (vi < vertexCount) {
+		double* c = coords + vi * 3;
+		c[0] += offset[0];
+		c[1] += offset[1];
+		c[2] += offset[2];
+	}
+}
+
 const std::string FILE_SCHEMA = "file:/";
 
 /**
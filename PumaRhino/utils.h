@@ -33,10 +33,13 @@
 #include "prt/FileOutputCallbacks.h"
 #include "prt/LogHandler.h"
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <string>
 #include <stdexcept>
+#include <type_traits>
 
 struct IUnknown; // Workaround for "combaseapi.h(229): error C2187: syntax error: 'identifier' was unexpected here" when
                  // using /permissive-
@@ -105,6 +108,63 @@ struct ShapeAttributes {
 AttributeMapPtr createAttributeMapForShape(const ShapeAttributes& attrs, prt::AttributeMapBuilder& bld);
 AttributeMapPtr createValidatedOptions(const wchar_t* encID, const prt::AttributeMap* unvalidatedOptions = nullptr);
 
+/**
+ * Hashing helpers
+ */
+
+/**
+ * Incremental 64bit FNV-1a hash to build content based keys (e.g. for initial shapes or generated models).
+ */
+class Hasher {
+public:
+	Hasher& add(const void* data, size_t size) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			mHash ^= bytes[i];
+			mHash *= FNV_PRIME;
+		}
+		return *this;
+	}
+
+	template <typename T>
+	Hasher& add(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Type T must be trivially copyable");
+		return add(static_cast<const void*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	Hasher& add(const T* values, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "Type T must be trivially copyable");
+		add(count);
+		return add(static_cast<const void*>(values), count * sizeof(T));
+	}
+
+	Hasher& add(const std::wstring& s) {
+		return add(s.data(), s.size());
+	}
+
+	uint64_t get() const {
+		return mHash;
+	}
+
+private:
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	uint64_t mHash = FNV_OFFSET_BASIS;
+};
+
+std::wstring toHexString(uint64_t value);
+
+/**
+ * Geometry helpers
+ */
+
+/**
+ * Adds the offset to each of the vertexCount interleaved xyz coordinates (SSE2).
+ */
+void translateVertices(double* coords, size_t vertexCount, const std::array<double, 3>& offset);
+
 /**
  * String and URI helpers
  */
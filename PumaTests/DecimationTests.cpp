@@ -0,0 +1,207 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include "Decimation.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace {
+
+struct Mesh {
+	std::vector<double> vertexCoords;
+	std::vector<uint32_t> triangles;
+
+	size_t getVertexCount() const {
+		return vertexCoords.size() / 3;
+	}
+};
+
+/**
+ * Surface of the cube [-1, 1]^3 with each face split into n x n quads, the vertices are shared between the faces, so
+ * the mesh is closed and no vertex is locked. The triangles wind counter-clockwise seen from outside.
+ */
+Mesh createCube(int n) {
+	Mesh mesh;
+	std::map<std::vector<int>, uint32_t> vertexIndices;
+	auto getVertex = [&](const std::vector<int>& lattice) {
+		const auto inserted = vertexIndices.emplace(lattice, static_cast<uint32_t>(mesh.getVertexCount()));
+		if (inserted.second) {
+			for (int k = 0; k < 3; k++)
+				mesh.vertexCoords.push_back(2.0 * lattice[k] / n - 1.0);
+		}
+		return inserted.first->second;
+	};
+
+	for (int axis = 0; axis < 3; axis++) {
+		const int u = (axis + 1) % 3;
+		const int v = (axis + 2) % 3;
+		for (int side : {0, n}) {
+			for (int i = 0; i < n; i++) {
+				for (int j = 0; j < n; j++) {
+					std::vector<int> a(3), b(3), c(3), d(3);
+					a[axis] = b[axis] = c[axis] = d[axis] = side;
+					a[u] = i, a[v] = j;
+					b[u] = i + 1, b[v] = j;
+					c[u] = i + 1, c[v] = j + 1;
+					d[u] = i, d[v] = j + 1;
+					if (side == 0)
+						std::swap(b, d); // u x v points inwards on the lower side
+					const uint32_t quad[4] = {getVertex(a), getVertex(b), getVertex(c), getVertex(d)};
+					mesh.triangles.insert(mesh.triangles.end(), {quad[0], quad[1], quad[2], quad[0], quad[2], quad[3]});
+				}
+			}
+		}
+	}
+	return mesh;
+}
+
+/**
+ * Open planar grid of n x n quads in the xy plane, all vertices on its border are locked.
+ */
+Mesh createGrid(int n) {
+	Mesh mesh;
+	for (int j = 0; j <= n; j++) {
+		for (int i = 0; i <= n; i++)
+			mesh.vertexCoords.insert(mesh.vertexCoords.end(), {static_cast<double>(i), static_cast<double>(j), 0.0});
+	}
+	for (int j = 0; j < n; j++) {
+		for (int i = 0; i < n; i++) {
+			const uint32_t a = static_cast<uint32_t>(j * (n + 1) + i);
+			const uint32_t b = a + 1;
+			const uint32_t c = a + static_cast<uint32_t>(n) + 2;
+			const uint32_t d = a + static_cast<uint32_t>(n) + 1;
+			mesh.triangles.insert(mesh.triangles.end(), {a, b, c, a, c, d});
+		}
+	}
+	return mesh;
+}
+
+std::vector<double> getAreaVector(const Mesh& mesh, size_t triangle) {
+	const double* a = &mesh.vertexCoords[3 * static_cast<size_t>(mesh.triangles[triangle])];
+	const double* b = &mesh.vertexCoords[3 * static_cast<size_t>(mesh.triangles[triangle + 1])];
+	const double* c = &mesh.vertexCoords[3 * static_cast<size_t>(mesh.triangles[triangle + 2])];
+	const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	const double ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+	return {0.5 * (ab[1] * ac[2] - ab[2] * ac[1]), 0.5 * (ab[2] * ac[0] - ab[0] * ac[2]),
+	        0.5 * (ab[0] * ac[1] - ab[1] * ac[0])};
+}
+
+/**
+ * Checks that the triangles reference existing vertices and that none of them collapsed to an edge or a point.
+ */
+void checkTriangles(const Mesh& mesh) {
+	CHECK(mesh.triangles.size() % 3 == 0);
+	for (size_t t = 0; t + 2 < mesh.triangles.size(); t += 3) {
+		const uint32_t a = mesh.triangles[t];
+		const uint32_t b = mesh.triangles[t + 1];
+		const uint32_t c = mesh.triangles[t + 2];
+		CHECK(a < mesh.getVertexCount() && b < mesh.getVertexCount() && c < mesh.getVertexCount());
+		if (a >= mesh.getVertexCount() || b >= mesh.getVertexCount() || c >= mesh.getVertexCount())
+			return;
+		CHECK(a != b && b != c && c != a);
+	}
+}
+
+} // namespace
+
+TEST_CASE(decimatorReachesTargetTriangleCount) {
+	Mesh cube = createCube(8);
+	const size_t inputTriangleCount = cube.triangles.size() / 3;
+	CHECK(inputTriangleCount == 6 * 8 * 8 * 2);
+
+	Decimation::MeshDecimator decimator;
+	const size_t targetTriangleCount = inputTriangleCount / 4;
+	decimator.decimate(cube.vertexCoords.data(), cube.getVertexCount(), cube.triangles, targetTriangleCount, 0.0);
+
+	CHECK(cube.triangles.size() / 3 <= targetTriangleCount);
+	CHECK(cube.triangles.size() / 3 >= 12); // a cube needs 12 triangles
+	CHECK(decimator.getInputTriangleCount() == inputTriangleCount);
+	CHECK(decimator.getOutputTriangleCount() == cube.triangles.size() / 3);
+	checkTriangles(cube);
+}
+
+TEST_CASE(decimatorKeepsMeshesBelowTargetTriangleCount) {
+	Mesh cube = createCube(2);
+	const std::vector<uint32_t> inputTriangles = cube.triangles;
+
+	Decimation::MeshDecimator decimator;
+	decimator.decimate(cube.vertexCoords.data(), cube.getVertexCount(), cube.triangles, inputTriangles.size() / 3,
+	                   0.0);
+
+	CHECK(cube.triangles == inputTriangles);
+	CHECK(decimator.getOutputTriangleCount() == decimator.getInputTriangleCount());
+}
+
+TEST_CASE(decimatorStopsAtMaxError) {
+	// a bump on a flat grid: the flat vertices go for free, removing the bump moves the surface by about its height
+	const int n = 6;
+	const size_t bump = static_cast<size_t>((n / 2) * (n + 1) + n / 2);
+	auto decimateBumpedGrid = [&](double maxError) {
+		Mesh grid = createGrid(n);
+		grid.vertexCoords[3 * bump + 2] = 0.1;
+		Decimation::MeshDecimator decimator;
+		decimator.decimate(grid.vertexCoords.data(), grid.getVertexCount(), grid.triangles, 0, maxError);
+		checkTriangles(grid);
+		return grid;
+	};
+
+	const Mesh bounded = decimateBumpedGrid(0.01);
+	CHECK(bounded.triangles.size() / 3 < static_cast<size_t>(2 * n * n));
+	CHECK(std::find(bounded.triangles.begin(), bounded.triangles.end(), bump) != bounded.triangles.end());
+
+	const Mesh unbounded = decimateBumpedGrid(0.0);
+	CHECK(unbounded.triangles.size() < bounded.triangles.size());
+	CHECK(std::find(unbounded.triangles.begin(), unbounded.triangles.end(), bump) == unbounded.triangles.end());
+}
+
+TEST_CASE(decimatorLocksBorderVertices) {
+	const int n = 6;
+	Mesh grid = createGrid(n);
+
+	Decimation::MeshDecimator decimator;
+	decimator.decimate(grid.vertexCoords.data(), grid.getVertexCount(), grid.triangles, 0, 0.0);
+	checkTriangles(grid);
+
+	// only the interior vertices can go, the border keeps its 4 * n vertices and the grid its area and winding
+	std::vector<bool> used(grid.getVertexCount(), false);
+	for (uint32_t vi : grid.triangles)
+		used[vi] = true;
+	for (int j = 0; j <= n; j++) {
+		for (int i = 0; i <= n; i++) {
+			const bool isBorder = i == 0 || j == 0 || i == n || j == n;
+			if (isBorder)
+				CHECK(used[static_cast<size_t>(j * (n + 1) + i)]);
+		}
+	}
+	CHECK(grid.triangles.size() / 3 < static_cast<size_t>(2 * n * n));
+	CHECK(grid.triangles.size() / 3 >= static_cast<size_t>(4 * n - 2));
+
+	double area = 0.0;
+	for (size_t t = 0; t + 2 < grid.triangles.size(); t += 3) {
+		const std::vector<double> triangleArea = getAreaVector(grid, t);
+		CHECK(triangleArea[2] > 0.0);
+		area += triangleArea[2];
+	}
+	CHECK_NEAR(area, static_cast<double>(n * n), 1e-9);
+}
@@ -0,0 +1,128 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include "GenerationHistory.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+const std::wstring START_RULE = L"Default$Lot";
+
+} // namespace
+
+TEST_CASE(historySavesAndLoadsTimings) {
+	const testing::TempDir tempDir;
+	const std::filesystem::path historyPath = tempDir.getPath() / "generation_history" / "history.txt";
+	{
+		GenerationHistory history(L"test.rpk", historyPath);
+		history.setSecondsPerCost(START_RULE, 0.125);
+		history.setShapeSeconds(START_RULE, 0xfedcba9876543210, 1.5);
+		history.setShapeSeconds(START_RULE, 42, 0.25);
+		history.setShapeSeconds(L"Default$Street", 42, 3.0);
+		history.save();
+	}
+	CHECK(std::filesystem::exists(historyPath));
+
+	const GenerationHistory history(L"test.rpk", historyPath);
+	CHECK(history.getRulePackage() == L"test.rpk");
+	CHECK_NEAR(history.getSecondsPerCost(START_RULE).value_or(0.0), 0.125, 1e-12);
+	CHECK_NEAR(history.getShapeSeconds(START_RULE, 0xfedcba9876543210).value_or(0.0), 1.5, 1e-12);
+	CHECK_NEAR(history.getShapeSeconds(START_RULE, 42).value_or(0.0), 0.25, 1e-12);
+	CHECK_NEAR(history.getShapeSeconds(L"Default$Street", 42).value_or(0.0), 3.0, 1e-12);
+	CHECK(!history.getSecondsPerCost(L"Default$Street").has_value());
+	CHECK(!history.getShapeSeconds(START_RULE, 43).has_value());
+}
+
+TEST_CASE(historyKeepsNonAsciiStartRules) {
+	const testing::TempDir tempDir;
+	const std::filesystem::path historyPath = tempDir.getPath() / "history.txt";
+	const std::wstring startRule = L"Geb\u00e4ude$Grundst\u00fcck";
+	{
+		GenerationHistory history(L"test.rpk", historyPath);
+		history.setSecondsPerCost(startRule, 2.0);
+	}
+
+	const GenerationHistory history(L"test.rpk", historyPath);
+	CHECK_NEAR(history.getSecondsPerCost(startRule).value_or(0.0), 2.0, 1e-12);
+}
+
+TEST_CASE(historySavesPendingChangesOnDestruction) {
+	const testing::TempDir tempDir;
+	const std::filesystem::path historyPath = tempDir.getPath() / "history.txt";
+	{
+		GenerationHistory history(L"test.rpk", historyPath);
+		history.setShapeSeconds(START_RULE, 7, 0.5);
+
+		// the first deferred save waits for the save interval
+		history.saveDeferred();
+		CHECK(!std::filesystem::exists(historyPath));
+	}
+
+	const GenerationHistory history(L"test.rpk", historyPath);
+	CHECK_NEAR(history.getShapeSeconds(START_RULE, 7).value_or(0.0), 0.5, 1e-12);
+}
+
+TEST_CASE(historyDoesNotWriteUnmodifiedTimings) {
+	const testing::TempDir tempDir;
+	const std::filesystem::path historyPath = tempDir.getPath() / "history.txt";
+	{
+		GenerationHistory history(L"test.rpk", historyPath);
+		history.save();
+	}
+	CHECK(!std::filesystem::exists(historyPath));
+}
+
+TEST_CASE(historyIgnoresUnknownFormat) {
+	const testing::TempDir tempDir;
+	const std::filesystem::path historyPath = tempDir.getPath() / "history.txt";
+	{
+		std::ofstream stream(historyPath);
+		stream << "cityengine_for_rhino_generation_history 999\n";
+		stream << "C\tDefault$Lot\t0.5\n";
+	}
+
+	const GenerationHistory history(L"test.rpk", historyPath);
+	CHECK(!history.getSecondsPerCost(START_RULE).has_value());
+}
+
+TEST_CASE(historyLimitsShapeEntries) {
+	const testing::TempDir tempDir;
+	GenerationHistory history(L"test.rpk", tempDir.getPath() / "history.txt");
+
+	constexpr uint64_t MAX_SHAPE_ENTRIES_PER_RULE = 100000;
+	for (uint64_t key = 0; key < MAX_SHAPE_ENTRIES_PER_RULE; key++)
+		history.setShapeSeconds(START_RULE, key, 1.0);
+	history.setSecondsPerCost(START_RULE, 0.5);
+
+	// updating a known shape keeps the entries
+	history.setShapeSeconds(START_RULE, 0, 2.0);
+	CHECK(history.getShapeSeconds(START_RULE, MAX_SHAPE_ENTRIES_PER_RULE - 1).has_value());
+
+	// a new shape beyond the limit starts over, but keeps the calibration
+	history.setShapeSeconds(START_RULE, MAX_SHAPE_ENTRIES_PER_RULE, 3.0);
+	CHECK(!history.getShapeSeconds(START_RULE, 0).has_value());
+	CHECK_NEAR(history.getShapeSeconds(START_RULE, MAX_SHAPE_ENTRIES_PER_RULE).value_or(0.0), 3.0, 1e-12);
+	CHECK_NEAR(history.getSecondsPerCost(START_RULE).value_or(0.0), 0.5, 1e-12);
+}
@@ -0,0 +1,87 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include "LocalCoordinates.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST_CASE(centroidIsMeanOfVertices) {
+	LocalCoordinates::CentroidBuilder centroidBuilder;
+	std::array<double, 3> centroid{};
+	CHECK(!centroidBuilder.build(centroid));
+
+	const std::vector<double> first = {0.0, 0.0, 0.0, 2.0, 0.0, 0.0};
+	const std::vector<double> second = {0.0, 4.0, 0.0, 2.0, 4.0, 8.0};
+	centroidBuilder.add(first.data(), first.size() / 3);
+	centroidBuilder.add(second.data(), second.size() / 3);
+	CHECK(centroidBuilder.build(centroid));
+	CHECK_NEAR(centroid[0], 1.0, 1e-12);
+	CHECK_NEAR(centroid[1], 2.0, 1e-12);
+	CHECK_NEAR(centroid[2], 2.0, 1e-12);
+}
+
+/**
+ * Round trip of 20M coordinates of shapes up to 1e7 from the world origin. As in the encoder, the local origin is the
+ * centroid of the generated vertices of a shape, not the centroid of its initial shape: the model may extend far beyond
+ * the initial shape, the offsets are only small relative to where the geometry actually is.
+ */
+TEST_CASE(localCoordinatesStayWithinErrorBound) {
+	constexpr size_t SHAPE_COUNT = 10000;
+	constexpr size_t VERTEX_COUNT = 667; // 3 * 667 * 10000 = 20M coordinates
+	constexpr double MAX_WORLD_DISTANCE = 1e7;
+	constexpr double MAX_SHAPE_EXTENT = 1e3;
+
+	std::mt19937_64 random(42);
+	std::uniform_real_distribution<double> worldCoordinate(-MAX_WORLD_DISTANCE, MAX_WORLD_DISTANCE);
+	std::uniform_real_distribution<double> shapeOffset(0.0, MAX_SHAPE_EXTENT);
+
+	std::vector<double> vertexCoords(3 * VERTEX_COUNT);
+	size_t violations = 0;
+	double maxError = 0.0;
+	for (size_t si = 0; si < SHAPE_COUNT; si++) {
+		const std::array<double, 3> position = {worldCoordinate(random), worldCoordinate(random),
+		                                        worldCoordinate(random)};
+		for (size_t i = 0; i < vertexCoords.size(); i++)
+			vertexCoords[i] = position[i % 3] + shapeOffset(random);
+
+		LocalCoordinates::CentroidBuilder centroidBuilder;
+		centroidBuilder.add(vertexCoords.data(), VERTEX_COUNT);
+		std::array<double, 3> origin{};
+		centroidBuilder.build(origin);
+
+		for (size_t i = 0; i < vertexCoords.size(); i++) {
+			const float local = LocalCoordinates::toLocalCoordinate(vertexCoords[i], origin[i % 3]);
+			const double restored = LocalCoordinates::fromLocalCoordinate(local, origin[i % 3]);
+			const double error = std::abs(restored - vertexCoords[i]);
+			if (error > LocalCoordinates::getRoundTripErrorBound(vertexCoords[i], origin[i % 3]))
+				violations++;
+			maxError = std::max(maxError, error);
+		}
+	}
+	CHECK(violations == 0);
+
+	// half a float ulp of the shape extent, while float world coordinates would be off by up to 0.5 at 1e7
+	CHECK(maxError < 1e-4);
+}
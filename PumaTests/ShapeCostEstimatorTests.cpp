@@ -0,0 +1,180 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include "GenerationHistory.h"
+#include "ShapeCostEstimator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::wstring START_RULE = L"Default$Lot";
+
+struct Shape {
+	std::vector<double> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> faceCounts;
+
+	double getArea() const {
+		return ShapeCostEstimator::getArea(vertices.data(), vertices.size(), indices.data(), faceCounts.data(),
+		                                   faceCounts.size());
+	}
+
+	double getFeatureCost() const {
+		return ShapeCostEstimator::getFeatureCost(vertices.data(), vertices.size(), indices.data(), faceCounts.data(),
+		                                          faceCounts.size());
+	}
+};
+
+// rectangle in the ground plane (y is up)
+Shape createLot(double width, double depth) {
+	return {{0.0, 0.0, 0.0, width, 0.0, 0.0, width, 0.0, depth, 0.0, 0.0, depth}, {0, 1, 2, 3}, {4}};
+}
+
+ShapeCostEstimator::ChunkTiming createChunkTiming(std::vector<size_t> shapeIndices, double seconds) {
+	ShapeCostEstimator::ChunkTiming chunkTiming;
+	chunkTiming.shapeIndices = std::move(shapeIndices);
+	chunkTiming.seconds = seconds;
+	return chunkTiming;
+}
+
+} // namespace
+
+TEST_CASE(getAreaOfRectangle) {
+	CHECK_NEAR(createLot(2.0, 3.0).getArea(), 6.0, 1e-12);
+}
+
+TEST_CASE(getAreaOfConcaveAndNonPlanarFaces) {
+	// an L-shaped face in the ground plane and a vertical triangle
+	const Shape shape = {{0.0, 0.0, 0.0, 2.0, 0.0, 0.0, 2.0, 0.0, 1.0, 1.0, 0.0, 1.0, 1.0, 0.0, 2.0, 0.0, 0.0, 2.0,
+	                      0.0, 1.0, 0.0},
+	                     {0, 1, 2, 3, 4, 5, 0, 1, 6},
+	                     {6, 3}};
+	CHECK_NEAR(shape.getArea(), 3.0 + 1.0, 1e-12);
+}
+
+TEST_CASE(getAreaIgnoresInvalidIndices) {
+	const Shape shape = {{0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 1.0, 0.0, 1.0}, {0, 1, 2, 0, 1, 99}, {3, 3}};
+	CHECK(std::isfinite(shape.getArea()));
+	CHECK(shape.getArea() >= 0.5);
+}
+
+TEST_CASE(featureCostGrowsWithGeometry) {
+	const Shape smallLot = createLot(10.0, 10.0);
+	const Shape largeLot = createLot(100.0, 100.0);
+	CHECK(smallLot.getFeatureCost() > 0.0);
+	CHECK(largeLot.getFeatureCost() > smallLot.getFeatureCost());
+
+	// same area, but split into two faces with more vertices
+	const Shape splitLot = {{0.0, 0.0, 0.0, 5.0, 0.0, 0.0, 5.0, 0.0, 10.0, 0.0, 0.0, 10.0, 10.0, 0.0, 0.0, 10.0, 0.0,
+	                         10.0},
+	                        {0, 1, 2, 3, 1, 4, 5, 2},
+	                        {4, 4}};
+	CHECK_NEAR(splitLot.getArea(), smallLot.getArea(), 1e-12);
+	CHECK(splitLot.getFeatureCost() > smallLot.getFeatureCost());
+}
+
+TEST_CASE(estimateWithoutHistoryIsFeatureCost) {
+	const testing::TempDir tempDir;
+	GenerationHistory history(L"test.rpk", tempDir.getPath() / "history.txt");
+	const ShapeCostEstimator estimator(history, START_RULE);
+	CHECK_NEAR(estimator.estimate(1, 5.0), 5.0, 1e-12);
+	CHECK_NEAR(estimator.estimate(2, 7.0), 7.0, 1e-12);
+}
+
+TEST_CASE(updateRecordsSingleShapeChunksOnly) {
+	const testing::TempDir tempDir;
+	GenerationHistory history(L"test.rpk", tempDir.getPath() / "history.txt");
+	ShapeCostEstimator estimator(history, START_RULE);
+
+	const std::vector<uint64_t> shapeKeys = {11, 12, 13};
+	const std::vector<double> featureCosts = {1.0, 1.0, 1.0};
+	estimator.update(shapeKeys, featureCosts, {createChunkTiming({0}, 2.0), createChunkTiming({1, 2}, 1.0)});
+
+	// the time of the second chunk cannot be attributed to its shapes
+	CHECK(history.getShapeSeconds(START_RULE, 11).has_value());
+	CHECK(!history.getShapeSeconds(START_RULE, 12).has_value());
+	CHECK(!history.getShapeSeconds(START_RULE, 13).has_value());
+	CHECK_NEAR(history.getSecondsPerCost(START_RULE).value_or(0.0), 3.0 / 3.0, 1e-12);
+
+	CHECK_NEAR(estimator.estimate(11, 1.0), 2.0, 1e-12);
+	CHECK_NEAR(estimator.estimate(12, 1.0), 1.0, 1e-12);
+	CHECK_NEAR(estimator.estimate(99, 4.0), 4.0, 1e-12);
+}
+
+TEST_CASE(updateSmoothesCalibration) {
+	const testing::TempDir tempDir;
+	GenerationHistory history(L"test.rpk", tempDir.getPath() / "history.txt");
+	ShapeCostEstimator estimator(history, START_RULE);
+
+	const std::vector<uint64_t> shapeKeys = {11, 12};
+	const std::vector<double> featureCosts = {1.0, 1.0};
+	estimator.update(shapeKeys, featureCosts, {createChunkTiming({0, 1}, 2.0)});
+	CHECK_NEAR(history.getSecondsPerCost(START_RULE).value_or(0.0), 1.0, 1e-12);
+
+	// exponential moving average with a weight of 0.3 for the newest batch
+	estimator.update(shapeKeys, featureCosts, {createChunkTiming({0, 1}, 4.0)});
+	CHECK_NEAR(history.getSecondsPerCost(START_RULE).value_or(0.0), 0.7 * 1.0 + 0.3 * 2.0, 1e-12);
+}
+
+TEST_CASE(updateMarksShapesOfOutlierChunks) {
+	const testing::TempDir tempDir;
+	GenerationHistory history(L"test.rpk", tempDir.getPath() / "history.txt");
+	ShapeCostEstimator estimator(history, START_RULE);
+
+	// ten regular chunks of two shapes and one chunk which takes much longer than its feature cost suggests
+	std::vector<uint64_t> shapeKeys;
+	std::vector<ShapeCostEstimator::ChunkTiming> chunkTimings;
+	for (size_t ci = 0; ci < 11; ci++) {
+		shapeKeys.push_back(100 + 2 * ci);
+		shapeKeys.push_back(101 + 2 * ci);
+		chunkTimings.push_back(createChunkTiming({2 * ci, 2 * ci + 1}, (ci == 10) ? 100.0 : 2.0));
+	}
+	const std::vector<double> featureCosts(shapeKeys.size(), 1.0);
+
+	// one shape of the outlier chunk has already been measured individually
+	history.setShapeSeconds(START_RULE, 121, 0.5);
+
+	estimator.update(shapeKeys, featureCosts, chunkTimings);
+
+	for (size_t si = 0; si < 20; si++)
+		CHECK(!history.getShapeSeconds(START_RULE, shapeKeys[si]).has_value());
+
+	// the chunk time is an upper bound of the unmeasured shape, it moves the shape to the front of the next batch
+	CHECK_NEAR(history.getShapeSeconds(START_RULE, 120).value_or(0.0), 100.0, 1e-12);
+	CHECK_NEAR(history.getShapeSeconds(START_RULE, 121).value_or(0.0), 0.5, 1e-12);
+	CHECK(estimator.estimate(120, 1.0) > 8.0 * estimator.estimate(100, 1.0));
+}
+
+TEST_CASE(updateIgnoresFailedChunks) {
+	const testing::TempDir tempDir;
+	GenerationHistory history(L"test.rpk", tempDir.getPath() / "history.txt");
+	ShapeCostEstimator estimator(history, START_RULE);
+
+	estimator.update({11, 12}, {1.0, 1.0}, {createChunkTiming({0}, 0.0), createChunkTiming({}, 1.0)});
+	CHECK(!history.getSecondsPerCost(START_RULE).has_value());
+	CHECK(!history.getShapeSeconds(START_RULE, 11).has_value());
+
+	estimator.update({11, 12}, {1.0, 1.0}, {});
+	CHECK(!history.getSecondsPerCost(START_RULE).has_value());
+}
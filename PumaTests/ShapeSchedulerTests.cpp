@@ -0,0 +1,105 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include "ShapeScheduler.h"
+
+#include <vector>
+
+namespace {
+
+// fetches all chunks of a single worker, i.e. the worker gets its own chunks first and then steals the others
+std::vector<ShapeScheduler::Chunk> getAllChunks(ShapeScheduler& scheduler) {
+	std::vector<ShapeScheduler::Chunk> chunks;
+	ShapeScheduler::Chunk chunk;
+	while (scheduler.next(0, chunk))
+		chunks.push_back(chunk);
+	return chunks;
+}
+
+bool coversAllShapesOnce(const std::vector<ShapeScheduler::Chunk>& chunks, size_t shapeCount) {
+	std::vector<size_t> shapeVisits(shapeCount, 0);
+	for (const ShapeScheduler::Chunk& chunk : chunks) {
+		for (size_t si = chunk.offset; si < chunk.offset + chunk.count; si++) {
+			if (si >= shapeCount)
+				return false;
+			shapeVisits[si]++;
+		}
+	}
+	for (size_t visits : shapeVisits) {
+		if (visits != 1)
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+TEST_CASE(schedulerCoversAllShapes) {
+	for (size_t shapeCount : {1, 7, 100, 10000}) {
+		for (size_t workerCount : {1, 3, 16}) {
+			ShapeScheduler blocks(shapeCount, workerCount);
+			CHECK(coversAllShapesOnce(getAllChunks(blocks), shapeCount));
+
+			ShapeScheduler roundRobin(shapeCount, workerCount, ShapeScheduler::Distribution::ROUND_ROBIN);
+			CHECK(coversAllShapesOnce(getAllChunks(roundRobin), shapeCount));
+		}
+	}
+}
+
+TEST_CASE(schedulerDealsSingleShapeChunksFirst) {
+	constexpr size_t SHAPE_COUNT = 1000;
+	constexpr size_t WORKER_COUNT = 4;
+	constexpr size_t SINGLE_SHAPE_COUNT = 10;
+	ShapeScheduler scheduler(SHAPE_COUNT, WORKER_COUNT, ShapeScheduler::Distribution::ROUND_ROBIN, SINGLE_SHAPE_COUNT);
+	CHECK(scheduler.getChunkSize() > 1);
+
+	// round robin: the first chunks of the workers are the single shape chunks in order
+	for (size_t round = 0; round < 2; round++) {
+		for (size_t wi = 0; wi < WORKER_COUNT; wi++) {
+			ShapeScheduler::Chunk chunk;
+			CHECK(scheduler.next(wi, chunk));
+			CHECK(chunk.offset == round * WORKER_COUNT + wi);
+			CHECK(chunk.count == 1);
+			CHECK(!chunk.stolen);
+		}
+	}
+
+	std::vector<ShapeScheduler::Chunk> chunks = getAllChunks(scheduler);
+	size_t singleShapeChunkCount = 0;
+	for (const ShapeScheduler::Chunk& chunk : chunks) {
+		if (chunk.offset < SINGLE_SHAPE_COUNT) {
+			CHECK(chunk.count == 1);
+			singleShapeChunkCount++;
+		}
+	}
+	CHECK(singleShapeChunkCount == SINGLE_SHAPE_COUNT - 2 * WORKER_COUNT);
+
+	for (size_t offset = 0; offset < 2 * WORKER_COUNT; offset++)
+		chunks.push_back({offset, 1, false});
+	CHECK(coversAllShapesOnce(chunks, SHAPE_COUNT));
+}
+
+TEST_CASE(schedulerLimitsSingleShapeChunksToShapeCount) {
+	ShapeScheduler scheduler(5, 2, ShapeScheduler::Distribution::BLOCKS, 10);
+	const std::vector<ShapeScheduler::Chunk> chunks = getAllChunks(scheduler);
+	CHECK(chunks.size() == 5);
+	CHECK(coversAllShapesOnce(chunks, 5));
+}
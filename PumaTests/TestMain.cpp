@@ -0,0 +1,80 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <system_error>
+
+namespace {
+
+size_t failureCount = 0;
+
+} // namespace
+
+namespace testing {
+
+std::vector<TestCase>& getTestCases() {
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+void reportFailure(const char* file, int line, const std::string& message) {
+	std::cerr << file << "(" << line << "): check failed: " << message << std::endl;
+	failureCount++;
+}
+
+TempDir::TempDir() {
+	static size_t dirCount = 0;
+	const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+	mPath = std::filesystem::temp_directory_path() /
+	        ("cityengine_for_rhino_tests_" + std::to_string(now) + "_" + std::to_string(dirCount++));
+	std::filesystem::create_directories(mPath);
+}
+
+TempDir::~TempDir() {
+	std::error_code ec;
+	std::filesystem::remove_all(mPath, ec);
+}
+
+} // namespace testing
+
+int main() {
+	size_t failedTestCount = 0;
+	for (const testing::TestCase& testCase : testing::getTestCases()) {
+		const size_t previousFailureCount = failureCount;
+		try {
+			testCase.function();
+		}
+		catch (std::exception& e) {
+			testing::reportFailure(testCase.name, 0, std::string("unexpected exception: ") + e.what());
+		}
+
+		const bool passed = (failureCount == previousFailureCount);
+		std::cout << (passed ? "[PASS] " : "[FAIL] ") << testCase.name << std::endl;
+		if (!passed)
+			failedTestCount++;
+	}
+
+	std::cout << testing::getTestCases().size() - failedTestCount << " of " << testing::getTestCases().size()
+	          << " test cases passed" << std::endl;
+	return (failedTestCount == 0) ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal test registry: each TEST_CASE registers itself before main runs, the test executable runs all of them and
+ * fails if any check failed. Checks do not abort the test case, so one run reports all failures.
+ */
+namespace testing {
+
+struct TestCase {
+	const char* name;
+	void (*function)();
+};
+
+std::vector<TestCase>& getTestCases();
+void reportFailure(const char* file, int line, const std::string& message);
+
+struct Registrar {
+	Registrar(const char* name, void (*function)()) {
+		getTestCases().push_back({name, function});
+	}
+};
+
+/**
+ * Empty directory below the system temp dir, removed again with all its content on destruction.
+ */
+class TempDir {
+public:
+	TempDir();
+	TempDir(const TempDir&) = delete;
+	TempDir& operator=(const TempDir&) = delete;
+	~TempDir();
+
+	const std::filesystem::path& getPath() const {
+		return mPath;
+	}
+
+private:
+	std::filesystem::path mPath;
+};
+
+} // namespace testing
+
+#define TEST_CASE(NAME)                                                                                                \
+	static void NAME();                                                                                                \
+	static const testing::Registrar NAME##_registrar(#NAME, &NAME);                                                    \
+	static void NAME()
+
+#define CHECK(CONDITION)                                                                                               \
+	do {                                                                                                               \
+		if (!(CONDITION))                                                                                              \
+			testing::reportFailure(__FILE__, __LINE__, #CONDITION);                                                    \
+	} while (false)
+
+#define CHECK_NEAR(ACTUAL, EXPECTED, TOLERANCE)                                                                        \
+	do {                                                                                                               \
+		const double actual_ = (ACTUAL);                                                                               \
+		const double expected_ = (EXPECTED);                                                                           \
+		if (!(std::abs(actual_ - expected_) <= (TOLERANCE))) {                                                         \
+			std::ostringstream message_;                                                                               \
+			message_ << #ACTUAL << " == " << actual_ << ", expected " << expected_ << " +/- " << (TOLERANCE);          \
+			testing::reportFailure(__FILE__, __LINE__, message_.str());                                                \
+		}                                                                                                              \
+	} while (false)
@@ -0,0 +1,160 @@
+/**
+ * ArcGIS CityEngine for Rhino
+ *
+ * See https://esri.github.io/cityengine/rhino for documentation.
+ *
+ * Copyright (c) 2021-2025 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * https://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Testing.h"
+
+#include "Triangulation.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+struct Polygon {
+	std::vector<double> vertexCoords;
+	std::vector<uint32_t> corners;
+};
+
+// area vector of the triangle, its direction follows the winding
+std::vector<double> getAreaVector(const double* a, const double* b, const double* c) {
+	const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	const double ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+	return {0.5 * (ab[1] * ac[2] - ab[2] * ac[1]), 0.5 * (ab[2] * ac[0] - ab[0] * ac[2]),
+	        0.5 * (ab[0] * ac[1] - ab[1] * ac[0])};
+}
+
+std::vector<double> getPolygonAreaVector(const Polygon& polygon) {
+	std::vector<double> area = {0.0, 0.0, 0.0};
+	const double* first = &polygon.vertexCoords[3 * polygon.corners[0]];
+	for (size_t i = 1; i + 1 < polygon.corners.size(); i++) {
+		const std::vector<double> fan = getAreaVector(first, &polygon.vertexCoords[3 * polygon.corners[i]],
+		                                              &polygon.vertexCoords[3 * polygon.corners[i + 1]]);
+		for (size_t k = 0; k < 3; k++)
+			area[k] += fan[k];
+	}
+	return area;
+}
+
+double dot(const std::vector<double>& a, const std::vector<double>& b) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/**
+ * Checks that the triangles tile the polygon: they use valid corner offsets, keep the winding of the polygon and their
+ * areas add up to the polygon area, which fails as soon as a triangle covers a notch of a concave polygon.
+ */
+void checkTiling(const Polygon& polygon, const std::vector<uint32_t>& triangles) {
+	const uint32_t cornerCount = static_cast<uint32_t>(polygon.corners.size());
+	CHECK(triangles.size() == 3 * static_cast<size_t>(cornerCount - 2));
+
+	const std::vector<double> polygonArea = getPolygonAreaVector(polygon);
+	const double polygonAreaSquared = dot(polygonArea, polygonArea);
+	double areaSum = 0.0;
+	for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+		CHECK(triangles[t] < cornerCount && triangles[t + 1] < cornerCount && triangles[t + 2] < cornerCount);
+		if (triangles[t] >= cornerCount || triangles[t + 1] >= cornerCount || triangles[t + 2] >= cornerCount)
+			return;
+
+		auto corner = [&](size_t offset) { return &polygon.vertexCoords[3 * polygon.corners[triangles[offset]]]; };
+		const std::vector<double> area = getAreaVector(corner(t), corner(t + 1), corner(t + 2));
+		const double projectedArea = dot(area, polygonArea) / std::sqrt(polygonAreaSquared);
+		CHECK(projectedArea > 0.0);
+		areaSum += projectedArea;
+	}
+	CHECK_NEAR(areaSum, std::sqrt(polygonAreaSquared), 1e-9);
+}
+
+std::vector<uint32_t> triangulate(Triangulation::PolygonTriangulator& triangulator, const Polygon& polygon,
+                                  bool& clipped) {
+	std::vector<uint32_t> triangles(3 * (polygon.corners.size() - 2));
+	clipped = triangulator.triangulate(polygon.vertexCoords.data(), polygon.corners.data(),
+	                                   static_cast<uint32_t>(polygon.corners.size()), triangles.data());
+	return triangles;
+}
+
+} // namespace
+
+TEST_CASE(triangulatorTilesConvexPolygon) {
+	// regular hexagon in the xz plane, counter-clockwise seen from -y
+	Polygon hexagon;
+	for (uint32_t i = 0; i < 6; i++) {
+		const double angle = 2.0 * 3.14159265358979323846 * i / 6.0;
+		hexagon.vertexCoords.insert(hexagon.vertexCoords.end(), {std::cos(angle), 0.0, std::sin(angle)});
+		hexagon.corners.push_back(i);
+	}
+
+	Triangulation::PolygonTriangulator triangulator;
+	bool clipped = false;
+	const std::vector<uint32_t> triangles = triangulate(triangulator, hexagon, clipped);
+	CHECK(clipped);
+	checkTiling(hexagon, triangles);
+	CHECK(triangulator.getPolygonCount() == 1);
+	CHECK(triangulator.getFallbackCount() == 0);
+}
+
+TEST_CASE(triangulatorClipsAroundNotches) {
+	// U shaped facade outline in the xy plane, the notch must not be covered by any triangle
+	const std::vector<double> u = {0, 0, 3, 0, 3, 3, 2, 3, 2, 1, 1, 1, 1, 3, 0, 3};
+
+	for (bool clockwise : {false, true}) {
+		Polygon polygon;
+		for (size_t i = 0; i < u.size(); i += 2)
+			polygon.vertexCoords.insert(polygon.vertexCoords.end(), {u[i], u[i + 1], 5.0});
+		for (uint32_t i = 0; i < 8; i++)
+			polygon.corners.push_back(clockwise ? 7 - i : i);
+
+		Triangulation::PolygonTriangulator triangulator;
+		bool clipped = false;
+		const std::vector<uint32_t> triangles = triangulate(triangulator, polygon, clipped);
+		CHECK(clipped);
+		checkTiling(polygon, triangles);
+	}
+}
+
+TEST_CASE(triangulatorUsesCornerOffsets) {
+	// the corners index a larger vertex buffer in arbitrary order, the triangles refer to positions in the corners
+	Polygon polygon;
+	polygon.vertexCoords = {9, 9, 9, 0, 0, 0, 9, 9, 9, 2, 0, 0, 2, 2, 0, 1, 1, 0, 0, 2, 0};
+	polygon.corners = {1, 3, 4, 5, 6}; // arrow shape, corner 5 is reflex
+
+	Triangulation::PolygonTriangulator triangulator;
+	bool clipped = false;
+	const std::vector<uint32_t> triangles = triangulate(triangulator, polygon, clipped);
+	CHECK(clipped);
+	checkTiling(polygon, triangles);
+}
+
+TEST_CASE(triangulatorFallsBackToFanForDegeneratePolygons) {
+	// all corners on a line: no ear exists, the corners are still covered by a fan
+	Polygon polygon;
+	for (uint32_t i = 0; i < 5; i++) {
+		polygon.vertexCoords.insert(polygon.vertexCoords.end(), {static_cast<double>(i), 0.0, 0.0});
+		polygon.corners.push_back(i);
+	}
+
+	Triangulation::PolygonTriangulator triangulator;
+	bool clipped = true;
+	const std::vector<uint32_t> triangles = triangulate(triangulator, polygon, clipped);
+	CHECK(!clipped);
+	CHECK(triangles.size() == 9);
+	for (uint32_t corner : triangles)
+		CHECK(corner < 5);
+	CHECK(triangulator.getFallbackCount() == 1);
+}